@@ -0,0 +1,91 @@
+#include "AllocStats.h"
+#include "imgui.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> frameCount[ALLOC_TAG_COUNT];
+    std::atomic<uint64_t> frameBytes[ALLOC_TAG_COUNT];
+    std::atomic<int64_t> liveBytes{ 0 };
+    AllocCounters lastFrame[ALLOC_TAG_COUNT];
+    thread_local AllocTag currentTag = ALLOC_OTHER;
+
+    // Every tracked block carries its size in front so frees can be subtracted.
+    constexpr size_t kHeader = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+    void* trackedAlloc(size_t size, AllocTag tag) {
+        unsigned char* raw = static_cast<unsigned char*>(std::malloc(size + kHeader));
+        if (!raw) return nullptr;
+        *reinterpret_cast<size_t*>(raw) = size;
+        frameCount[tag].fetch_add(1, std::memory_order_relaxed);
+        frameBytes[tag].fetch_add(size, std::memory_order_relaxed);
+        liveBytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+        return raw + kHeader;
+    }
+
+    void trackedFree(void* ptr) {
+        if (!ptr) return;
+        unsigned char* raw = static_cast<unsigned char*>(ptr) - kHeader;
+        liveBytes.fetch_sub((int64_t)*reinterpret_cast<size_t*>(raw), std::memory_order_relaxed);
+        std::free(raw);
+    }
+
+    void* imguiAlloc(size_t size, void*) { return trackedAlloc(size, ALLOC_UI); }
+    void imguiFree(void* ptr, void*) { trackedFree(ptr); }
+}
+
+AllocScope::AllocScope(AllocTag tag) : previous(currentTag) { currentTag = tag; }
+AllocScope::~AllocScope() { currentTag = previous; }
+
+void allocStatsBeginFrame() {
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+        lastFrame[i].count = frameCount[i].exchange(0, std::memory_order_relaxed);
+        lastFrame[i].bytes = frameBytes[i].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+AllocCounters allocStatsLastFrame(AllocTag tag) { return lastFrame[tag]; }
+
+AllocCounters allocStatsLastFrameTotal() {
+    AllocCounters total = { 0, 0 };
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+        total.count += lastFrame[i].count;
+        total.bytes += lastFrame[i].bytes;
+    }
+    return total;
+}
+
+int64_t allocStatsLiveBytes() { return liveBytes.load(std::memory_order_relaxed); }
+
+const char* allocTagName(AllocTag tag) {
+    static const char* names[ALLOC_TAG_COUNT] = { "Other", "Input", "Sim", "Render", "UI", "Assets" };
+    return names[tag];
+}
+
+void allocStatsHookImGui() {
+    ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree, nullptr);
+}
+
+#if ENABLE_ALLOC_TRACKING
+// --- Global operator new/delete replacements ---
+// Over-aligned new/delete keep the default implementation; they pair with each other.
+void* operator new(size_t size) {
+    void* p = trackedAlloc(size ? size : 1, currentTag);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) {
+    void* p = trackedAlloc(size ? size : 1, currentTag);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, currentTag); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, currentTag); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { trackedFree(ptr); }
+#endif
@@ -0,0 +1,48 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Global operator new/delete are replaced in AllocStats.cpp so every heap
+// allocation is counted against the subsystem that is active on that thread.
+// Set ENABLE_ALLOC_TRACKING to 0 to build without the hook.
+#ifndef ENABLE_ALLOC_TRACKING
+#define ENABLE_ALLOC_TRACKING 1
+#endif
+
+enum AllocTag {
+    ALLOC_OTHER,
+    ALLOC_INPUT,
+    ALLOC_SIM,
+    ALLOC_RENDER,
+    ALLOC_UI,
+    ALLOC_ASSETS,
+    ALLOC_TAG_COUNT
+};
+
+struct AllocCounters {
+    uint64_t count;
+    uint64_t bytes;
+};
+
+// Marks everything allocated on this thread inside the scope as belonging to tag.
+class AllocScope {
+public:
+    explicit AllocScope(AllocTag tag);
+    ~AllocScope();
+private:
+    AllocTag previous;
+};
+
+// Call once at the top of each frame; publishes the counts of the frame that just ended.
+void allocStatsBeginFrame();
+AllocCounters allocStatsLastFrame(AllocTag tag);
+AllocCounters allocStatsLastFrameTotal();
+int64_t allocStatsLiveBytes();
+const char* allocTagName(AllocTag tag);
+
+// Routes ImGui's heap through the counters (tagged ALLOC_UI). Call before ImGui::CreateContext.
+void allocStatsHookImGui();
+
+#endif
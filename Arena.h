@@ -0,0 +1,129 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Bump allocator for transient data (matrices, draw packets, query results).
+// Allocating is a pointer bump and everything is released at once by reset(),
+// so nothing in here may need a destructor.
+class LinearArena {
+public:
+    explicit LinearArena(size_t capacity) : capacity(capacity) {
+        base = static_cast<unsigned char*>(allocBlock(capacity));
+    }
+    ~LinearArena() {
+        freeOverflow();
+        std::free(base);
+    }
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* alloc(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t start = (offset + (align - 1)) & ~(align - 1);
+        if (start + size <= capacity) {
+            offset = start + size;
+            if (offset > highWater) highWater = offset;
+            return base + start;
+        }
+        // Out of room: chain an overflow block so this frame still works.
+        // reset() grows the main block so the next frame doesn't overflow again.
+        overflowBytes += size + align;
+        OverflowBlock* block = static_cast<OverflowBlock*>(allocBlock(sizeof(OverflowBlock) + size + align));
+        block->next = overflow;
+        overflow = block;
+        uintptr_t p = reinterpret_cast<uintptr_t>(block + 1);
+        p = (p + (align - 1)) & ~(uintptr_t)(align - 1);
+        return reinterpret_cast<void*>(p);
+    }
+
+    // Default-constructs count objects of T. T must be trivially destructible.
+    template <typename T>
+    T* allocArray(size_t count) {
+        T* p = static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) new (&p[i]) T;
+        return p;
+    }
+
+    // Releases everything allocated since the last reset.
+    void reset() {
+        if (overflow) {
+            freeOverflow();
+            size_t grown = capacity + overflowBytes;
+            std::free(base);
+            capacity = grown + grown / 2;
+            base = static_cast<unsigned char*>(allocBlock(capacity));
+            overflowBytes = 0;
+            grows++;
+        }
+        offset = 0;
+    }
+
+    size_t mark() const { return offset; }
+    void rewind(size_t m) {
+        offset = m;
+        if (m == 0 && overflow) reset();
+    }
+
+    size_t used() const { return offset; }
+    size_t size() const { return capacity; }
+    size_t peak() const { return highWater; }
+    int growCount() const { return grows; }
+
+private:
+    struct OverflowBlock { OverflowBlock* next; };
+
+    unsigned char* base = nullptr;
+    size_t capacity = 0;
+    size_t offset = 0;
+    size_t highWater = 0;
+    size_t overflowBytes = 0;
+    OverflowBlock* overflow = nullptr;
+    int grows = 0;
+
+    // Running out of memory here leaves nothing sensible to hand back.
+    static void* allocBlock(size_t bytes) {
+        void* p = std::malloc(bytes);
+        if (!p) {
+            std::fprintf(stderr, "LinearArena: out of memory allocating %zu bytes\n", bytes);
+            std::abort();
+        }
+        return p;
+    }
+
+    void freeOverflow() {
+        while (overflow) {
+            OverflowBlock* next = overflow->next;
+            std::free(overflow);
+            overflow = next;
+        }
+    }
+};
+
+// Rewinds an arena to where it was when the scope was opened.
+// Use this with scratchArena() so nested helpers can share one arena.
+class ArenaScope {
+public:
+    explicit ArenaScope(LinearArena& arena) : arena(arena), start(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+private:
+    LinearArena& arena;
+    size_t start;
+};
+
+// Reset once per frame at the end of the main loop.
+inline LinearArena& frameArena() {
+    static LinearArena arena(4 << 20);
+    return arena;
+}
+
+// One per thread, for short-lived data inside a job. Wrap uses in an ArenaScope.
+inline LinearArena& scratchArena() {
+    thread_local LinearArena arena(1 << 20);
+    return arena;
+}
+
+#endif
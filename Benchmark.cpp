@@ -0,0 +1,444 @@
+#include "Benchmark.h"
+#include "common.h"
+#include "logic.h"
+#include "objModel.h"
+#include "Arena.h"
+#include "AllocStats.h"
+#include "Profiler.h"
+#include "Shapes.h"
+#include "SoftwareRasterizer.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    struct Scenario {
+        const char* name;
+        int defaultCount;
+        bool skyCamera;
+        bool fire;            // shoot at the player's cooldown rate
+        int splashesPerTick;
+        bool emersonRing;     // count is the number of emersons, not chasers
+        bool hitscan;         // fire the hitscan shotgun instead of projectiles
+        bool tessellation;    // count is overlay graph points tessellated per tick
+    };
+
+    const Scenario scenarios[] = {
+        { "chasers",              2000,   false, false, 0,  false, false, false },
+        { "sustained_fire",       200,    false, true,  0,  false, false, false },
+        { "splash_storm",         200,    false, false, 25, false, false, false },
+        { "many_emersons",        100,    false, true,  0,  true,  false, false },
+        { "sky_camera",           1000,   true,  false, 0,  false, false, false },
+        { "pov_camera",           1000,   false, false, 0,  false, false, false },
+        { "hitscan_fire",         2000,   false, true,  0,  false, true,  false },
+        { "overlay_tessellation", 200000, false, false, 0,  false, false, true  },
+    };
+    constexpr int kScenarioCount = sizeof(scenarios) / sizeof(scenarios[0]);
+    constexpr float kFireCooldown = 0.05f; // matches processInput
+
+    float percentile(std::vector<float> v, float p) {
+        if (v.empty()) return 0.0f;
+        size_t k = (size_t)(p * (v.size() - 1) + 0.5f);
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    }
+
+    void printUsage() {
+        std::cerr << "usage: --bench <all|";
+        for (int i = 0; i < kScenarioCount; i++) std::cerr << scenarios[i].name << (i + 1 < kScenarioCount ? "|" : "");
+        std::cerr << "> [--ticks N] [--count N] [--headless [--software-raster]] [--bench-out path] [--baseline file] [--margin 0.15] [--bench-update-baseline]" << std::endl;
+    }
+}
+
+bool parseBenchArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--bench") == 0 && hasValue) {
+            opts.enabled = true;
+            opts.scenario = argv[++i];
+        }
+        else if (strcmp(arg, "--ticks") == 0 && hasValue) opts.ticks = atoi(argv[++i]);
+        else if (strcmp(arg, "--count") == 0 && hasValue) opts.count = atoi(argv[++i]);
+        else if (strcmp(arg, "--bench-out") == 0 && hasValue) opts.outPath = argv[++i];
+        else if (strcmp(arg, "--baseline") == 0 && hasValue) opts.baselinePath = argv[++i];
+        else if (strcmp(arg, "--margin") == 0 && hasValue) opts.margin = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--headless") == 0) opts.headless = true;
+        else if (strcmp(arg, "--software-raster") == 0) opts.software = true;
+        else if (strcmp(arg, "--bench-update-baseline") == 0) opts.updateBaseline = true;
+    }
+    if (!opts.enabled) return true;
+    bool known = opts.scenario == "all";
+    for (int i = 0; i < kScenarioCount; i++) known |= opts.scenario == scenarios[i].name;
+    if (!known || opts.ticks <= 0 || (opts.software && !opts.headless)) {
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+// Overlay graphs like the profiler's, tessellated into a standalone draw
+// list: 256-point polylines through each anti-aliased line path (textured,
+// thin and thick), each with a filled circular marker. Needs no ImGui
+// context; the line texture UVs are dummies since nothing is drawn.
+struct Benchmark::OverlayTessellation {
+    static constexpr int kGraphPoints = 256;
+    static constexpr int kMarkerPoints = 24;
+
+    ImVec4 texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1] = {};
+    ImDrawListSharedData shared;
+    ImDrawList list;
+    std::vector<ImVec2> graph, marker;
+
+    OverlayTessellation() : list(&shared) {
+        shared.TexUvLines = texUvLines;
+        shared.InitialFlags = ImDrawListFlags_AntiAliasedLines | ImDrawListFlags_AntiAliasedLinesUseTex | ImDrawListFlags_AntiAliasedFill | ImDrawListFlags_AllowVtxOffset;
+        shared.InitialFringeScale = 1.0f;
+        shared.SetCircleTessellationMaxError(0.3f);
+        for (int i = 0; i < kGraphPoints; i++) {
+            graph.push_back(ImVec2(i * 2.0f, 100.0f + 40.0f * sinf(i * 0.37f) + (float)(rand() % 20)));
+        }
+        for (int i = 0; i < kMarkerPoints; i++) {
+            float a = -6.2831853f * i / kMarkerPoints; // clockwise, as AddConvexPolyFilled wants
+            marker.push_back(ImVec2(4.0f * cosf(a), 4.0f * sinf(a)));
+        }
+    }
+
+    // Returns the number of vertices written.
+    int run(int points) {
+        static const float thickness[3] = { 1.0f, 1.0f, 1.5f };
+        list._ResetForNewFrame();
+        list.PushClipRectFullScreen();
+        list.PushTextureID(ImTextureID());
+        ImVec2 placed[kMarkerPoints];
+        for (int g = 0; g * kGraphPoints < points; g++) {
+            int path = g % 3;
+            if (path == 1) list.Flags &= ~ImDrawListFlags_AntiAliasedLinesUseTex;
+            else list.Flags |= ImDrawListFlags_AntiAliasedLinesUseTex;
+            list.AddPolyline(graph.data(), kGraphPoints, IM_COL32(255, 200, 0, 255), ImDrawFlags_None, thickness[path]);
+            const ImVec2& last = graph[kGraphPoints - 1];
+            for (int i = 0; i < kMarkerPoints; i++) placed[i] = ImVec2(last.x + marker[i].x, last.y + marker[i].y);
+            list.AddConvexPolyFilled(placed, kMarkerPoints, IM_COL32(255, 80, 80, 255));
+        }
+        return list.VtxBuffer.Size;
+    }
+};
+
+Benchmark::Benchmark(const BenchOptions& opts) : opts(opts) {}
+
+const char* Benchmark::scenarioName() const {
+    return scenarioIndex >= 0 && scenarioIndex < kScenarioCount ? scenarios[scenarioIndex].name : "";
+}
+
+bool Benchmark::nextScenario() {
+    if (scenarioIndex >= 0 && scenarioIndex < kScenarioCount) finishScenario();
+    for (scenarioIndex++; scenarioIndex < kScenarioCount; scenarioIndex++) {
+        if (opts.scenario == "all" || opts.scenario == scenarios[scenarioIndex].name) break;
+    }
+    if (scenarioIndex >= kScenarioCount) return false;
+
+    const Scenario& s = scenarios[scenarioIndex];
+    count = opts.count > 0 ? opts.count : s.defaultCount;
+    resetWorld();
+    usingSkyCamera = s.skyCamera;
+    hitscanWeapon = s.hitscan;
+    if (s.emersonRing) {
+        colliders = 50;
+        emersons.clear();
+        for (int i = 0; i < count; i++) {
+            float angle = i * 6.2831853f / count;
+            float radius = 12.0f + (i % 4) * 6.0f;
+            emers e;
+            e.pos = glm::vec3(cos(angle) * radius, 3.0f, sin(angle) * radius);
+            e.vel = glm::vec3(0.0f);
+            e.height = 3.0f;
+            e.health = 1000.0f;
+            e.id = nextEntityId();
+            emersons.push_back(e);
+        }
+    }
+    else {
+        colliders = count;
+    }
+
+    tick = 0;
+    lastShot = -1.0f;
+    frameMs.clear();
+    simMs.clear();
+    frameMs.reserve(opts.ticks);
+    simMs.reserve(opts.ticks);
+    drawCallSum = 0.0;
+    peakMem = 0;
+    tessNs = 0;
+    tessVertices = 0;
+    rasterNs = 0;
+    rasterTriangles = 0;
+    rasterPixels = 0;
+    if (s.tessellation) {
+        colliders = 50;
+        if (!tessellation) tessellation = std::make_shared<OverlayTessellation>();
+    }
+    std::cout << "bench: " << s.name << " (count " << count << ", " << opts.ticks << " ticks)" << std::endl;
+    return true;
+}
+
+void Benchmark::resetWorld() {
+    srand(1234);
+    cubes.clear();
+    projectiles.clear();
+    splashParticles.clear();
+    splashFlashes.clear();
+    emersons.clear();
+    emers emerson;
+    emerson.pos = glm::vec3(12.0f, 3.0f, 0.0f);
+    emerson.health = 1000.0f;
+    emerson.vel = glm::vec3(0.0f, 0.0f, 0.0f);
+    emerson.height = 3.0f;
+    emerson.id = nextEntityId();
+    emersons.push_back(emerson);
+    resetPlayer();
+    worldTime = 0.0f;
+    isPaused = false;
+}
+
+void Benchmark::beginTick() {
+    const Scenario& s = scenarios[scenarioIndex];
+    deltaTime = kTickSeconds;
+    aimAndFire(s.fire);
+    player& p = players[0];
+    for (int i = 0; i < s.splashesPerTick; i++) {
+        glm::vec3 offset(((rand() % 400) / 10.0f) - 20.0f, (rand() % 60) / 10.0f, ((rand() % 400) / 10.0f) - 20.0f);
+        createSplash(p.pos + offset, glm::vec3(0.7f, 0.9f, 1.0f));
+    }
+    if (s.tessellation) {
+        uint64_t start = profilerNowNs();
+        tessVertices += tessellation->run(count);
+        tessNs += profilerNowNs() - start;
+    }
+}
+
+void Benchmark::aimAndFire(bool fire) {
+    player& p = players[0];
+    const Scenario& s = scenarios[scenarioIndex];
+    // Sweep the view around so the camera sees every part of the arena.
+    p.yaw = fmodf(tick * 1.5f, 360.0f);
+    p.pitch = -5.0f;
+    applyLook(p);
+    cameraPos = p.pos;
+    cameraFront = p.front;
+    if (!fire || worldTime - lastShot < kFireCooldown) return;
+    if (s.emersonRing && !emersons.empty()) {
+        const emers& target = emersons[(tick / 3) % emersons.size()];
+        cameraFront = glm::normalize(target.pos - p.pos);
+    }
+    shoot();
+    totalClicks++;
+    lastShot = worldTime;
+}
+
+void Benchmark::endTick(double frame, double sim, int drawCalls) {
+    frameMs.push_back((float)frame);
+    simMs.push_back((float)sim);
+    drawCallSum += drawCalls;
+    peakMem = std::max(peakMem, (long long)allocStatsLiveBytes());
+    tick++;
+}
+
+void Benchmark::addRaster(uint64_t ns, long long triangles, long long pixels) {
+    rasterNs += ns;
+    rasterTriangles += triangles;
+    rasterPixels += pixels;
+}
+
+void Benchmark::finishScenario() {
+    Result r;
+    r.name = scenarios[scenarioIndex].name;
+    r.mode = opts.headless ? (opts.software ? "software" : "headless") : opts.offscreen ? "offscreen" : "windowed";
+    r.ticks = (int)frameMs.size();
+    r.frameP50 = percentile(frameMs, 0.50f);
+    r.frameP95 = percentile(frameMs, 0.95f);
+    r.frameP99 = percentile(frameMs, 0.99f);
+    r.frameMax = frameMs.empty() ? 0.0f : *std::max_element(frameMs.begin(), frameMs.end());
+    double simSum = 0.0;
+    for (float v : simMs) simSum += v;
+    r.simAvg = simMs.empty() ? 0.0f : (float)(simSum / simMs.size());
+    r.simP99 = percentile(simMs, 0.99f);
+    r.drawCallsAvg = r.ticks ? (float)(drawCallSum / r.ticks) : 0.0f;
+    r.peakMemKb = peakMem / 1024.0f;
+    r.tessMvtxPerSec = tessNs ? (float)(tessVertices * 1e3 / tessNs) : 0.0f;
+    r.rasterMtriPerSec = rasterNs ? (float)(rasterTriangles * 1e3 / rasterNs) : 0.0f;
+    r.rasterMpixPerSec = rasterNs ? (float)(rasterPixels * 1e3 / rasterNs) : 0.0f;
+    results.push_back(r);
+    printf("  frame p50 %.3f p95 %.3f p99 %.3f max %.3f ms | sim avg %.3f p99 %.3f ms | draws %.0f | mem %.0f KB\n",
+        r.frameP50, r.frameP95, r.frameP99, r.frameMax, r.simAvg, r.simP99, r.drawCallsAvg, r.peakMemKb);
+    if (tessVertices) {
+        printf("  tessellation %.1f Mvtx/s (%lld vertices in %.3f ms)\n", r.tessMvtxPerSec, tessVertices, tessNs / 1e6);
+    }
+    if (rasterNs) {
+        printf("  raster %.2f Mtri/s %.1f Mpix/s (%lld triangles, %lld pixels in %.3f ms)\n",
+            r.rasterMtriPerSec, r.rasterMpixPerSec, rasterTriangles, rasterPixels, rasterNs / 1e6);
+    }
+}
+
+int Benchmark::finish() {
+    if (scenarioIndex >= 0 && scenarioIndex < kScenarioCount) {
+        finishScenario();
+        scenarioIndex = kScenarioCount;
+    }
+    writeResults();
+    if (opts.updateBaseline) {
+        writeBaseline();
+        return 0;
+    }
+    return checkBaseline();
+}
+
+void Benchmark::writeResults() const {
+    std::ofstream csv(opts.outPath + ".csv");
+    csv << "scenario,mode,ticks,frame_p50_ms,frame_p95_ms,frame_p99_ms,frame_max_ms,sim_avg_ms,sim_p99_ms,draw_calls_avg,peak_mem_kb,tess_mvtx_per_s,raster_mtri_per_s,raster_mpix_per_s\n";
+    for (const Result& r : results) {
+        csv << r.name << "," << r.mode << "," << r.ticks << "," << r.frameP50 << "," << r.frameP95 << "," << r.frameP99 << ","
+            << r.frameMax << "," << r.simAvg << "," << r.simP99 << "," << r.drawCallsAvg << "," << r.peakMemKb << "," << r.tessMvtxPerSec << ","
+            << r.rasterMtriPerSec << "," << r.rasterMpixPerSec << "\n";
+    }
+
+    std::ofstream json(opts.outPath + ".json");
+    json << "{\"scenarios\":[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        json << "  {\"name\":\"" << r.name << "\",\"mode\":\"" << r.mode << "\",\"ticks\":" << r.ticks
+            << ",\"frame_ms\":{\"p50\":" << r.frameP50 << ",\"p95\":" << r.frameP95 << ",\"p99\":" << r.frameP99 << ",\"max\":" << r.frameMax << "}"
+            << ",\"sim_ms\":{\"avg\":" << r.simAvg << ",\"p99\":" << r.simP99 << "}"
+            << ",\"draw_calls_avg\":" << r.drawCallsAvg << ",\"peak_mem_kb\":" << r.peakMemKb << ",\"tess_mvtx_per_s\":" << r.tessMvtxPerSec
+            << ",\"raster\":{\"mtri_per_s\":" << r.rasterMtriPerSec << ",\"mpix_per_s\":" << r.rasterMpixPerSec << "}}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "]}\n";
+    std::cout << "bench: wrote " << opts.outPath << ".csv and " << opts.outPath << ".json" << std::endl;
+}
+
+// Baseline format, one check per line: scenario,mode,metric,value ('#' starts a comment).
+// Metrics: frame_p99_ms, sim_p99_ms, draw_calls_avg, peak_mem_kb.
+int Benchmark::checkBaseline() const {
+    std::ifstream in(opts.baselinePath);
+    if (!in) {
+        std::cout << "bench: no baseline at " << opts.baselinePath << ", skipping regression check" << std::endl;
+        return 0;
+    }
+    int failures = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        std::string name, mode, metric, value;
+        std::getline(ss, name, ',');
+        std::getline(ss, mode, ',');
+        std::getline(ss, metric, ',');
+        std::getline(ss, value, ',');
+        for (const Result& r : results) {
+            if (r.name != name || r.mode != mode) continue;
+            float measured;
+            if (metric == "frame_p99_ms") measured = r.frameP99;
+            else if (metric == "sim_p99_ms") measured = r.simP99;
+            else if (metric == "draw_calls_avg") measured = r.drawCallsAvg;
+            else if (metric == "peak_mem_kb") measured = r.peakMemKb;
+            else continue;
+            float limit = (float)atof(value.c_str()) * (1.0f + opts.margin);
+            if (measured > limit) {
+                printf("REGRESSION %s/%s %s: %.3f > %.3f (baseline %s + %.0f%%)\n",
+                    name.c_str(), mode.c_str(), metric.c_str(), measured, limit, value.c_str(), opts.margin * 100.0f);
+                failures++;
+            }
+        }
+    }
+    std::cout << "bench: " << (failures ? "FAILED" : "passed") << " baseline check (" << failures << " regressions)" << std::endl;
+    return failures ? 1 : 0;
+}
+
+void Benchmark::writeBaseline() const {
+    std::ofstream out(opts.baselinePath);
+    out << "# Measured by --bench-update-baseline; checked as value * (1 + margin).\n";
+    out << "# scenario,mode,metric,value\n";
+    for (const Result& r : results) {
+        out << r.name << "," << r.mode << ",frame_p99_ms," << r.frameP99 << "\n";
+        out << r.name << "," << r.mode << ",sim_p99_ms," << r.simP99 << "\n";
+        out << r.name << "," << r.mode << ",draw_calls_avg," << r.drawCallsAvg << "\n";
+        out << r.name << "," << r.mode << ",peak_mem_kb," << r.peakMemKb << "\n";
+    }
+    std::cout << "bench: wrote baseline " << opts.baselinePath << std::endl;
+}
+
+int runHeadlessBenchmark(const BenchOptions& opts) {
+    // Only the model bounds (and, for software rendering, the triangles) are
+    // needed, so the models stay CPU-side.
+    objModel emersModel("models/emers.obj", false);
+    objModel pillarModel("models/pillar.obj", false);
+    emersonMinBounds = emersModel.minBounds;
+    emersonMaxBounds = emersModel.maxBounds;
+    emersonBVH = &emersModel.getBVH();
+    pillarBVH = &pillarModel.getBVH();
+    pillarMinBounds = pillarModel.minBounds;
+    pillarMaxBounds = pillarModel.maxBounds;
+    initGame(""); // the fixed default world, never streamed
+
+    // Frames are rendered at a fixed size, so results compare across machines.
+    const int rasterWidth = 640, rasterHeight = 360;
+    std::unique_ptr<SoftwareRasterizer> raster;
+    SoftwareWorldMeshes meshes;
+    if (opts.software) {
+        objModel projectileModel("models/projectile.obj", false);
+        objModel floaterModel("models/floater.obj", false);
+        meshes.cube = SoftwareRasterizer::MeshData::fromArray(Shapes::cubeVertices, sizeof(Shapes::cubeVertices), { 3, 3 });
+        meshes.pillar = SoftwareRasterizer::MeshData::fromModel(pillarModel);
+        meshes.floater = SoftwareRasterizer::MeshData::fromModel(floaterModel);
+        meshes.emerson = SoftwareRasterizer::MeshData::fromModel(emersModel);
+        meshes.projectile = SoftwareRasterizer::MeshData::fromModel(projectileModel);
+        raster = std::make_unique<SoftwareRasterizer>();
+        printf("software raster: %dx%d, %d threads\n", rasterWidth, rasterHeight, raster->threadCount());
+    }
+
+    Benchmark bench(opts);
+    while (bench.nextScenario()) {
+        while (!bench.scenarioDone()) {
+            PROFILE_FRAME();
+            allocStatsBeginFrame();
+            uint64_t start = profilerNowNs();
+            bench.beginTick();
+            worldTime += deltaTime;
+            // Simulation only, as the windowed loop times it; the scripted
+            // input and tessellation above count in the frame time.
+            uint64_t simStart = profilerNowNs();
+            {
+                AllocScope simScope(ALLOC_SIM);
+                updateWorld();
+            }
+            double simMs = (profilerNowNs() - simStart) / 1e6;
+            frameDrawCalls = 0;
+            if (raster) {
+                // The camera as source.cpp sets it up.
+                player& p = players[0];
+                glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)rasterWidth / rasterHeight, 0.1f, 100.0f);
+                glm::mat4 view = (usingSkyCamera) ?
+                    glm::lookAt(p.pos + glm::vec3(0.0f, 30.0f, 0.01f), p.pos, glm::vec3(0.0f, 0.0f, -1.0f)) :
+                    glm::lookAt(p.pos, p.pos + p.front, p.up);
+                uint64_t rasterStart = profilerNowNs();
+                raster->begin(rasterWidth, rasterHeight, glm::vec3(0.02f, 0.02f, 0.05f));
+                rasterizeWorld(*raster, meshes, view, projection);
+                raster->finish();
+                bench.addRaster(profilerNowNs() - rasterStart, raster->triangleCount(), raster->pixelCount());
+            }
+            double ms = (profilerNowNs() - start) / 1e6;
+            bench.endTick(ms, simMs, frameDrawCalls);
+            frameArena().reset();
+        }
+        // The scenario's last frame, to eyeball against the GL renderer's.
+        if (raster) raster->writePpm(opts.outPath + "_" + bench.scenarioName() + ".ppm");
+    }
+    return bench.finish();
+}
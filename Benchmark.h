@@ -0,0 +1,96 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+
+// Scripted stress scenarios, run with e.g.
+//   opengl.exe --bench all --ticks 600
+//   opengl.exe --bench chasers --count 5000 --headless
+//   opengl.exe --bench all --headless --software-raster
+// Each scenario runs for a fixed number of fixed-dt ticks. Results go to
+// <out>.csv / <out>.json and are checked against a baseline file. The exit
+// code is non-zero if any metric is over baseline * (1 + margin).
+struct BenchOptions {
+    bool enabled = false;
+    bool headless = false;         // simulation only, no window or GL context
+    bool offscreen = false;        // rendered with no window (see OffscreenRenderer.h)
+    bool software = false;         // with headless: each tick also rendered on the CPU (see SoftwareRasterizer.h)
+    std::string scenario = "all";
+    int ticks = 600;
+    int count = 0;                 // 0 = scenario default
+    std::string outPath = "bench_results";
+    std::string baselinePath = "bench/baseline.csv";
+    float margin = 0.15f;
+    bool updateBaseline = false;
+};
+
+// Returns false (after printing usage) on a malformed command line.
+bool parseBenchArgs(int argc, char** argv, BenchOptions& opts);
+
+class Benchmark {
+public:
+    static constexpr float kTickSeconds = 1.0f / 60.0f;
+
+    explicit Benchmark(const BenchOptions& opts);
+
+    // Resets the world and sets up the next scenario. False once all have run.
+    bool nextScenario();
+    const char* scenarioName() const;
+
+    // Scripted input for this tick; also fixes deltaTime.
+    void beginTick();
+    void endTick(double frameMs, double simMs, int drawCalls);
+    // Software-rendered frames: time spent and work done, for the throughput stats.
+    void addRaster(uint64_t ns, long long triangles, long long pixels);
+    bool scenarioDone() const { return tick >= opts.ticks; }
+
+    // Writes the results, compares with the baseline and returns the process exit code.
+    int finish();
+
+private:
+    struct Result {
+        std::string name;
+        std::string mode;
+        int ticks;
+        float frameP50, frameP95, frameP99, frameMax;
+        float simAvg, simP99;
+        float drawCallsAvg;
+        float peakMemKb;
+        float tessMvtxPerSec;      // overlay_tessellation only; reported, not checked
+        float rasterMtriPerSec;    // software only; reported, not checked
+        float rasterMpixPerSec;
+    };
+
+    BenchOptions opts;
+    int scenarioIndex = -1;
+    int tick = 0;
+    int count = 0;
+    float lastShot = 0.0f;
+    std::vector<float> frameMs;
+    std::vector<float> simMs;
+    double drawCallSum = 0.0;
+    long long peakMem = 0;
+    struct OverlayTessellation;
+    std::shared_ptr<OverlayTessellation> tessellation; // overlay_tessellation's draw list, kept across scenarios
+    uint64_t tessNs = 0;
+    long long tessVertices = 0;
+    uint64_t rasterNs = 0;
+    long long rasterTriangles = 0, rasterPixels = 0;
+    std::vector<Result> results;
+
+    void resetWorld();
+    void finishScenario();
+    void aimAndFire(bool fire);
+    void writeResults() const;
+    int checkBaseline() const;
+    void writeBaseline() const;
+};
+
+// Runs the benchmarks with no window: simulation only, or with software
+// rendering on top. Returns the exit code.
+int runHeadlessBenchmark(const BenchOptions& opts);
+
+#endif
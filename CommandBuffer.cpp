@@ -0,0 +1,461 @@
+#include "CommandBuffer.h"
+#include "common.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "Shader.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Fixed arguments per opcode, all 4-byte fields so there is no padding
+    // to leak into saved files. BufferData's data follows its arguments.
+    struct ProgramArgs { uint32_t program; };
+    struct Uniform1iArgs { uint32_t name; int32_t value; };
+    struct Uniform1fArgs { uint32_t name; float value; };
+    struct Uniform3fArgs { uint32_t name; float value[3]; };
+    struct Uniform4fArgs { uint32_t name; float value[4]; };
+    struct UniformMatrixArgs { uint32_t name; float value[16]; };
+    struct VertexArrayArgs { uint32_t vao; };
+    struct BufferDataArgs { uint32_t target, buffer, usage, size; };
+    struct DrawArraysArgs { uint32_t mode; int32_t first, count; };
+    struct DrawInstancedArgs { uint32_t mode; int32_t first, count, instances; };
+    struct DrawElementsArgs { uint32_t mode; int32_t count; };
+    struct PolygonModeArgs { uint32_t face, mode; };
+
+    using Op = CommandBuffer::Op;
+
+    const size_t argSizes[(int)Op::Count] = {
+        sizeof(ProgramArgs), sizeof(Uniform1iArgs), sizeof(Uniform1fArgs), sizeof(Uniform3fArgs), sizeof(Uniform4fArgs),
+        sizeof(UniformMatrixArgs), sizeof(VertexArrayArgs), sizeof(BufferDataArgs), sizeof(DrawArraysArgs),
+        sizeof(DrawInstancedArgs), sizeof(DrawElementsArgs), sizeof(PolygonModeArgs),
+    };
+
+    bool isUniform(Op op) { return op >= Op::Uniform1i && op <= Op::UniformMatrix4f; }
+    bool isDraw(Op op) { return op == Op::DrawArrays || op == Op::DrawArraysInstanced || op == Op::DrawElements; }
+
+    template <typename T> T read(const uint8_t* p) {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    // Calls f(op, args, payload, payloadSize) for each command of a valid stream.
+    template <typename F> void walk(const std::vector<uint8_t>& bytes, F f) {
+        size_t at = 0;
+        while (at < bytes.size()) {
+            Op op = (Op)bytes[at++];
+            const uint8_t* args = &bytes[at];
+            at += argSizes[(int)op];
+            uint32_t payloadSize = op == Op::BufferData ? read<BufferDataArgs>(args).size : 0;
+            f(op, args, bytes.data() + at, payloadSize);
+            at += payloadSize;
+        }
+    }
+
+    const char* enumName(uint32_t e) {
+        switch (e) {
+        case GL_TRIANGLES: return "GL_TRIANGLES";
+        case GL_LINES: return "GL_LINES";
+        case GL_LINE_STRIP: return "GL_LINE_STRIP";
+        case GL_TRIANGLE_STRIP: return "GL_TRIANGLE_STRIP";
+        case GL_FRONT_AND_BACK: return "GL_FRONT_AND_BACK";
+        case GL_LINE: return "GL_LINE";
+        case GL_FILL: return "GL_FILL";
+        case GL_ARRAY_BUFFER: return "GL_ARRAY_BUFFER";
+        case GL_ELEMENT_ARRAY_BUFFER: return "GL_ELEMENT_ARRAY_BUFFER";
+        case GL_STATIC_DRAW: return "GL_STATIC_DRAW";
+        case GL_DYNAMIC_DRAW: return "GL_DYNAMIC_DRAW";
+        case GL_STREAM_DRAW: return "GL_STREAM_DRAW";
+        default: return nullptr;
+        }
+    }
+
+    void writeEnum(std::ostream& out, uint32_t e) {
+        const char* name = enumName(e);
+        if (name) out << name;
+        else out << "0x" << std::hex << e << std::dec;
+    }
+
+    constexpr char kMagic[4] = { 'G', 'L', 'C', 'B' };
+    constexpr uint32_t kVersion = 1;
+}
+
+const char* CommandBuffer::opName(Op op) {
+    static const char* names[(int)Op::Count] = {
+        "UseProgram", "Uniform1i", "Uniform1f", "Uniform3f", "Uniform4f", "UniformMatrix4f",
+        "BindVertexArray", "BufferData", "DrawArrays", "DrawArraysInstanced", "DrawElements", "PolygonMode",
+    };
+    return op < Op::Count ? names[(int)op] : "?";
+}
+
+template <typename T> void CommandBuffer::record(Op op, const T& args) {
+    static_assert(sizeof(T) % 4 == 0, "command arguments are 4-byte fields");
+    size_t at = bytes.size();
+    bytes.resize(at + 1 + sizeof(T));
+    bytes[at] = (uint8_t)op;
+    memcpy(&bytes[at + 1], &args, sizeof(T));
+    commands++;
+    if (isDraw(op)) draws++;
+}
+
+uint32_t CommandBuffer::nameIndex(const char* name) {
+    // A frame uses a handful of names, so a scan beats hashing.
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) return (uint32_t)i;
+    }
+    names.push_back(name);
+    return (uint32_t)(names.size() - 1);
+}
+
+void CommandBuffer::useProgram(const Shader& shader) {
+    record(Op::UseProgram, ProgramArgs{ shader.ID });
+}
+
+void CommandBuffer::setInt(const char* name, int value) {
+    record(Op::Uniform1i, Uniform1iArgs{ nameIndex(name), value });
+}
+
+void CommandBuffer::setFloat(const char* name, float value) {
+    record(Op::Uniform1f, Uniform1fArgs{ nameIndex(name), value });
+}
+
+void CommandBuffer::setVec3(const char* name, const glm::vec3& value) {
+    record(Op::Uniform3f, Uniform3fArgs{ nameIndex(name), { value.x, value.y, value.z } });
+}
+
+void CommandBuffer::setVec4(const char* name, const glm::vec4& value) {
+    record(Op::Uniform4f, Uniform4fArgs{ nameIndex(name), { value.x, value.y, value.z, value.w } });
+}
+
+void CommandBuffer::setMat4(const char* name, const glm::mat4& value) {
+    UniformMatrixArgs args;
+    args.name = nameIndex(name);
+    memcpy(args.value, &value[0][0], sizeof(args.value));
+    record(Op::UniformMatrix4f, args);
+}
+
+void CommandBuffer::bindVertexArray(GLuint vao) {
+    record(Op::BindVertexArray, VertexArrayArgs{ vao });
+}
+
+void CommandBuffer::bufferData(GLenum target, GLuint buffer, const void* data, size_t size, GLenum usage) {
+    record(Op::BufferData, BufferDataArgs{ target, buffer, usage, (uint32_t)size });
+    if (size) bytes.insert(bytes.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+void CommandBuffer::drawArrays(GLenum mode, GLint first, GLsizei count) {
+    record(Op::DrawArrays, DrawArraysArgs{ mode, first, count });
+}
+
+void CommandBuffer::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    record(Op::DrawArraysInstanced, DrawInstancedArgs{ mode, first, count, instances });
+}
+
+void CommandBuffer::drawElements(GLenum mode, GLsizei count) {
+    record(Op::DrawElements, DrawElementsArgs{ mode, count });
+}
+
+void CommandBuffer::polygonMode(GLenum face, GLenum mode) {
+    record(Op::PolygonMode, PolygonModeArgs{ face, mode });
+}
+
+void CommandBuffer::append(const CommandBuffer& other) {
+    // Same commands, but other's name indices point into its own table.
+    size_t start = bytes.size();
+    bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+    commands += other.commands;
+    draws += other.draws;
+    std::vector<uint32_t> remap(other.names.size());
+    for (size_t i = 0; i < other.names.size(); i++) remap[i] = nameIndex(other.names[i].c_str());
+    size_t at = start;
+    while (at < bytes.size()) {
+        Op op = (Op)bytes[at++];
+        if (isUniform(op)) {
+            uint32_t name = remap[read<uint32_t>(&bytes[at])];
+            memcpy(&bytes[at], &name, sizeof(name));
+        }
+        uint32_t payloadSize = op == Op::BufferData ? read<BufferDataArgs>(&bytes[at]).size : 0;
+        at += argSizes[(int)op] + payloadSize;
+    }
+}
+
+void CommandBuffer::clear() {
+    bytes.clear();
+    names.clear();
+    commands = 0;
+    draws = 0;
+}
+
+void CommandBuffer::execute() const {
+    GLState& gl = glState();
+    GLint program = gl.program();
+    if (!program) glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    auto location = [&](const uint8_t* args) { return glGetUniformLocation(program, names[read<uint32_t>(args)].c_str()); };
+    walk(bytes, [&](Op op, const uint8_t* args, const uint8_t* payload, uint32_t payloadSize) {
+        switch (op) {
+        case Op::UseProgram:
+            program = read<ProgramArgs>(args).program;
+            gl.useProgram(program);
+            break;
+        case Op::Uniform1i:
+            gl.uniform1i(location(args), read<Uniform1iArgs>(args).value);
+            break;
+        case Op::Uniform1f:
+            gl.uniform1f(location(args), read<Uniform1fArgs>(args).value);
+            break;
+        case Op::Uniform3f:
+            gl.uniform3f(location(args), read<Uniform3fArgs>(args).value);
+            break;
+        case Op::Uniform4f:
+            gl.uniform4f(location(args), read<Uniform4fArgs>(args).value);
+            break;
+        case Op::UniformMatrix4f:
+            gl.uniformMatrix4f(location(args), read<UniformMatrixArgs>(args).value);
+            break;
+        case Op::BindVertexArray:
+            gl.bindVertexArray(read<VertexArrayArgs>(args).vao);
+            break;
+        case Op::BufferData: {
+            BufferDataArgs a = read<BufferDataArgs>(args);
+            gl.bindBuffer(a.target, a.buffer);
+            glBufferData(a.target, payloadSize, payloadSize ? payload : nullptr, a.usage);
+            break;
+        }
+        case Op::DrawArrays: {
+            DrawArraysArgs a = read<DrawArraysArgs>(args);
+            frameDrawCalls++;
+            glDrawArrays(a.mode, a.first, a.count);
+            break;
+        }
+        case Op::DrawArraysInstanced: {
+            DrawInstancedArgs a = read<DrawInstancedArgs>(args);
+            frameDrawCalls++;
+            glDrawArraysInstanced(a.mode, a.first, a.count, a.instances);
+            break;
+        }
+        case Op::DrawElements: {
+            DrawElementsArgs a = read<DrawElementsArgs>(args);
+            frameDrawCalls++;
+            glDrawElements(a.mode, a.count, GL_UNSIGNED_INT, 0);
+            break;
+        }
+        case Op::PolygonMode: {
+            PolygonModeArgs a = read<PolygonModeArgs>(args);
+            gl.polygonMode(a.mode);
+            break;
+        }
+        default:
+            break;
+        }
+    });
+}
+
+// File: "GLCB", version, the name table (length-prefixed), the command and
+// draw counts, then the stream as recorded. Integers are little-endian, as
+// on every platform this builds for.
+bool CommandBuffer::save(const std::string& path) const {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "command buffer: cannot write " << path << std::endl;
+        return false;
+    }
+    uint32_t header[2] = { kVersion, (uint32_t)names.size() };
+    fwrite(kMagic, 1, sizeof(kMagic), f);
+    fwrite(header, sizeof(header), 1, f);
+    for (const std::string& name : names) {
+        uint32_t length = (uint32_t)name.size();
+        fwrite(&length, sizeof(length), 1, f);
+        fwrite(name.data(), 1, length, f);
+    }
+    uint32_t counts[2] = { (uint32_t)commands, (uint32_t)draws };
+    uint64_t size = bytes.size();
+    fwrite(counts, sizeof(counts), 1, f);
+    fwrite(&size, sizeof(size), 1, f);
+    fwrite(bytes.data(), 1, bytes.size(), f);
+    bool ok = !ferror(f);
+    fclose(f);
+    if (!ok) std::cerr << "command buffer: error writing " << path << std::endl;
+    return ok;
+}
+
+bool CommandBuffer::load(const std::string& path) {
+    clear();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "command buffer: cannot read " << path << std::endl;
+        return false;
+    }
+    char magic[4];
+    uint32_t header[2], counts[2];
+    uint64_t size = 0;
+    bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) && memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+        fread(header, sizeof(header), 1, f) == 1 && header[0] == kVersion;
+    for (uint32_t i = 0; ok && i < header[1]; i++) {
+        uint32_t length = 0;
+        ok = fread(&length, sizeof(length), 1, f) == 1 && length < 256;
+        std::string name(length, '\0');
+        ok = ok && fread(name.data(), 1, length, f) == length;
+        names.push_back(name);
+    }
+    ok = ok && fread(counts, sizeof(counts), 1, f) == 1 && fread(&size, sizeof(size), 1, f) == 1 && size < (1ull << 32);
+    if (ok) {
+        bytes.resize((size_t)size);
+        ok = fread(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    }
+    fclose(f);
+    if (ok) {
+        commands = (int)counts[0];
+        draws = (int)counts[1];
+        ok = validate();
+    }
+    if (!ok) {
+        std::cerr << "command buffer: " << path << " is not a valid capture" << std::endl;
+        clear();
+    }
+    return ok;
+}
+
+bool CommandBuffer::validate() const {
+    int seenCommands = 0, seenDraws = 0;
+    size_t at = 0;
+    while (at < bytes.size()) {
+        Op op = (Op)bytes[at++];
+        if (op >= Op::Count || bytes.size() - at < argSizes[(int)op]) return false;
+        if (isUniform(op) && read<uint32_t>(&bytes[at]) >= names.size()) return false;
+        uint32_t payloadSize = op == Op::BufferData ? read<BufferDataArgs>(&bytes[at]).size : 0;
+        at += argSizes[(int)op];
+        if (bytes.size() - at < payloadSize) return false;
+        at += payloadSize;
+        seenCommands++;
+        if (isDraw(op)) seenDraws++;
+    }
+    return seenCommands == commands && seenDraws == draws;
+}
+
+void CommandBuffer::dump(std::ostream& out) const {
+    int perOp[(int)Op::Count] = {};
+    walk(bytes, [&](Op op, const uint8_t*, const uint8_t*, uint32_t) { perOp[(int)op]++; });
+    out << commands << " commands, " << draws << " draws, " << bytes.size() << " bytes\n";
+    for (int i = 0; i < (int)Op::Count; i++) {
+        if (perOp[i]) out << "  " << opName((Op)i) << ": " << perOp[i] << "\n";
+    }
+
+    int index = 0;
+    walk(bytes, [&](Op op, const uint8_t* args, const uint8_t*, uint32_t payloadSize) {
+        out << index++ << " " << opName(op);
+        if (isUniform(op)) out << " " << names[read<uint32_t>(args)];
+        switch (op) {
+        case Op::UseProgram: out << " " << read<ProgramArgs>(args).program; break;
+        case Op::Uniform1i: out << " " << read<Uniform1iArgs>(args).value; break;
+        case Op::Uniform1f: out << " " << read<Uniform1fArgs>(args).value; break;
+        case Op::Uniform3f: {
+            Uniform3fArgs a = read<Uniform3fArgs>(args);
+            out << " (" << a.value[0] << ", " << a.value[1] << ", " << a.value[2] << ")";
+            break;
+        }
+        case Op::Uniform4f: {
+            Uniform4fArgs a = read<Uniform4fArgs>(args);
+            out << " (" << a.value[0] << ", " << a.value[1] << ", " << a.value[2] << ", " << a.value[3] << ")";
+            break;
+        }
+        case Op::UniformMatrix4f: {
+            // The translation column is usually the telling part.
+            UniformMatrixArgs a = read<UniformMatrixArgs>(args);
+            out << " translation (" << a.value[12] << ", " << a.value[13] << ", " << a.value[14] << ")";
+            break;
+        }
+        case Op::BindVertexArray: out << " " << read<VertexArrayArgs>(args).vao; break;
+        case Op::BufferData: {
+            BufferDataArgs a = read<BufferDataArgs>(args);
+            out << " ";
+            writeEnum(out, a.target);
+            out << " " << a.buffer << " " << payloadSize << " bytes ";
+            writeEnum(out, a.usage);
+            break;
+        }
+        case Op::DrawArrays: {
+            DrawArraysArgs a = read<DrawArraysArgs>(args);
+            out << " ";
+            writeEnum(out, a.mode);
+            out << " " << a.first << " " << a.count;
+            break;
+        }
+        case Op::DrawArraysInstanced: {
+            DrawInstancedArgs a = read<DrawInstancedArgs>(args);
+            out << " ";
+            writeEnum(out, a.mode);
+            out << " " << a.first << " " << a.count << " x" << a.instances;
+            break;
+        }
+        case Op::DrawElements: {
+            DrawElementsArgs a = read<DrawElementsArgs>(args);
+            out << " ";
+            writeEnum(out, a.mode);
+            out << " " << a.count;
+            break;
+        }
+        case Op::PolygonMode: {
+            PolygonModeArgs a = read<PolygonModeArgs>(args);
+            out << " ";
+            writeEnum(out, a.face);
+            out << " ";
+            writeEnum(out, a.mode);
+            break;
+        }
+        default:
+            break;
+        }
+        out << "\n";
+    });
+}
+
+RecordThread::RecordThread() {
+    thread = std::thread(&RecordThread::run, this);
+}
+
+RecordThread::~RecordThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_one();
+    thread.join();
+}
+
+void RecordThread::begin(void (*fn)(void*), void* arg) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobFn = fn;
+        jobArg = arg;
+        busy = true;
+    }
+    cv.notify_one();
+}
+
+void RecordThread::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [this] { return !busy; });
+}
+
+void RecordThread::run() {
+    PROFILE_THREAD("Record");
+    for (;;) {
+        void (*fn)(void*);
+        void* arg;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return quit || jobFn; });
+            if (quit) return;
+            fn = jobFn;
+            arg = jobArg;
+            jobFn = nullptr;
+        }
+        fn(arg);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = false;
+        }
+        doneCv.notify_one();
+    }
+}
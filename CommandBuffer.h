@@ -0,0 +1,129 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Shader;
+
+// A recorded list of draw and state commands, run later on the GL thread.
+// Recording makes no GL calls, so any thread can fill a buffer (one thread
+// per buffer); execute() then issues them in order, e.g.
+//   cmds.useProgram(shader);
+//   cmds.setInt("isInstanced", 0);
+//   mesh.draw(cmds);
+//   ...
+//   cmds.execute();
+// Commands are packed into one byte stream: an opcode then its arguments,
+// with buffer uploads copied inline. Uniforms are recorded by name and looked
+// up in the program current when they execute, as Shader's setters do.
+//
+// A buffer saves to and loads from disk, so a real frame can be kept for
+// replay (--replay-commands) or inspected offline (--dump-commands). Objects
+// are referred to by their GL names: a capture replays in a run of the same
+// build, which creates its programs and meshes in the same order.
+class CommandBuffer {
+public:
+    enum class Op : uint8_t {
+        UseProgram,
+        Uniform1i,
+        Uniform1f,
+        Uniform3f,
+        Uniform4f,
+        UniformMatrix4f,
+        BindVertexArray,
+        BufferData,
+        DrawArrays,
+        DrawArraysInstanced,
+        DrawElements,
+        PolygonMode,
+        Count
+    };
+    static const char* opName(Op op);
+
+    void useProgram(const Shader& shader);
+    void setInt(const char* name, int value);
+    void setFloat(const char* name, float value);
+    void setVec3(const char* name, const glm::vec3& value);
+    void setVec4(const char* name, const glm::vec4& value);
+    void setMat4(const char* name, const glm::mat4& value);
+    void bindVertexArray(GLuint vao);
+    // Copies size bytes of data into the buffer.
+    void bufferData(GLenum target, GLuint buffer, const void* data, size_t size, GLenum usage);
+    void drawArrays(GLenum mode, GLint first, GLsizei count);
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+    // Unsigned int indices from the start of the bound element buffer.
+    void drawElements(GLenum mode, GLsizei count);
+    void polygonMode(GLenum face, GLenum mode);
+
+    // Appends other's commands after this buffer's.
+    void append(const CommandBuffer& other);
+    void clear();
+    bool empty() const { return bytes.empty(); }
+
+    // Issues the commands; counts each draw in frameDrawCalls.
+    void execute() const;
+
+    int commandCount() const { return commands; }
+    int drawCount() const { return draws; }
+    size_t byteSize() const { return bytes.size(); }
+
+    // False (with a message) if the file cannot be written, or read back as
+    // a valid buffer; a failed load leaves the buffer empty.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    // Per-opcode totals, then one line per command.
+    void dump(std::ostream& out) const;
+
+private:
+    template <typename T> void record(Op op, const T& args);
+    uint32_t nameIndex(const char* name);
+    // Walks the stream, checking every command fits; what load() trusts.
+    bool validate() const;
+
+    std::vector<uint8_t> bytes;
+    std::vector<std::string> names;    // uniform names, by index
+    int commands = 0;
+    int draws = 0;
+};
+
+// A thread kept for recording command buffers alongside the main thread, so
+// a frame's recording jobs do not each start a thread (and the profiler sees
+// one "Record" track). One job at a time:
+//   recorder.start(job);   // job() runs on the worker
+//   ...                    // record other buffers here
+//   recorder.wait();       // job is done; its buffers can execute
+// job must stay alive until wait() returns.
+class RecordThread {
+public:
+    RecordThread();
+    ~RecordThread();
+    RecordThread(const RecordThread&) = delete;
+    RecordThread& operator=(const RecordThread&) = delete;
+
+    template <typename F> void start(F& job) {
+        begin([](void* f) { (*static_cast<F*>(f))(); }, &job);
+    }
+    void wait();
+
+private:
+    void begin(void (*fn)(void*), void* arg);
+    void run();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv, doneCv;
+    void (*jobFn)(void*) = nullptr;
+    void* jobArg = nullptr;
+    bool busy = false;
+    bool quit = false;
+};
+
+#endif
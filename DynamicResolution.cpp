@@ -0,0 +1,99 @@
+#include "DynamicResolution.h"
+#include "common.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "GpuTimer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// GPU timings trail submission by GpuTimers::kLatency frames; after a change
+// wait that long plus a few frames of fresh samples before judging it.
+static constexpr int kSettleFrames = GpuTimers::kLatency + 4;
+
+DynamicResolution& dynamicResolution() {
+    static DynamicResolution res;
+    return res;
+}
+
+void DynamicResolution::resize(int w, int h) {
+    if (w == targetW && h == targetH && fbo) return;
+    targetW = w;
+    targetH = h;
+    if (!fbo) {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &colorTex);
+        glGenTextures(1, &depthTex);
+        glGenVertexArrays(1, &emptyVAO);
+    }
+    glBindTexture(GL_TEXTURE_2D, colorTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    // Sampled with filtering by the upscale; clamp so the edge texels don't blend with the far side.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, depthTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, w, h, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Scene target incomplete at " << w << "x" << h << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, windowFramebuffer);
+}
+
+void DynamicResolution::beginScene(int width, int height) {
+    outW = width;
+    outH = height;
+    sceneW = std::max(1, (int)std::lround(width * currentScale));
+    sceneH = std::max(1, (int)std::lround(height * currentScale));
+    resize(sceneW, sceneH);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, sceneW, sceneH);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DynamicResolution::upscale(Shader& shader) {
+    glBindFramebuffer(GL_FRAMEBUFFER, windowFramebuffer);
+    glViewport(0, 0, outW, outH);
+    glState().setDepthTest(false);
+    shader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTex);
+    shader.setInt("scene", 0);
+    shader.setVec2("outputSize", glm::vec2(outW, outH));
+    shader.setFloat("sharpness", sharpness);
+    glState().bindVertexArray(emptyVAO);
+    frameDrawCalls++;
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glState().setDepthTest(true);
+}
+
+void DynamicResolution::update(float sceneGpuMs) {
+    if (!enabled) {
+        currentScale = kMaxScale;
+        return;
+    }
+    if (sceneGpuMs <= 0.0f || ++framesSinceChange < kSettleFrames) return;
+    filteredMs = filteredMs > 0.0f ? filteredMs + (sceneGpuMs - filteredMs) * 0.2f : sceneGpuMs;
+
+    // 1. Over budget: drop straight to the scale that fits.
+    // 2. Well under: climb one notch at a time, so a brief lull doesn't
+    //    bounce the scale up and straight back down.
+    float ideal = currentScale * std::sqrt(budgetMs / filteredMs);
+    float next;
+    if (filteredMs > budgetMs) next = std::floor(ideal / kStep) * kStep;
+    else if (filteredMs < budgetMs * 0.8f) next = std::min(ideal, currentScale + kStep);
+    else return;
+    next = std::clamp(std::round(next / kStep) * kStep, minScale, kMaxScale);
+    if (std::fabs(next - currentScale) < kStep * 0.5f) return;
+    currentScale = next;
+    framesSinceChange = 0;
+    filteredMs = 0.0f;
+}
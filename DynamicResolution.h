@@ -0,0 +1,69 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+
+class Shader;
+
+// Renders the 3D scene into an offscreen target smaller than the window and
+// filters it up afterwards (shaders/upscale.frag); the HUD and ImGui still
+// draw at native resolution on top. update() steers the scale from the GPU
+// time of the scene passes: scene cost goes with pixel count, so the scale
+// that fits the budget is about scale * sqrt(budget / measured).
+//
+// The target is reallocated when the scale changes, so the scale moves in
+// kStep notches and only after the timings have caught up with the last one.
+class DynamicResolution {
+public:
+    static constexpr float kStep = 0.05f;
+    static constexpr float kMaxScale = 1.0f;
+
+    // Off renders the scene straight to the window as before.
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+    // GPU time allowed for the scene passes.
+    void setBudgetMs(float ms) { budgetMs = ms; }
+    float getBudgetMs() const { return budgetMs; }
+    void setMinScale(float s) { minScale = s; }
+    float getMinScale() const { return minScale; }
+    // Upscale filter: 0 is plain bilinear, up to 1 for full sharpening.
+    void setSharpness(float s) { sharpness = s; }
+    float getSharpness() const { return sharpness; }
+
+    // Binds the scene target at the current scale of width x height, sets
+    // the viewport and clears with the current clear color.
+    void beginScene(int width, int height);
+    GLuint framebuffer() const { return fbo; }
+    int sceneWidth() const { return sceneW; }
+    int sceneHeight() const { return sceneH; }
+    float scale() const { return currentScale; }
+
+    // Draws the scene target over the window (windowFramebuffer) at the size
+    // given to beginScene(). shader must be the upscale program
+    // (shaders/deferred.vert, shaders/upscale.frag).
+    void upscale(Shader& shader);
+
+    // Feeds the newest GPU time of the scene passes; may change the scale
+    // used by the next beginScene().
+    void update(float sceneGpuMs);
+
+private:
+    void resize(int w, int h);
+
+    bool enabled = true;
+    float budgetMs = 10.0f;
+    float minScale = 0.5f;
+    float sharpness = 0.5f;
+
+    GLuint fbo = 0, colorTex = 0, depthTex = 0;
+    GLuint emptyVAO = 0;
+    int targetW = 0, targetH = 0;     // allocated size
+    int sceneW = 0, sceneH = 0, outW = 0, outH = 0;
+    float currentScale = kMaxScale;
+    float filteredMs = 0.0f;
+    int framesSinceChange = 0;
+};
+
+DynamicResolution& dynamicResolution();
+
+#endif
@@ -0,0 +1,198 @@
+#include "FlowField.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <queue>
+
+namespace {
+    constexpr uint32_t kUnreached = UINT32_MAX;
+    constexpr int kCells = FlowField::kSize * FlowField::kSize;
+
+    // 8 neighbours, straight steps cost 10 and diagonals 14.
+    const int kDx[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int kDz[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    const uint32_t kStep[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+
+    inline int idx(int x, int z) { return z * FlowField::kSize + x; }
+    inline bool inGrid(int x, int z) { return x >= 0 && z >= 0 && x < FlowField::kSize && z < FlowField::kSize; }
+}
+
+FlowField& flowField() {
+    static FlowField field;
+    return field;
+}
+
+FlowField::FlowField() {
+    worker = std::thread(&FlowField::run, this);
+}
+
+FlowField::~FlowField() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+void FlowField::setBlockers(std::vector<Blocker> b) {
+    blockers = std::move(b);
+    blockersDirty = true;
+}
+
+glm::ivec2 FlowField::cellOf(const glm::vec3& pos) {
+    return glm::ivec2((int)floorf((pos.x - kOrigin) / kCellSize), (int)floorf((pos.z - kOrigin) / kCellSize));
+}
+
+void FlowField::setGoal(const glm::vec3& pos) {
+    glm::ivec2 cell = glm::clamp(cellOf(pos), glm::ivec2(0), glm::ivec2(kSize - 1));
+    if (cell == requestedGoal && !blockersDirty) return;
+    requestedGoal = cell;
+    if (synchronous) {
+        timedBuild(front, cell, blockers);
+        blockersDirty = false;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobGoal = cell;
+        if (blockersDirty) jobBlockers = blockers;
+        jobPending = true;
+    }
+    blockersDirty = false;
+    cv.notify_one();
+}
+
+void FlowField::update() {
+    if (!backReady.load(std::memory_order_acquire)) return;
+    std::swap(front, back);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        backReady.store(false, std::memory_order_release);
+    }
+    cv.notify_one();
+}
+
+void FlowField::run() {
+    PROFILE_THREAD("Flow field");
+    std::vector<Blocker> localBlockers;
+    for (;;) {
+        glm::ivec2 goal;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Wait for a job, and for the main thread to take the last result.
+            cv.wait(lock, [this] { return quit || (jobPending && !backReady.load(std::memory_order_acquire)); });
+            if (quit) return;
+            goal = jobGoal;
+            localBlockers = jobBlockers;
+            jobPending = false;
+        }
+        timedBuild(back, goal, localBlockers);
+        backReady.store(true, std::memory_order_release);
+    }
+}
+
+void FlowField::timedBuild(Field& f, glm::ivec2 goal, const std::vector<Blocker>& blockers) {
+    uint64_t start = profilerNowNs();
+    {
+        PROFILE_SCOPE("Flow field build");
+        build(f, goal, blockers);
+    }
+    buildMs.store((profilerNowNs() - start) / 1e6f, std::memory_order_relaxed);
+    builds.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FlowField::build(Field& f, glm::ivec2 goal, const std::vector<Blocker>& blockers) {
+    f.goal = goal;
+    f.cost.assign(kCells, kUnreached);
+    f.blocked.assign(kCells, 0);
+    f.dir.assign(kCells, glm::vec2(0.0f));
+
+    // 1. Rasterize blockers: a cell is blocked if its centre is inside a footprint.
+    for (const Blocker& b : blockers) {
+        int x0 = std::max(0, (int)ceilf((b.min.x - kOrigin) / kCellSize - 0.5f));
+        int x1 = std::min(kSize - 1, (int)floorf((b.max.x - kOrigin) / kCellSize - 0.5f));
+        int z0 = std::max(0, (int)ceilf((b.min.y - kOrigin) / kCellSize - 0.5f));
+        int z1 = std::min(kSize - 1, (int)floorf((b.max.y - kOrigin) / kCellSize - 0.5f));
+        for (int z = z0; z <= z1; z++)
+            for (int x = x0; x <= x1; x++) f.blocked[idx(x, z)] = 1;
+    }
+
+    // 2. Integration field: Dijkstra out from the goal.
+    typedef std::pair<uint32_t, int> Node;
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+    f.cost[idx(goal.x, goal.y)] = 0;
+    open.push({ 0, idx(goal.x, goal.y) });
+    while (!open.empty()) {
+        Node n = open.top();
+        open.pop();
+        if (n.first != f.cost[n.second]) continue; // stale entry
+        int x = n.second % kSize, z = n.second / kSize;
+        for (int k = 0; k < 8; k++) {
+            int nx = x + kDx[k], nz = z + kDz[k];
+            if (!inGrid(nx, nz) || f.blocked[idx(nx, nz)]) continue;
+            // Diagonals may not squeeze between two blocked cells' corners.
+            if (k >= 4 && (f.blocked[idx(nx, z)] || f.blocked[idx(x, nz)])) continue;
+            uint32_t c = n.first + kStep[k];
+            if (c < f.cost[idx(nx, nz)]) {
+                f.cost[idx(nx, nz)] = c;
+                open.push({ c, idx(nx, nz) });
+            }
+        }
+    }
+
+    // 3. Direction field: point at the cheapest reachable neighbour.
+    const float invSqrt2 = 0.70710678f;
+    for (int z = 0; z < kSize; z++) {
+        for (int x = 0; x < kSize; x++) {
+            uint32_t best = f.cost[idx(x, z)];
+            if (best == kUnreached || best == 0) continue;
+            int bestK = -1;
+            for (int k = 0; k < 8; k++) {
+                int nx = x + kDx[k], nz = z + kDz[k];
+                if (!inGrid(nx, nz) || f.blocked[idx(nx, nz)]) continue;
+                if (k >= 4 && (f.blocked[idx(nx, z)] || f.blocked[idx(x, nz)])) continue;
+                if (f.cost[idx(nx, nz)] < best) {
+                    best = f.cost[idx(nx, nz)];
+                    bestK = k;
+                }
+            }
+            if (bestK >= 0) {
+                float s = bestK >= 4 ? invSqrt2 : 1.0f;
+                f.dir[idx(x, z)] = glm::vec2(kDx[bestK] * s, kDz[bestK] * s);
+            }
+        }
+    }
+}
+
+glm::vec2 FlowField::direction(const glm::vec3& pos) const {
+    if (front.dir.empty()) return glm::vec2(0.0f);
+    glm::ivec2 cell = cellOf(pos);
+    if (!inGrid(cell.x, cell.y) || cell == front.goal) return glm::vec2(0.0f);
+
+    // Blend the four cells around pos so chasers turn smoothly instead of in
+    // 45 degree steps.
+    float fx = (pos.x - kOrigin) / kCellSize - 0.5f;
+    float fz = (pos.z - kOrigin) / kCellSize - 0.5f;
+    int x0 = (int)floorf(fx), z0 = (int)floorf(fz);
+    float tx = fx - x0, tz = fz - z0;
+    glm::vec2 sum(0.0f);
+    for (int dz = 0; dz < 2; dz++) {
+        for (int dx = 0; dx < 2; dx++) {
+            int x = std::clamp(x0 + dx, 0, kSize - 1), z = std::clamp(z0 + dz, 0, kSize - 1);
+            float w = (dx ? tx : 1.0f - tx) * (dz ? tz : 1.0f - tz);
+            sum += front.dir[idx(x, z)] * w;
+        }
+    }
+    float len = glm::length(sum);
+    // Mixed signals (e.g. right on a ridge between two routes): use the cell's own.
+    if (len < 1e-3f) return front.dir[idx(cell.x, cell.y)];
+    return sum / len;
+}
+
+bool FlowField::isBlocked(const glm::vec3& pos) const {
+    if (front.blocked.empty()) return false;
+    glm::ivec2 cell = cellOf(pos);
+    return inGrid(cell.x, cell.y) && front.blocked[idx(cell.x, cell.y)];
+}
@@ -0,0 +1,90 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Grid flow field towards the player, shared by every chaser.
+// An integration field (Dijkstra from the goal cell, 8 neighbours, no corner
+// cutting past blockers) is turned into a per-cell direction field. It is only
+// rebuilt when the goal moves to another cell, on a worker thread, into a back
+// buffer that the main thread swaps in. Chasers then just look up their cell,
+// so the cost is one build per player cell change plus an O(1) sample each.
+class FlowField {
+public:
+    static constexpr int kSize = 128;          // cells per side
+    static constexpr float kCellSize = 1.0f;
+    static constexpr float kOrigin = -64.0f;   // world x/z of the grid corner
+
+    // Axis-aligned footprint on the x/z plane.
+    struct Blocker {
+        glm::vec2 min;
+        glm::vec2 max;
+    };
+
+    FlowField();
+    ~FlowField();
+    FlowField(const FlowField&) = delete;
+    FlowField& operator=(const FlowField&) = delete;
+
+    void setBlockers(std::vector<Blocker> b);
+    // Queues a rebuild if pos is in a different cell than the last goal. Never waits.
+    void setGoal(const glm::vec3& pos);
+    // Builds in setGoal on the calling thread instead, so the field a tick
+    // sees does not depend on the worker's timing (offscreen and bench runs).
+    // Set before the first setGoal.
+    void setSynchronous(bool on) { synchronous = on; }
+    // Swaps in a finished build. Main thread, once per tick.
+    void update();
+
+    // Bilinear blend of the neighbouring cell directions (unit length), or zero
+    // if there is no field yet, pos is off the grid, or pos is in the goal cell.
+    glm::vec2 direction(const glm::vec3& pos) const;
+    bool isBlocked(const glm::vec3& pos) const;
+
+    float lastBuildMs() const { return buildMs.load(std::memory_order_relaxed); }
+    int buildCount() const { return builds.load(std::memory_order_relaxed); }
+
+private:
+    struct Field {
+        glm::ivec2 goal = glm::ivec2(-1);
+        std::vector<uint32_t> cost;
+        std::vector<uint8_t> blocked;
+        std::vector<glm::vec2> dir;
+    };
+
+    Field front;                  // main thread only
+    Field back;                   // worker only while backReady is false
+    std::atomic<bool> backReady{ false };
+
+    std::vector<Blocker> blockers;
+    bool blockersDirty = true;
+    bool synchronous = false;
+    glm::ivec2 requestedGoal = glm::ivec2(-1);
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool jobPending = false;
+    bool quit = false;
+    glm::ivec2 jobGoal;
+    std::vector<Blocker> jobBlockers;
+
+    std::atomic<float> buildMs{ 0.0f };
+    std::atomic<int> builds{ 0 };
+
+    void run();
+    // build() plus the timing stats.
+    void timedBuild(Field& f, glm::ivec2 goal, const std::vector<Blocker>& blockers);
+    static void build(Field& f, glm::ivec2 goal, const std::vector<Blocker>& blockers);
+    static glm::ivec2 cellOf(const glm::vec3& pos);
+};
+
+FlowField& flowField();
+
+#endif
@@ -0,0 +1,127 @@
+#include "FramePacer.h"
+#include "Profiler.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+static int binOf(float ms) {
+    int b = (int)(ms / FrameHistogram::kBinMs);
+    return std::min(std::max(b, 0), FrameHistogram::kBins - 1);
+}
+
+void FrameHistogram::add(float ms) {
+    if (count == kWindow) bins[binOf(samples[next])]--;
+    else count++;
+    samples[next] = ms;
+    bins[binOf(ms)]++;
+    next = (next + 1) % kWindow;
+}
+
+void FrameHistogram::clear() {
+    std::fill(bins, bins + kBins, 0u);
+    count = 0;
+    next = 0;
+}
+
+float FrameHistogram::percentile(float p) const {
+    if (count == 0) return 0.0f;
+    // Same rank as RollingStats::percentile.
+    uint32_t rank = (uint32_t)(p * (count - 1) + 0.5f), seen = 0;
+    for (int b = 0; b < kBins; b++) {
+        seen += bins[b];
+        if (seen > rank) return (b + 1) * kBinMs;
+    }
+    return kBins * kBinMs;
+}
+
+float FrameHistogram::max() const {
+    float m = 0.0f;
+    for (int i = 0; i < count; i++) m = std::max(m, samples[i]);
+    return m;
+}
+
+bool FrameHistogram::exportCsv(const char* path) const {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# frames,p50_ms,p99_ms,p99.9_ms,max_ms\n");
+    fprintf(f, "# %d,%.3f,%.3f,%.3f,%.3f\n", count, percentile(0.5f), percentile(0.99f), percentile(0.999f), max());
+    fprintf(f, "bin_ms,count\n");
+    for (int b = 0; b < kBins; b++) {
+        if (bins[b]) fprintf(f, "%.2f,%u\n", b * kBinMs, bins[b]);
+    }
+    fclose(f);
+    return true;
+}
+
+FramePacer& framePacer() {
+    static FramePacer pacer;
+    return pacer;
+}
+
+const char* FramePacer::modeName(PacingMode mode) {
+    switch (mode) {
+    case PacingMode::Vsync: return "Vsync";
+    case PacingMode::AdaptiveVsync: return "Adaptive vsync";
+    case PacingMode::Uncapped: return "Uncapped";
+    case PacingMode::Capped: return "Capped";
+    }
+    return "";
+}
+
+void FramePacer::setMode(GLFWwindow* window, PacingMode m) {
+    mode = m;
+    glfwMakeContextCurrent(window);
+    adaptive = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    int interval = 0;
+    if (mode == PacingMode::Vsync) interval = 1;
+    else if (mode == PacingMode::AdaptiveVsync) interval = adaptive ? -1 : 1;
+    glfwSwapInterval(interval);
+    nextBoundary = 0; // the limiter starts a fresh schedule
+    frames.clear();
+}
+
+void FramePacer::wait() {
+    if (mode != PacingMode::Capped || targetFps <= 0.0f) return;
+    PROFILE_SCOPE("Frame limiter");
+    uint64_t period = (uint64_t)(1e9 / targetFps);
+    uint64_t now = profilerNowNs();
+    if (nextBoundary == 0 || now >= nextBoundary + period) {
+        // First frame, or the boundary was missed by over a frame: this
+        // frame goes now and the schedule restarts from it rather than
+        // rushing to catch up.
+        if (nextBoundary) missed++;
+        nextBoundary = now + period;
+        return;
+    }
+    if (now >= nextBoundary) {
+        // Late by less than a frame: go now and keep the schedule.
+        missed++;
+        nextBoundary += period;
+        return;
+    }
+    while ((now = profilerNowNs()) < nextBoundary) {
+        uint64_t remaining = nextBoundary - now;
+        if (remaining > spinNs) {
+            uint64_t request = remaining - spinNs;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(request));
+            // Widen the spin margin to the worst oversleep, and let it
+            // shrink slowly again once the scheduler behaves.
+            uint64_t slept = profilerNowNs() - now;
+            uint64_t over = slept > request ? slept - request : 0;
+            spinNs = std::clamp(std::max(spinNs - spinNs / 64, over + over / 4), (uint64_t)200000, period);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    nextBoundary += period;
+}
+
+void FramePacer::endFrame() {
+    uint64_t now = profilerNowNs();
+    if (lastSwap) frames.add((now - lastSwap) / 1e6f);
+    lastSwap = now;
+}
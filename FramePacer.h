@@ -0,0 +1,81 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <cstdint>
+
+struct GLFWwindow;
+
+// Frame times over the last kWindow frames, kept as a fixed-bin histogram so
+// the tail percentiles (p99.9 needs a thousand frames to mean anything) cost
+// a bin walk rather than a sort. Adding a frame evicts the oldest one.
+class FrameHistogram {
+public:
+    static constexpr int kWindow = 8192;
+    static constexpr float kBinMs = 0.05f;
+    static constexpr int kBins = 2000;      // 0 - 100 ms; slower frames land in the last bin
+
+    void add(float ms);
+    void clear();
+
+    int size() const { return count; }
+    // p in [0, 1]; the upper edge of the bin holding that rank, so it errs
+    // slow by at most kBinMs.
+    float percentile(float p) const;
+    float max() const;
+
+    // CSV: a header of percentiles, then one bin_ms,count row per non-empty bin.
+    bool exportCsv(const char* path) const;
+
+private:
+    float samples[kWindow];
+    uint32_t bins[kBins] = {};
+    int count = 0;
+    int next = 0;
+};
+
+enum class PacingMode { Vsync, AdaptiveVsync, Uncapped, Capped };
+
+// Owns the swap interval and the frame limiter. Call wait() right before
+// glfwSwapBuffers and endFrame() right after; frame times are measured
+// between consecutive swaps, which is what the player sees.
+class FramePacer {
+public:
+    // Applies the swap interval for mode to window's context, which is made
+    // current (the interval belongs to the context). Adaptive vsync (late frames tear
+    // rather than wait a whole refresh) needs the swap_control_tear
+    // extension and falls back to plain vsync without it.
+    void setMode(GLFWwindow* window, PacingMode mode);
+    PacingMode getMode() const { return mode; }
+    static const char* modeName(PacingMode mode);
+    bool adaptiveSupported() const { return adaptive; }
+
+    void setTargetFps(float fps) { targetFps = fps; }
+    float getTargetFps() const { return targetFps; }
+
+    // Capped mode: blocks until the next frame boundary. Boundaries are
+    // fixed steps from the first, not from when the frame finished, so the
+    // cap doesn't drift; a frame that misses one restarts the schedule.
+    // Sleeps while the boundary is far off and spins for the last stretch,
+    // which is widened by any oversleep seen so far.
+    void wait();
+    void endFrame();
+
+    const FrameHistogram& histogram() const { return frames; }
+    void resetHistogram() { frames.clear(); }
+    int missedBoundaries() const { return missed; }
+    float spinMarginMs() const { return spinNs / 1e6f; }
+
+private:
+    PacingMode mode = PacingMode::Vsync;
+    bool adaptive = false;
+    float targetFps = 120.0f;
+    uint64_t nextBoundary = 0;
+    uint64_t spinNs = 1000000;
+    uint64_t lastSwap = 0;
+    int missed = 0;
+    FrameHistogram frames;
+};
+
+FramePacer& framePacer();
+
+#endif
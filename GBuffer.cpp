@@ -0,0 +1,74 @@
+#include "GBuffer.h"
+#include "common.h"
+#include "GLState.h"
+#include "Shader.h"
+#include <iostream>
+
+GBuffer& gbuffer() {
+    static GBuffer buffer;
+    return buffer;
+}
+
+void GBuffer::resize(int w, int h) {
+    if (w == width && h == height && fbo) return;
+    width = w;
+    height = h;
+    if (!fbo) {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &albedoTex);
+        glGenTextures(1, &normalTex);
+        glGenTextures(1, &depthTex);
+        glGenVertexArrays(1, &emptyVAO);
+    }
+    struct Target { GLuint tex; GLint internal; GLenum format, type; };
+    const Target targets[3] = {
+        { albedoTex, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+        { normalTex, GL_RG16F, GL_RG, GL_FLOAT },
+        { depthTex, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT },
+    };
+    for (const Target& t : targets) {
+        glBindTexture(GL_TEXTURE_2D, t.tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, t.internal, width, height, 0, t.format, t.type, nullptr);
+        // Read with texelFetch, one texel per pixel.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "G-buffer incomplete at " << width << "x" << height << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, windowFramebuffer);
+}
+
+void GBuffer::beginGeometry() {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GBuffer::light(Shader& shader, int firstUnit, GLuint target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    const GLuint textures[3] = { albedoTex, normalTex, depthTex };
+    const char* samplers[3] = { "gAlbedo", "gNormal", "gDepth" };
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        shader.setInt(samplers[i], firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    // The target keeps its clear color and depth from the start of the
+    // frame; the lighting pass neither tests nor writes depth.
+    glState().setDepthTest(false);
+    glState().bindVertexArray(emptyVAO);
+    frameDrawCalls++;
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glState().setDepthTest(true);
+}
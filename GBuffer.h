@@ -0,0 +1,35 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <glad/glad.h>
+
+class Shader;
+
+// Render targets for the deferred path. Geometry writes surface attributes
+// only (shaders/gbuffer.frag); one full-screen pass (shaders/deferred.frag)
+// then lights every pixel once, so overdraw no longer pays for lighting.
+// Layout, 8 bytes of color per pixel plus depth:
+//   0  RGBA8    albedo
+//   1  RG16F    normal, octahedral-encoded
+//   depth 24    world position is rebuilt from it with the inverse view-projection
+class GBuffer {
+public:
+    // (Re)allocates the targets when the size changes. Needs a GL context.
+    void resize(int width, int height);
+
+    // Binds and clears the targets for the geometry pass.
+    void beginGeometry();
+    // Binds target (0 for the window), binds albedo, normal and depth to
+    // texture units firstUnit.. and draws a full-screen triangle with shader,
+    // which must already be in use.
+    void light(Shader& shader, int firstUnit, GLuint target);
+
+private:
+    int width = 0, height = 0;
+    GLuint fbo = 0, albedoTex = 0, normalTex = 0, depthTex = 0;
+    GLuint emptyVAO = 0;   // core profile wants a VAO even for attribute-less draws
+};
+
+GBuffer& gbuffer();
+
+#endif
@@ -0,0 +1,163 @@
+#include "GLState.h"
+#include <cstring>
+
+GLState& glState() {
+    static GLState state;
+    return state;
+}
+
+const char* GLState::kindName(Kind kind) {
+    static const char* names[KindCount] = { "Program", "Vertex array", "Buffer", "Uniform", "Polygon mode", "Blend", "Depth" };
+    return kind >= 0 && kind < KindCount ? names[kind] : "?";
+}
+
+int GLState::Counts::totalIssued() const {
+    int total = 0;
+    for (int n : issued) total += n;
+    return total;
+}
+
+int GLState::Counts::totalFiltered() const {
+    int total = 0;
+    for (int n : filtered) total += n;
+    return total;
+}
+
+void GLState::useProgram(GLuint program) {
+    bool changed = program != currentProgram;
+    count(KindProgram, changed);
+    if (!changed) return;
+    currentProgram = program;
+    programUniforms = &uniforms[program];
+    glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    bool changed = vao != currentVao;
+    count(KindVertexArray, changed);
+    if (!changed) return;
+    currentVao = vao;
+    buffers[SlotElementArray] = kUnknown;
+    glBindVertexArray(vao);
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    int slot = target == GL_ARRAY_BUFFER ? SlotArray
+        : target == GL_ELEMENT_ARRAY_BUFFER ? SlotElementArray
+        : target == GL_TEXTURE_BUFFER ? SlotTexture : -1;
+    bool changed = slot < 0 || buffer != buffers[slot];
+    count(KindBuffer, changed);
+    if (!changed) return;
+    if (slot >= 0) buffers[slot] = buffer;
+    glBindBuffer(target, buffer);
+}
+
+void GLState::polygonMode(GLenum mode) {
+    bool changed = mode != currentPolygonMode;
+    count(KindPolygonMode, changed);
+    if (!changed) return;
+    currentPolygonMode = mode;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::setBlend(bool enabled) {
+    bool changed = blend != (enabled ? On : Off);
+    count(KindBlend, changed);
+    if (!changed) return;
+    blend = enabled ? On : Off;
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst) {
+    bool changed = src != blendSrc || dst != blendDst;
+    count(KindBlend, changed);
+    if (!changed) return;
+    blendSrc = src;
+    blendDst = dst;
+    glBlendFunc(src, dst);
+}
+
+void GLState::setDepthTest(bool enabled) {
+    bool changed = depthTest != (enabled ? On : Off);
+    count(KindDepth, changed);
+    if (!changed) return;
+    depthTest = enabled ? On : Off;
+    if (enabled) glEnable(GL_DEPTH_TEST);
+    else glDisable(GL_DEPTH_TEST);
+}
+
+// Type tags for the uniform copies; a location set with another type is
+// always reissued.
+enum : uint8_t { UniformInt = 1, UniformInt3, UniformFloat, UniformVec2, UniformVec3, UniformVec4, UniformMat4 };
+
+bool GLState::uniformChanged(GLint location, uint8_t type, const void* value, int words) {
+    // With the program unknown there is nothing to compare against; far-off
+    // locations (drivers hand out small ones) are not worth the slots.
+    if (!programUniforms || location >= kMaxUniformLocation) return true;
+    std::vector<Uniform>& slots = *programUniforms;
+    if (location >= (GLint)slots.size()) slots.resize(location + 1);
+    Uniform& u = slots[location];
+    if (u.type == type && std::memcmp(u.words, value, words * sizeof(uint32_t)) == 0) return false;
+    u.type = type;
+    std::memcpy(u.words, value, words * sizeof(uint32_t));
+    return true;
+}
+
+void GLState::uniform1i(GLint location, int value) {
+    bool changed = location >= 0 && uniformChanged(location, UniformInt, &value, 1);
+    count(KindUniform, changed);
+    if (changed) glUniform1i(location, value);
+}
+
+void GLState::uniform3i(GLint location, int x, int y, int z) {
+    const int value[3] = { x, y, z };
+    bool changed = location >= 0 && uniformChanged(location, UniformInt3, value, 3);
+    count(KindUniform, changed);
+    if (changed) glUniform3i(location, x, y, z);
+}
+
+void GLState::uniform1f(GLint location, float value) {
+    bool changed = location >= 0 && uniformChanged(location, UniformFloat, &value, 1);
+    count(KindUniform, changed);
+    if (changed) glUniform1f(location, value);
+}
+
+void GLState::uniform2f(GLint location, const float* value) {
+    bool changed = location >= 0 && uniformChanged(location, UniformVec2, value, 2);
+    count(KindUniform, changed);
+    if (changed) glUniform2fv(location, 1, value);
+}
+
+void GLState::uniform3f(GLint location, const float* value) {
+    bool changed = location >= 0 && uniformChanged(location, UniformVec3, value, 3);
+    count(KindUniform, changed);
+    if (changed) glUniform3fv(location, 1, value);
+}
+
+void GLState::uniform4f(GLint location, const float* value) {
+    bool changed = location >= 0 && uniformChanged(location, UniformVec4, value, 4);
+    count(KindUniform, changed);
+    if (changed) glUniform4fv(location, 1, value);
+}
+
+void GLState::uniformMatrix4f(GLint location, const float* value) {
+    bool changed = location >= 0 && uniformChanged(location, UniformMat4, value, 16);
+    count(KindUniform, changed);
+    if (changed) glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+void GLState::invalidate() {
+    currentProgram = kUnknown;
+    programUniforms = nullptr;
+    currentVao = kUnknown;
+    for (GLuint& b : buffers) b = kUnknown;
+    currentPolygonMode = 0;
+    blend = depthTest = Unknown;
+    blendSrc = blendDst = 0;
+}
+
+void GLState::beginFrame() {
+    last = frame;
+    frame = Counts();
+}
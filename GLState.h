@@ -0,0 +1,103 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Shadow copy of the GL state the renderer sets most: program, vertex array,
+// buffer bindings, uniforms, polygon mode, blend and depth test. Each setter
+// compares with the copy and drops the GL call when nothing would change, so
+// passes can set everything they need without knowing what ran before them.
+// Every call is counted per kind as issued or filtered; beginFrame() keeps the
+// last frame's counts for the HUD.
+//
+// The copy is only right while all changes go through here. State starts out
+// unknown (the first call of each kind is always issued), and code that sets
+// it behind the cache's back, such as the ImGui backend, calls invalidate()
+// afterwards. Uniform values are kept per program and survive invalidate(),
+// since a program's uniforms only change through it.
+class GLState {
+public:
+    enum Kind {
+        KindProgram,
+        KindVertexArray,
+        KindBuffer,
+        KindUniform,
+        KindPolygonMode,
+        KindBlend,
+        KindDepth,
+        KindCount
+    };
+    static const char* kindName(Kind kind);
+
+    struct Counts {
+        int issued[KindCount] = {};
+        int filtered[KindCount] = {};
+        int totalIssued() const;
+        int totalFiltered() const;
+    };
+
+    void useProgram(GLuint program);
+    // The program in use, or 0 if unknown.
+    GLuint program() const { return currentProgram == kUnknown ? 0 : currentProgram; }
+    // Binding a vertex array also changes the element buffer binding, which
+    // is part of it.
+    void bindVertexArray(GLuint vao);
+    // Array, element and texture buffers are tracked; other targets pass through.
+    void bindBuffer(GLenum target, GLuint buffer);
+    // Core profiles only take GL_FRONT_AND_BACK.
+    void polygonMode(GLenum mode);
+    void setBlend(bool enabled);
+    void blendFunc(GLenum src, GLenum dst);
+    void setDepthTest(bool enabled);
+
+    // Uniforms of the program in use; location -1 is dropped, as GL would.
+    void uniform1i(GLint location, int value);
+    void uniform3i(GLint location, int x, int y, int z);
+    void uniform1f(GLint location, float value);
+    void uniform2f(GLint location, const float* value);
+    void uniform3f(GLint location, const float* value);
+    void uniform4f(GLint location, const float* value);
+    void uniformMatrix4f(GLint location, const float* value);
+
+    // Forgets the bindings and enables (not uniforms); the next call of each
+    // kind is issued.
+    void invalidate();
+
+    // Call once per frame: the running counts become lastFrame().
+    void beginFrame();
+    const Counts& lastFrame() const { return last; }
+
+private:
+    static constexpr GLuint kUnknown = 0xFFFFFFFFu;
+    static constexpr GLint kMaxUniformLocation = 1024;
+    enum BufferSlot { SlotArray, SlotElementArray, SlotTexture, SlotCount };
+    enum TriState : int8_t { Unknown = -1, Off = 0, On = 1 };
+
+    struct Uniform {
+        uint8_t type = 0;        // 0 = never set
+        uint32_t words[16];
+    };
+
+    // True (and the copy updated) if value differs from location's copy.
+    bool uniformChanged(GLint location, uint8_t type, const void* value, int words);
+    void count(Kind kind, bool issued) { (issued ? frame.issued : frame.filtered)[kind]++; }
+
+    GLuint currentProgram = kUnknown;
+    GLuint currentVao = kUnknown;
+    GLuint buffers[SlotCount] = { kUnknown, kUnknown, kUnknown };
+    GLenum currentPolygonMode = 0;
+    TriState blend = Unknown, depthTest = Unknown;
+    GLenum blendSrc = 0, blendDst = 0;
+
+    std::unordered_map<GLuint, std::vector<Uniform>> uniforms;
+    std::vector<Uniform>* programUniforms = nullptr;   // currentProgram's, or null if unknown
+
+    Counts frame, last;
+};
+
+GLState& glState();
+
+#endif
@@ -0,0 +1,147 @@
+#include "GpuTimer.h"
+#include "imgui.h"
+#include <cstring>
+
+GpuTimers& gpuTimers() {
+    static GpuTimers timers;
+    return timers;
+}
+
+void GpuTimers::init() {
+    // Some drivers expose no timestamp counter; leave timing off rather than report zeros.
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0) return;
+    for (int i = 0; i < kLatency; i++) {
+        glGenQueries(kMaxPasses * 2, frames[i].queries);
+        frames[i].count = 0;
+        frames[i].pending = false;
+    }
+    ready = true;
+    syncClocks();
+}
+
+void GpuTimers::shutdown() {
+    if (!ready) return;
+    for (int i = 0; i < kLatency; i++) glDeleteQueries(kMaxPasses * 2, frames[i].queries);
+    ready = false;
+}
+
+void GpuTimers::beginFrame() {
+    if (!ready) return;
+    stackDepth = 0;
+    frames[current].pending = frames[current].count > 0;
+
+    // Read finished sets oldest first and stop at the first one the GPU hasn't
+    // reached yet, so results always arrive in submission order.
+    for (int i = 1; i <= kLatency; i++) {
+        FrameSet& set = frames[(current + i) % kLatency];
+        if (!set.pending) continue;
+        if (!collect(set)) break;
+    }
+
+    current = (current + 1) % kLatency;
+    // Still unread after kLatency frames: the GPU is that far behind, so drop
+    // this set instead of waiting for it.
+    frames[current].pending = false;
+    frames[current].count = 0;
+
+    if (++framesSinceSync >= 120) syncClocks();
+}
+
+void GpuTimers::begin(const char* name) {
+    FrameSet& set = frames[current];
+    if (!ready || set.count >= kMaxPasses || stackDepth >= kMaxPasses) {
+        // Untimed, but still pushed so the matching end() pops the right
+        // entry; past the stack's size only the depth is counted.
+        if (stackDepth < kMaxPasses) stack[stackDepth] = -1;
+        stackDepth++;
+        return;
+    }
+    int idx = set.count++;
+    set.entries[idx] = { name, findPass(name), (uint32_t)stackDepth };
+    glQueryCounter(set.queries[idx * 2], GL_TIMESTAMP);
+    set.lastQuery = idx * 2;
+    stack[stackDepth++] = idx;
+}
+
+void GpuTimers::end() {
+    if (stackDepth == 0) return;
+    --stackDepth;
+    int idx = stackDepth < kMaxPasses ? stack[stackDepth] : -1;
+    if (idx < 0) return;
+    FrameSet& set = frames[current];
+    glQueryCounter(set.queries[idx * 2 + 1], GL_TIMESTAMP);
+    set.lastQuery = idx * 2 + 1;
+}
+
+bool GpuTimers::collect(FrameSet& set) {
+    // Queries complete in the order they were issued, so if the last one
+    // issued is done they all are. With nesting that is the outermost end,
+    // not the end of the last entry opened.
+    GLint available = 0;
+    glGetQueryObjectiv(set.queries[set.lastQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    float sums[kMaxPasses] = {};
+    bool seen[kMaxPasses] = {};
+    for (int i = 0; i < set.count; i++) {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(set.queries[i * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(set.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        if (end < start) end = start;
+        const Entry& e = set.entries[i];
+        if (e.pass >= 0) {
+            sums[e.pass] += (float)((end - start) / 1e6);
+            seen[e.pass] = true;
+        }
+        profilerRecordZone("GPU", e.name, (uint64_t)((int64_t)start + clockOffsetNs), (uint64_t)((int64_t)end + clockOffsetNs), e.depth);
+    }
+    for (int p = 0; p < numPasses; p++) {
+        if (seen[p]) passes[p].ms.add(sums[p]);
+    }
+    set.pending = false;
+    return true;
+}
+
+void GpuTimers::syncClocks() {
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    clockOffsetNs = (int64_t)profilerNowNs() - (int64_t)gpuNow;
+    framesSinceSync = 0;
+}
+
+int GpuTimers::findPass(const char* name) {
+    for (int i = 0; i < numPasses; i++) {
+        if (passes[i].name == name || strcmp(passes[i].name, name) == 0) return i;
+    }
+    if (numPasses >= kMaxPasses) return -1;
+    passes[numPasses].name = name;
+    return numPasses++;
+}
+
+float GpuTimers::averageMs(const char* name) const {
+    for (int i = 0; i < numPasses; i++) {
+        if (strcmp(passes[i].name, name) == 0) return passes[i].ms.average();
+    }
+    return 0.0f;
+}
+
+float GpuTimers::lastMs(const char* name) const {
+    for (int i = 0; i < numPasses; i++) {
+        if (strcmp(passes[i].name, name) == 0) return passes[i].ms.last();
+    }
+    return 0.0f;
+}
+
+void GpuTimers::drawStats() const {
+    if (!ready) {
+        ImGui::TextDisabled("GPU timers unavailable");
+        return;
+    }
+    ImGui::TextColored(ImVec4(0, 1, 1, 1), "GPU (ms)     avg   p95   p99");
+    for (int i = 0; i < numPasses; i++) {
+        const Pass& p = passes[i];
+        ImGui::Text("%-11s %5.2f %5.2f %5.2f", p.name, p.ms.average(), p.ms.percentile(0.95f), p.ms.percentile(0.99f));
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include "Profiler.h"
+#include "RollingStats.h"
+
+// GPU pass timing with GL_TIMESTAMP queries.
+// Each pass writes a begin/end timestamp into the query set of the current
+// frame. Sets are recycled every kLatency frames, and results are only read
+// once GL_QUERY_RESULT_AVAILABLE says so, so the CPU never waits on the GPU.
+// Timestamps (rather than GL_TIME_ELAPSED) let passes nest and be placed on
+// the profiler timeline.
+class GpuTimers {
+public:
+    static constexpr int kLatency = 3;
+    static constexpr int kMaxPasses = 32;
+
+    struct Pass {
+        const char* name;
+        RollingStats<240> ms;
+    };
+
+    void init();
+    void shutdown();
+
+    // Call once per frame before any begin(); collects finished frames.
+    void beginFrame();
+    void begin(const char* name);
+    void end();
+
+    int passCount() const { return numPasses; }
+    const Pass& pass(int i) const { return passes[i]; }
+    // Rolling average of a pass in ms, or 0 if it hasn't been seen.
+    float averageMs(const char* name) const;
+    // Newest result of a pass in ms (kLatency frames old at best), or 0.
+    float lastMs(const char* name) const;
+
+    // Lists every pass as "name  avg  p95  p99" inside the current ImGui window.
+    void drawStats() const;
+
+private:
+    struct Entry {
+        const char* name;
+        int pass;
+        uint32_t depth;
+    };
+    struct FrameSet {
+        GLuint queries[kMaxPasses * 2];
+        Entry entries[kMaxPasses];
+        int count;
+        int lastQuery;      // index in queries of the last one issued
+        bool pending;
+    };
+
+    FrameSet frames[kLatency] = {};
+    int current = 0;
+    int stack[kMaxPasses];
+    int stackDepth = 0;
+    Pass passes[kMaxPasses];
+    int numPasses = 0;
+    bool ready = false;
+
+    // GPU clock -> profiler clock, refreshed now and then.
+    int64_t clockOffsetNs = 0;
+    int framesSinceSync = 0;
+
+    int findPass(const char* name);
+    bool collect(FrameSet& set);
+    void syncClocks();
+};
+
+GpuTimers& gpuTimers();
+
+// Scoped GPU pass, e.g. GPU_SCOPE("Floor"). Compiled out with the CPU profiler.
+#if ENABLE_PROFILER
+class GpuScope {
+public:
+    explicit GpuScope(const char* name) { gpuTimers().begin(name); }
+    ~GpuScope() { gpuTimers().end(); }
+};
+#define GPU_SCOPE(name) GpuScope PROFILE_CONCAT(gpuScope_, __LINE__)(name)
+#else
+#define GPU_SCOPE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,18 @@
+#include "InputQueue.h"
+#include "Profiler.h"
+
+static std::atomic<uint64_t> droppedEvents{ 0 };
+
+InputQueue& inputQueue() {
+    static InputQueue queue;
+    return queue;
+}
+
+void pushInputEvent(InputEvent e) {
+    e.timeNs = profilerNowNs();
+    if (!inputQueue().push(e)) droppedEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t inputDroppedEvents() {
+    return droppedEvents.load(std::memory_order_relaxed);
+}
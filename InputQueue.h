@@ -0,0 +1,55 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Fixed-size ring for exactly one producer thread and one consumer thread.
+// No locks: each side owns one index and publishes it with a release store,
+// so an item is fully written before the other side can see it.
+template <typename T, uint32_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+public:
+    // Producer. Returns false, dropping v, when the ring is full.
+    bool push(const T& v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false;
+        items[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side from here on.
+    uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed); }
+    // i = 0 is the oldest item; i must be below size().
+    const T& peek(uint32_t i) const { return items[(tail.load(std::memory_order_relaxed) + i) & (N - 1)]; }
+    void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    alignas(64) std::atomic<uint32_t> head{ 0 };   // next slot to write, producer-owned
+    alignas(64) std::atomic<uint32_t> tail{ 0 };   // next slot to read, consumer-owned
+    T items[N];
+};
+
+// Raw mouse input as GLFW delivered it, stamped with profilerNowNs() in the
+// callback. The simulation tick that starts after the stamp owns the event.
+struct InputEvent {
+    enum Type : uint8_t { CursorMove, MouseButton };
+    Type type;
+    int button, action;    // MouseButton: GLFW_MOUSE_BUTTON_*, GLFW_PRESS / GLFW_RELEASE
+    float x, y;            // CursorMove: window coordinates
+    uint64_t timeNs;
+};
+
+using InputQueue = SpscQueue<InputEvent, 1024>;
+
+// Filled by the GLFW callbacks (mouse_callback, mouse_button_callback),
+// drained by consumeInput() at the start of each tick.
+InputQueue& inputQueue();
+// Stamps and queues an event; counts it in inputDroppedEvents() when full.
+void pushInputEvent(InputEvent e);
+uint64_t inputDroppedEvents();
+
+#endif
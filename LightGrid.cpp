@@ -0,0 +1,173 @@
+#include "LightGrid.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+static_assert(LightGrid::kTilesX % 4 == 0, "tile rows are tested four clusters at a time");
+static_assert(LightGrid::kClusters < 65536 && LightGrid::kMaxLights <= 65536, "hits pack light and cluster into 16 bits each");
+
+LightGrid& lightGrid() {
+    static LightGrid grid;
+    return grid;
+}
+
+void LightGrid::initGL() {
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+    const GLenum formats[3] = { GL_RG32UI, GL_R16UI, GL_RGBA32F };
+    const GLsizeiptr sizes[3] = { kClusters * 2 * sizeof(uint32_t), kMaxRefs * sizeof(uint16_t), kMaxLights * 2 * sizeof(glm::vec4) };
+    for (int i = 0; i < 3; i++) {
+        glState().bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizes[i], nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glState().bindBuffer(GL_TEXTURE_BUFFER, 0);
+    ranges.assign(kClusters * 2, 0);
+    indices.reserve(kMaxRefs);
+    hits.reserve(kMaxRefs);
+    packed.reserve(kMaxLights * 2);
+}
+
+void LightGrid::add(const glm::vec3& pos, float radius, const glm::vec3& color) {
+    if ((int)lights.size() >= kMaxLights) return;
+    lights.push_back({ pos, radius, color });
+}
+
+// Cluster boxes only change with the projection, so they're rebuilt on a
+// resize rather than every frame.
+void LightGrid::buildClusters(float fovy, float aspect, float zNear, float zFar) {
+    clusterFovy = fovy;
+    clusterAspect = aspect;
+    clusterNear = zNear;
+    clusterFar = zFar;
+    for (auto* v : { &minX, &maxX, &minY, &maxY, &minZ, &maxZ }) v->resize(kClusters);
+
+    float tanY = std::tan(fovy * 0.5f), tanX = tanY * aspect;
+    for (int s = 0; s < kSlices; s++) {
+        // Exponential slices: each is the same fraction deeper than the last.
+        float d0 = zNear * std::pow(zFar / zNear, (float)s / kSlices);
+        float d1 = zNear * std::pow(zFar / zNear, (float)(s + 1) / kSlices);
+        for (int ty = 0; ty < kTilesY; ty++) {
+            float y0 = (-1.0f + 2.0f * ty / kTilesY) * tanY, y1 = (-1.0f + 2.0f * (ty + 1) / kTilesY) * tanY;
+            for (int tx = 0; tx < kTilesX; tx++) {
+                float x0 = (-1.0f + 2.0f * tx / kTilesX) * tanX, x1 = (-1.0f + 2.0f * (tx + 1) / kTilesX) * tanX;
+                int c = (s * kTilesY + ty) * kTilesX + tx;
+                // A tile's side planes pass through the eye, so the box spans
+                // the tile's corners at both depths.
+                minX[c] = std::min(x0 * d0, x0 * d1);
+                maxX[c] = std::max(x1 * d0, x1 * d1);
+                minY[c] = std::min(y0 * d0, y0 * d1);
+                maxY[c] = std::max(y1 * d0, y1 * d1);
+                minZ[c] = d0;
+                maxZ[c] = d1;
+            }
+        }
+    }
+}
+
+void LightGrid::build(const glm::mat4& view, float fovy, float aspect, float zNear, float zFar) {
+    PROFILE_SCOPE("Light grid");
+    if (fovy != clusterFovy || aspect != clusterAspect || zNear != clusterNear || zFar != clusterFar) {
+        buildClusters(fovy, aspect, zNear, zFar);
+    }
+
+    // 1. Sphere vs cluster boxes, one slice range per light.
+    hits.clear();
+    float sliceScale = kSlices / std::log(zFar / zNear);
+    for (size_t li = 0; li < lights.size(); li++) {
+        const Light& light = lights[li];
+        glm::vec3 v = glm::vec3(view * glm::vec4(light.pos, 1.0f));
+        float depth = -v.z, r = light.radius;
+        if (depth + r < zNear || depth - r > zFar) continue;
+        int s0 = depth - r <= zNear ? 0 : (int)(std::log((depth - r) / zNear) * sliceScale);
+        int s1 = std::min((int)(std::log(std::max(depth + r, zNear) / zNear) * sliceScale), kSlices - 1);
+        float r2 = r * r;
+#if SIMD_SSE2
+        __m128 cx = _mm_set1_ps(v.x), cy = _mm_set1_ps(v.y), cz = _mm_set1_ps(depth);
+        __m128 vr2 = _mm_set1_ps(r2), zero = _mm_setzero_ps();
+#endif
+        for (int s = std::max(s0, 0); s <= s1; s++) {
+            for (int ty = 0; ty < kTilesY; ty++) {
+                int row = (s * kTilesY + ty) * kTilesX;
+                for (int tx = 0; tx < kTilesX; tx += 4) {
+                    int c = row + tx;
+#if SIMD_SSE2
+                    // Distance from the centre to each box: zero inside, else the overshoot.
+                    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[c]), cx), _mm_sub_ps(cx, _mm_loadu_ps(&maxX[c]))), zero);
+                    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[c]), cy), _mm_sub_ps(cy, _mm_loadu_ps(&maxY[c]))), zero);
+                    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[c]), cz), _mm_sub_ps(cz, _mm_loadu_ps(&maxZ[c]))), zero);
+                    __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(d2, vr2));
+#else
+                    int mask = 0;
+                    for (int k = 0; k < 4; k++) {
+                        float dx = std::max(std::max(minX[c + k] - v.x, v.x - maxX[c + k]), 0.0f);
+                        float dy = std::max(std::max(minY[c + k] - v.y, v.y - maxY[c + k]), 0.0f);
+                        float dz = std::max(std::max(minZ[c + k] - depth, depth - maxZ[c + k]), 0.0f);
+                        if (dx * dx + dy * dy + dz * dz <= r2) mask |= 1 << k;
+                    }
+#endif
+                    for (int k = 0; mask; k++, mask >>= 1) {
+                        if (mask & 1) hits.push_back(((uint32_t)li << 16) | (uint32_t)(c + k));
+                    }
+                }
+            }
+        }
+    }
+    if ((int)hits.size() > kMaxRefs) hits.resize(kMaxRefs); // later lights lose out
+
+    // 2. Counting sort into per-cluster lists; lights stay in order within a cluster.
+    std::fill(ranges.begin(), ranges.end(), 0);
+    for (uint32_t h : hits) ranges[(h & 0xffff) * 2 + 1]++;
+    uint32_t offset = 0;
+    maxCount = 0;
+    for (int c = 0; c < kClusters; c++) {
+        ranges[c * 2] = offset;
+        offset += ranges[c * 2 + 1];
+        maxCount = std::max(maxCount, (int)ranges[c * 2 + 1]);
+    }
+    refs = (int)hits.size();
+    indices.resize(refs);
+    for (int c = 0; c < kClusters; c++) ranges[c * 2 + 1] = 0;
+    for (uint32_t h : hits) {
+        uint32_t c = h & 0xffff;
+        indices[ranges[c * 2] + ranges[c * 2 + 1]++] = (uint16_t)(h >> 16);
+    }
+
+    packed.clear();
+    for (const Light& l : lights) {
+        packed.push_back(glm::vec4(l.pos, l.radius));
+        packed.push_back(glm::vec4(l.color, 0.0f));
+    }
+
+    // 3. Upload, orphaning last frame's storage so the driver never waits on it.
+    PROFILE_SCOPE("Light upload");
+    const void* data[3] = { ranges.data(), indices.data(), packed.data() };
+    const GLsizeiptr sizes[3] = { kClusters * 2 * sizeof(uint32_t), kMaxRefs * sizeof(uint16_t), kMaxLights * 2 * sizeof(glm::vec4) };
+    const GLsizeiptr used[3] = { sizes[0], refs * (GLsizeiptr)sizeof(uint16_t), (GLsizeiptr)(packed.size() * sizeof(glm::vec4)) };
+    for (int i = 0; i < 3; i++) {
+        glState().bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizes[i], nullptr, GL_STREAM_DRAW);
+        if (used[i] > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, used[i], data[i]);
+    }
+    glState().bindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightGrid::bind(Shader& shader, int firstUnit, const glm::vec2& viewport) const {
+    const char* samplers[3] = { "clusterLights", "lightIndices", "lightData" };
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        shader.setInt(samplers[i], firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    float sliceScale = kSlices / std::log(clusterFar / clusterNear);
+    glState().uniform3i(glGetUniformLocation(shader.ID, "clusterDims"), kTilesX, kTilesY, kSlices);
+    shader.setVec2("clusterTile", viewport / glm::vec2(kTilesX, kTilesY));
+    shader.setVec4("clusterDepth", glm::vec4(clusterNear, clusterFar, sliceScale, std::log(clusterNear) * sliceScale));
+}
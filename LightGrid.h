@@ -0,0 +1,73 @@
+#ifndef LIGHT_GRID_H
+#define LIGHT_GRID_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Shader;
+
+// Clustered forward lighting. The view frustum is cut into kTilesX x kTilesY
+// screen tiles and kSlices exponential depth slices; every frame the CPU tests
+// each point light's sphere against the clusters' view-space boxes (four at a
+// time with SSE) and builds per-cluster light lists. Those go to the shader as
+// texture buffers (GL 3.3 has no SSBOs):
+//   clusterLights  RG32UI  per cluster: offset into lightIndices, count
+//   lightIndices   R16UI   light index per cluster entry
+//   lightData      RGBA32F two texels per light: world pos + radius, color
+// A fragment finds its cluster from gl_FragCoord and only shades the lights
+// listed there, so its cost follows the local light count, not the total.
+class LightGrid {
+public:
+    static constexpr int kTilesX = 16;
+    static constexpr int kTilesY = 9;
+    static constexpr int kSlices = 24;
+    static constexpr int kClusters = kTilesX * kTilesY * kSlices;
+    static constexpr int kMaxLights = 256;
+    static constexpr int kMaxRefs = 32768;   // cluster entries; lights past this are dropped
+
+    struct Light {
+        glm::vec3 pos;
+        float radius;
+        glm::vec3 color;
+    };
+
+    // Needs a GL context.
+    void initGL();
+
+    // Collect the frame's lights, then build. add() ignores lights past kMaxLights.
+    void clear() { lights.clear(); }
+    void add(const glm::vec3& pos, float radius, const glm::vec3& color);
+    // fovy in radians, near/far as in the projection. Uploads the buffers.
+    void build(const glm::mat4& view, float fovy, float aspect, float zNear, float zFar);
+    // Binds the buffers to texture units firstUnit..firstUnit+2 and sets the
+    // cluster uniforms of default.frag. viewport is the framebuffer size.
+    void bind(Shader& shader, int firstUnit, const glm::vec2& viewport) const;
+
+    int lightCount() const { return (int)lights.size(); }
+    int refCount() const { return refs; }
+    int maxPerCluster() const { return maxCount; }
+
+private:
+    void buildClusters(float fovy, float aspect, float zNear, float zFar);
+
+    std::vector<Light> lights;
+
+    // Cluster boxes in view space, depth positive into the screen, SoA so a
+    // row of tiles tests four at a time.
+    std::vector<float> minX, maxX, minY, maxY, minZ, maxZ;
+    float clusterFovy = 0.0f, clusterAspect = 0.0f, clusterNear = 0.0f, clusterFar = 0.0f;
+
+    std::vector<uint32_t> hits;          // (light << 16) | cluster, in light order
+    std::vector<uint32_t> ranges;        // offset, count per cluster
+    std::vector<uint16_t> indices;
+    std::vector<glm::vec4> packed;
+    int refs = 0, maxCount = 0;
+
+    GLuint buffers[3] = {}, textures[3] = {};
+};
+
+LightGrid& lightGrid();
+
+#endif
@@ -1,5 +1,8 @@
 #include <glad/glad.h>
 #include <vector>
+#include "common.h"
+#include "CommandBuffer.h"
+#include "GLState.h"
 #include <numeric>
 
 class Mesh {
@@ -23,7 +26,7 @@ public:
 
         // Create and bind the Instance VBO
         glGenBuffers(1, &iVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, iVBO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, iVBO);
 
         // We initialize with NULL because we update this every frame in the loop
         glBufferData(GL_ARRAY_BUFFER, 1000 * instanceSize, NULL, GL_DYNAMIC_DRAW);
@@ -50,18 +53,24 @@ public:
         glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, instanceSize, (void*)28);
         glVertexAttribDivisor(5, 1);
 
-        glBindVertexArray(0);
+        glState().bindVertexArray(0);
     }
 
     // Update the enemy data on the GPU every frame
     void updateInstances(void* data, size_t size) {
         if (!isInstanced) return;
-        glBindBuffer(GL_ARRAY_BUFFER, iVBO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, iVBO);
         glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
     }
+    // Same, recorded: the data is copied into cmds.
+    void updateInstances(CommandBuffer& cmds, const void* data, size_t size) const {
+        if (!isInstanced) return;
+        cmds.bufferData(GL_ARRAY_BUFFER, iVBO, data, size, GL_DYNAMIC_DRAW);
+    }
 
     void draw(int count = 0, GLenum mode = GL_TRIANGLES) {
-        glBindVertexArray(VAO);
+        frameDrawCalls++;
+        glState().bindVertexArray(VAO);
         if (isInstanced && count > 0) {
             glDrawArraysInstanced(mode, 0, vertexCount, count);
         }
@@ -69,6 +78,15 @@ public:
             glDrawArrays(mode, 0, vertexCount);
         }
     }
+    void draw(CommandBuffer& cmds, int count = 0, GLenum mode = GL_TRIANGLES) const {
+        cmds.bindVertexArray(VAO);
+        if (isInstanced && count > 0) {
+            cmds.drawArraysInstanced(mode, 0, vertexCount, count);
+        }
+        else {
+            cmds.drawArrays(mode, 0, vertexCount);
+        }
+    }
 
 private:
     void setupBaseMesh(float* vertices, size_t dataSize, std::vector<int> layout) {
@@ -78,8 +96,8 @@ private:
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, dataSize, vertices, GL_STATIC_DRAW);
 
         int stride = floatsPerVertex * sizeof(float);
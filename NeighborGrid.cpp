@@ -0,0 +1,117 @@
+#include "NeighborGrid.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr float kPadding = 1e18f;  // far enough that padded lanes never pass the radius test
+    constexpr float kMinDist2 = 1e-8f; // skips the point itself (and exact duplicates)
+}
+
+void NeighborGrid::build(const float* x, const float* z, int n, float r) {
+    PROFILE_SCOPE("Neighbor grid build");
+    count = n;
+    radius = r;
+    if (n == 0) return;
+
+    float maxX = x[0], maxZ = z[0];
+    minX = x[0];
+    minZ = z[0];
+    for (int i = 1; i < n; i++) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minZ = std::min(minZ, z[i]);
+        maxZ = std::max(maxZ, z[i]);
+    }
+    // Cells are at least radius wide so a query only needs the 3x3 around it;
+    // widen them if the swarm is spread out so the table stays small.
+    float extent = std::max(maxX - minX, maxZ - minZ);
+    float cell = std::max(r, extent / (kMaxCellsPerSide - 1));
+    invCell = 1.0f / cell;
+    dimX = (int)((maxX - minX) * invCell) + 1;
+    dimZ = (int)((maxZ - minZ) * invCell) + 1;
+
+    // Counting sort by cell. Counts become end offsets, then the backwards
+    // scatter walks each one down to the cell's start.
+    int cells = dimX * dimZ;
+    cellStart.assign(cells + 1, 0);
+    pointCell.resize(n);
+    order.resize(n);
+    sx.resize(n + 3);
+    sz.resize(n + 3);
+    for (int i = 0; i < n; i++) pointCell[i] = cellIndex(x[i], z[i]);
+    for (int i = 0; i < n; i++) cellStart[pointCell[i]]++;
+    for (int c = 1; c <= cells; c++) cellStart[c] += cellStart[c - 1];
+    for (int i = n - 1; i >= 0; i--) order[--cellStart[pointCell[i]]] = i;
+    for (int s = 0; s < n; s++) {
+        int i = order[s];
+        sx[s] = x[i];
+        sz[s] = z[i];
+    }
+    for (int s = 0; s < n; s++) pointCell[s] = cellIndex(sx[s], sz[s]);
+    for (int p = n; p < n + 3; p++) sx[p] = sz[p] = kPadding;
+}
+
+int NeighborGrid::cellIndex(float x, float z) const {
+    int cx = std::min(dimX - 1, (int)((x - minX) * invCell));
+    int cz = std::min(dimZ - 1, (int)((z - minZ) * invCell));
+    return cz * dimX + cx;
+}
+
+void NeighborGrid::separation(float* outX, float* outZ) const {
+    PROFILE_SCOPE("Neighbor grid query");
+    for (int s = 0; s < count; s++) {
+        float px = sx[s], pz = sz[s];
+        int cx = pointCell[s] % dimX, cz = pointCell[s] / dimX;
+        int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, dimX - 1);
+        float fx = 0.0f, fz = 0.0f;
+
+#if SIMD_SSE2
+        __m128 vpx = _mm_set1_ps(px), vpz = _mm_set1_ps(pz);
+        __m128 vr = _mm_set1_ps(radius), vr2 = _mm_set1_ps(radius * radius);
+        __m128 vmin = _mm_set1_ps(kMinDist2), one = _mm_set1_ps(1.0f);
+        __m128 accX = _mm_setzero_ps(), accZ = _mm_setzero_ps();
+#endif
+        for (int row = std::max(cz - 1, 0); row <= std::min(cz + 1, dimZ - 1); row++) {
+            // The three cells of a row are adjacent in sorted order: one run.
+            int begin = cellStart[row * dimX + x0];
+            int end = cellStart[row * dimX + x1 + 1];
+#if SIMD_SSE2
+            __m128i vend = _mm_set1_epi32(end);
+            for (int j = begin; j < end; j += 4) {
+                __m128 dx = _mm_sub_ps(vpx, _mm_loadu_ps(&sx[j]));
+                __m128 dz = _mm_sub_ps(vpz, _mm_loadu_ps(&sz[j]));
+                __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+                __m128i lane = _mm_add_epi32(_mm_set1_epi32(j), _mm_setr_epi32(0, 1, 2, 3));
+                __m128 mask = _mm_and_ps(_mm_cmplt_ps(d2, vr2), _mm_cmpgt_ps(d2, vmin));
+                mask = _mm_and_ps(mask, _mm_castsi128_ps(_mm_cmplt_epi32(lane, vend)));
+                // (r - d) / d = r / d - 1; lanes outside the mask are zeroed
+                // before they touch the accumulators, so inf/NaN there is harmless.
+                __m128 w = _mm_sub_ps(_mm_mul_ps(vr, _mm_rsqrt_ps(d2)), one);
+                w = _mm_and_ps(w, mask);
+                accX = _mm_add_ps(accX, _mm_mul_ps(w, dx));
+                accZ = _mm_add_ps(accZ, _mm_mul_ps(w, dz));
+            }
+#else
+            for (int j = begin; j < end; j++) {
+                float dx = px - sx[j], dz = pz - sz[j];
+                float d2 = dx * dx + dz * dz;
+                if (d2 >= radius * radius || d2 <= kMinDist2) continue;
+                float w = radius / sqrtf(d2) - 1.0f;
+                fx += w * dx;
+                fz += w * dz;
+            }
+#endif
+        }
+#if SIMD_SSE2
+        alignas(16) float lx[4], lz[4];
+        _mm_store_ps(lx, accX);
+        _mm_store_ps(lz, accZ);
+        fx = (lx[0] + lx[1]) + (lx[2] + lx[3]);
+        fz = (lz[0] + lz[1]) + (lz[2] + lz[3]);
+#endif
+        outX[order[s]] = fx;
+        outZ[order[s]] = fz;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef NEIGHBOR_GRID_H
+#define NEIGHBOR_GRID_H
+
+#include <vector>
+
+// Cell-linked uniform grid on the x/z plane for fixed-radius neighbour queries.
+// build() counting-sorts the points by cell (cell size >= radius) and keeps a
+// sorted copy of the positions, so the 3x3 cells around a point are three
+// contiguous runs of memory. Build and query are both O(N) for a bounded density.
+class NeighborGrid {
+public:
+    static constexpr int kMaxCellsPerSide = 256;
+
+    void build(const float* x, const float* z, int count, float radius);
+
+    // Per point, the sum of (radius - d) / d * (p - q) over every neighbour q
+    // within radius: a push away from each overlap, growing as they get closer.
+    // Outputs are in the order the points were given to build().
+    void separation(float* outX, float* outZ) const;
+
+    int size() const { return count; }
+
+private:
+    float radius = 1.0f;
+    float invCell = 1.0f;
+    float minX = 0.0f, minZ = 0.0f;
+    int dimX = 0, dimZ = 0;
+    int count = 0;
+    std::vector<int> cellStart;   // dimX * dimZ + 1 prefix sums
+    std::vector<int> pointCell;   // sorted slot -> cell
+    std::vector<int> order;       // sorted slot -> original index
+    std::vector<float> sx, sz;    // positions by sorted slot, padded for 4-wide loads
+
+    int cellIndex(float x, float z) const;
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "OcclusionCuller.h"
+#include "TriangleBVH.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    constexpr int kRowsPerBand = OcclusionCuller::kHeight / OcclusionCuller::kBands;
+    constexpr int kTilesX = OcclusionCuller::kWidth / OcclusionCuller::kTile;
+    constexpr int kTilesY = OcclusionCuller::kHeight / OcclusionCuller::kTile;
+    constexpr float kNearW = 0.1f;   // the camera's near plane; anything closer is skipped (occluders) or kept (tests)
+
+    static_assert(OcclusionCuller::kWidth % 4 == 0, "rows are rasterized four pixels at a time");
+    static_assert(kRowsPerBand % OcclusionCuller::kTile == 0, "bands hold whole tile rows");
+
+    const int kBoxTris[12][3] = {
+        { 0, 1, 3 }, { 0, 3, 2 }, { 4, 6, 7 }, { 4, 7, 5 },   // -x, +x
+        { 0, 4, 5 }, { 0, 5, 1 }, { 2, 3, 7 }, { 2, 7, 6 },   // -y, +y
+        { 0, 2, 6 }, { 0, 6, 4 }, { 1, 5, 7 }, { 1, 7, 3 },   // -z, +z
+    };
+
+    glm::vec3 boxCorner(const glm::vec3& min, const glm::vec3& max, int i) {
+        return glm::vec3(i & 4 ? max.x : min.x, i & 2 ? max.y : min.y, i & 1 ? max.z : min.z);
+    }
+}
+
+OcclusionCuller& occlusionCuller() {
+    static OcclusionCuller culler;
+    return culler;
+}
+
+OcclusionCuller::Proxy OcclusionCuller::makeProxy(const TriangleBVH& bvh, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    Proxy proxy;
+    if (bvh.empty() || boundsMin.x > boundsMax.x) return proxy;
+    glm::vec3 centre = (boundsMin + boundsMax) * 0.5f;
+    float reach = glm::length(boundsMax - boundsMin) + 1.0f;
+
+    // 1. How far the surface is along each axis, both ways.
+    for (int axis = 0; axis < 3; axis++) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            glm::vec3 dir(0.0f);
+            dir[axis] = (float)sign;
+            TriangleBVH::Hit hit;
+            if (!bvh.raycast(centre, dir, reach, hit)) return proxy; // open mesh, or hollow at the centre
+            (sign < 0 ? proxy.min : proxy.max)[axis] = centre[axis] + sign * hit.t;
+        }
+    }
+
+    // 2. Shrink towards the centre until no corner pokes through the surface.
+    // Exact for convex meshes: a corner is inside iff the way out to it is
+    // clear. Each step shrinks the one axis that brings the worst corner
+    // furthest back in, so a cylinder keeps its height and loses only width.
+    auto clearance = [&](const glm::vec3& min, const glm::vec3& max) {
+        float worst = 1.0f;
+        for (int i = 0; i < 8; i++) {
+            TriangleBVH::Hit hit;
+            if (bvh.segment(centre, boxCorner(min, max, i), hit)) worst = std::min(worst, hit.t);
+        }
+        return worst;
+    };
+    for (int attempt = 0; attempt < 64; attempt++) {
+        if (clearance(proxy.min, proxy.max) >= 1.0f) {
+            proxy.valid = true;
+            return proxy;
+        }
+        int bestAxis = 0;
+        float best = -1.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            glm::vec3 min = proxy.min, max = proxy.max;
+            min[axis] = centre[axis] + (min[axis] - centre[axis]) * 0.9f;
+            max[axis] = centre[axis] + (max[axis] - centre[axis]) * 0.9f;
+            float c = clearance(min, max);
+            if (c > best) {
+                best = c;
+                bestAxis = axis;
+            }
+        }
+        proxy.min[bestAxis] = centre[bestAxis] + (proxy.min[bestAxis] - centre[bestAxis]) * 0.9f;
+        proxy.max[bestAxis] = centre[bestAxis] + (proxy.max[bestAxis] - centre[bestAxis]) * 0.9f;
+    }
+    return proxy;
+}
+
+OcclusionCuller::OcclusionCuller() : depth(kWidth * kHeight, 0.0f), tiles(kTilesX * kTilesY, 0.0f) {
+    for (int band = 1; band < kBands; band++) workers.emplace_back(&OcclusionCuller::run, this, band);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+void OcclusionCuller::begin(const glm::mat4& vp) {
+    viewProjection = vp;
+    tris.clear();
+}
+
+void OcclusionCuller::addOccluder(const Proxy& proxy, const glm::mat4& model) {
+    if (!proxy.valid) return;
+    glm::mat4 m = viewProjection * model;
+    Vertex v[8];
+    bool inFront[8];
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 clip = m * glm::vec4(boxCorner(proxy.min, proxy.max, i), 1.0f);
+        inFront[i] = clip.w > kNearW;
+        float iw = 1.0f / std::max(clip.w, kNearW);
+        v[i] = { (clip.x * iw * 0.5f + 0.5f) * kWidth, (clip.y * iw * 0.5f + 0.5f) * kHeight, iw };
+    }
+    // Triangles crossing the near plane are dropped rather than clipped: fewer
+    // occluders only ever means less culling.
+    for (auto& t : kBoxTris) {
+        if (!inFront[t[0]] || !inFront[t[1]] || !inFront[t[2]]) continue;
+        tris.push_back(v[t[0]]);
+        tris.push_back(v[t[1]]);
+        tris.push_back(v[t[2]]);
+    }
+}
+
+void OcclusionCuller::render() {
+    PROFILE_SCOPE("Occlusion raster");
+    uint64_t start = profilerNowNs();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        pending = kBands - 1;
+    }
+    cv.notify_all();
+    rasterizeBand(0);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCv.wait(lock, [this] { return pending == 0; });
+    }
+    renderMs = (profilerNowNs() - start) / 1e6f;
+}
+
+void OcclusionCuller::run(int band) {
+    PROFILE_THREAD("Occlusion");
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        rasterizeBand(band);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) doneCv.notify_one();
+    }
+}
+
+void OcclusionCuller::rasterizeBand(int band) {
+    int rowBegin = band * kRowsPerBand, rowEnd = rowBegin + kRowsPerBand;
+    std::fill(depth.begin() + rowBegin * kWidth, depth.begin() + rowEnd * kWidth, 0.0f);
+
+    for (size_t i = 0; i < tris.size(); i += 3) {
+        Vertex a = tris[i], b = tris[i + 1], c = tris[i + 2];
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (fabsf(area) < 1e-6f) continue;
+        if (area < 0.0f) {
+            std::swap(b, c);
+            area = -area;
+        }
+        // Clamp while still in float: vertices near the camera land far off screen.
+        int x0 = (int)std::clamp(floorf(std::min({ a.x, b.x, c.x })), 0.0f, (float)kWidth);
+        int x1 = (int)std::clamp(ceilf(std::max({ a.x, b.x, c.x })), -1.0f, (float)(kWidth - 1));
+        int y0 = (int)std::clamp(floorf(std::min({ a.y, b.y, c.y })), (float)rowBegin, (float)rowEnd);
+        int y1 = (int)std::clamp(ceilf(std::max({ a.y, b.y, c.y })), (float)(rowBegin - 1), (float)(rowEnd - 1));
+        if (x0 > x1 || y0 > y1) continue;
+
+        // Edge functions and 1/w as planes A*x + B*y + C over pixel centres.
+        // Each edge is >= 0 on the triangle's side.
+        const Vertex* from[3] = { &b, &c, &a };
+        const Vertex* to[3] = { &c, &a, &b };
+        float eA[3], eB[3], eC[3];
+        for (int e = 0; e < 3; e++) {
+            eA[e] = -(to[e]->y - from[e]->y);
+            eB[e] = to[e]->x - from[e]->x;
+            eC[e] = (to[e]->y - from[e]->y) * from[e]->x - (to[e]->x - from[e]->x) * from[e]->y;
+        }
+        float inv = 1.0f / area;
+        float zA = (eA[0] * a.iw + eA[1] * b.iw + eA[2] * c.iw) * inv;
+        float zB = (eB[0] * a.iw + eB[1] * b.iw + eB[2] * c.iw) * inv;
+        float zC = (eC[0] * a.iw + eC[1] * b.iw + eC[2] * c.iw) * inv;
+
+        int xStart = x0 & ~3;
+        for (int y = y0; y <= y1; y++) {
+            float py = y + 0.5f;
+            float* row = &depth[y * kWidth];
+#if SIMD_SSE2
+            __m128 px = _mm_add_ps(_mm_set1_ps(xStart + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+            const __m128 zero = _mm_setzero_ps();
+            __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(eA[0]), px), _mm_set1_ps(eB[0] * py + eC[0]));
+            __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(eA[1]), px), _mm_set1_ps(eB[1] * py + eC[1]));
+            __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(eA[2]), px), _mm_set1_ps(eB[2] * py + eC[2]));
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), _mm_set1_ps(zB * py + zC));
+            const __m128 w0Step = _mm_set1_ps(eA[0] * 4.0f), w1Step = _mm_set1_ps(eA[1] * 4.0f);
+            const __m128 w2Step = _mm_set1_ps(eA[2] * 4.0f), zStep = _mm_set1_ps(zA * 4.0f);
+            for (int x = xStart; x <= x1; x += 4) {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+                if (_mm_movemask_ps(inside)) {
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 nearer = _mm_max_ps(old, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+                }
+                w0 = _mm_add_ps(w0, w0Step);
+                w1 = _mm_add_ps(w1, w1Step);
+                w2 = _mm_add_ps(w2, w2Step);
+                z = _mm_add_ps(z, zStep);
+            }
+#else
+            for (int x = x0; x <= x1; x++) {
+                float px = x + 0.5f;
+                if (eA[0] * px + eB[0] * py + eC[0] < 0.0f) continue;
+                if (eA[1] * px + eB[1] * py + eC[1] < 0.0f) continue;
+                if (eA[2] * px + eB[2] * py + eC[2] < 0.0f) continue;
+                row[x] = std::max(row[x], zA * px + zB * py + zC);
+            }
+#endif
+        }
+    }
+
+    // Tile level: the farthest pixel of each tile in this band.
+    for (int ty = rowBegin / kTile; ty < rowEnd / kTile; ty++) {
+        for (int tx = 0; tx < kTilesX; tx++) {
+            float farthest = FLT_MAX;
+            for (int y = ty * kTile; y < (ty + 1) * kTile; y++) {
+                const float* row = &depth[y * kWidth + tx * kTile];
+                for (int x = 0; x < kTile; x++) farthest = std::min(farthest, row[x]);
+            }
+            tiles[ty * kTilesX + tx] = farthest;
+        }
+    }
+}
+
+bool OcclusionCuller::occluded(const glm::vec3& min, const glm::vec3& max) const {
+    if (tris.empty()) return false;
+    float x0 = 1e30f, y0 = 1e30f, x1 = -1e30f, y1 = -1e30f, nearest = 0.0f;
+    // Corners as one transformed corner plus transformed edge vectors.
+    glm::vec4 base = viewProjection * glm::vec4(min, 1.0f);
+    glm::vec3 size = max - min;
+    glm::vec4 ex = viewProjection[0] * size.x, ey = viewProjection[1] * size.y, ez = viewProjection[2] * size.z;
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 clip = base;
+        if (i & 4) clip += ex;
+        if (i & 2) clip += ey;
+        if (i & 1) clip += ez;
+        if (clip.w <= kNearW) return false; // reaches the camera
+        float iw = 1.0f / clip.w;
+        float x = (clip.x * iw * 0.5f + 0.5f) * kWidth, y = (clip.y * iw * 0.5f + 0.5f) * kHeight;
+        x0 = std::min(x0, x); x1 = std::max(x1, x);
+        y0 = std::min(y0, y); y1 = std::max(y1, y);
+        nearest = std::max(nearest, iw);
+    }
+    if (x1 < 0.0f || y1 < 0.0f || x0 >= kWidth || y0 >= kHeight) return false; // off screen: the GPU clips it anyway
+    // Pad a pixel so edge pixels the occluder only half covers don't count.
+    int tx0 = (int)std::max(x0 - 1.0f, 0.0f) / kTile, tx1 = (int)std::min(x1 + 1.0f, kWidth - 1.0f) / kTile;
+    int ty0 = (int)std::max(y0 - 1.0f, 0.0f) / kTile, ty1 = (int)std::min(y1 + 1.0f, kHeight - 1.0f) / kTile;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            if (tiles[ty * kTilesX + tx] <= nearest) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TriangleBVH;
+
+// CPU occlusion culling. Each frame the big opaque things (pillars, emersons)
+// are drawn as boxes that fit inside their meshes into a small software depth
+// buffer, and instance bounds are tested against it before the instance
+// buffers are built.
+//
+// The buffer stores 1/w per pixel (0 = nothing drawn, larger = nearer), which
+// is affine in screen space. It is split into horizontal bands rasterized in
+// parallel: the main thread takes the first band and a few workers the rest,
+// each running the whole occluder list clipped to its rows, four pixels at a
+// time with SSE2. Each band then reduces its kTile x kTile tiles to their
+// farthest value, and tests only read that tile level: a box is hidden if its
+// nearest point is behind the farthest occluder pixel of every tile it covers.
+class OcclusionCuller {
+public:
+    static constexpr int kWidth = 320;
+    static constexpr int kHeight = 192;
+    static constexpr int kTile = 8;
+    static constexpr int kBands = 4;
+
+    // Occluder shape in model space: a box that lies inside the mesh.
+    struct Proxy {
+        glm::vec3 min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+        bool valid = false;
+    };
+    // Probes a mesh outwards from its centre with rays to find a box inside it.
+    // Not valid for meshes that aren't solid around their centre.
+    static Proxy makeProxy(const TriangleBVH& bvh, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    void begin(const glm::mat4& viewProjection);
+    void addOccluder(const Proxy& proxy, const glm::mat4& model);
+    // Rasterizes the occluders and builds the tile level. Tests are valid after this.
+    void render();
+
+    // True if the world-space box is certainly hidden.
+    bool occluded(const glm::vec3& min, const glm::vec3& max) const;
+
+    int occluderCount() const { return (int)(tris.size() / 3); }
+    float lastRenderMs() const { return renderMs; }
+
+private:
+    // Screen-space vertex: pixel x, y and 1/w.
+    struct Vertex {
+        float x, y, iw;
+    };
+
+    void rasterizeBand(int band);
+    void run(int band);
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<Vertex> tris;   // three per triangle, already in front of the near plane
+    std::vector<float> depth;   // kWidth * kHeight
+    std::vector<float> tiles;   // farthest 1/w per tile
+    float renderMs = 0.0f;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable cv, doneCv;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool quit = false;
+};
+
+OcclusionCuller& occlusionCuller();
+
+#endif
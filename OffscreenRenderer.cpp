@@ -0,0 +1,170 @@
+#include "OffscreenRenderer.h"
+#include "common.h"
+#include "GpuTimer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    void printUsage() {
+        std::cerr << "usage: --offscreen [--frames N] [--size WxH] [--dump-frames dir] [--dump-every N] [--no-hud]" << std::endl;
+    }
+
+    void applyContextHints() {
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+}
+
+bool parseOffscreenArgs(int argc, char** argv, OffscreenOptions& opts) {
+    bool malformed = false;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--offscreen") == 0) opts.enabled = true;
+        else if (strcmp(arg, "--frames") == 0 && hasValue) opts.frames = atoi(argv[++i]);
+        else if (strcmp(arg, "--size") == 0 && hasValue) malformed |= sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2;
+        else if (strcmp(arg, "--dump-frames") == 0 && hasValue) opts.dumpDir = argv[++i];
+        else if (strcmp(arg, "--dump-every") == 0 && hasValue) opts.dumpEvery = atoi(argv[++i]);
+        else if (strcmp(arg, "--no-hud") == 0) opts.hud = false;
+    }
+    if (!opts.enabled) return true;
+    if (malformed || opts.frames <= 0 || opts.width <= 0 || opts.height <= 0 || opts.dumpEvery <= 0) {
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+GLFWwindow* createOffscreenWindow(int width, int height, const char** api) {
+    // The null platform needs no display server. Its window is only a size;
+    // the context is a surfaceless EGL one or an OSMesa one, whichever loads.
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (glfwInit()) {
+        const struct { int creationApi; const char* name; } apis[] = {
+            { GLFW_EGL_CONTEXT_API, "EGL (surfaceless)" },
+            { GLFW_OSMESA_CONTEXT_API, "OSMesa" },
+        };
+        for (const auto& a : apis) {
+            applyContextHints();
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, a.creationApi);
+            GLFWwindow* w = glfwCreateWindow(width, height, "OpenGL HUD (offscreen)", NULL, NULL);
+            if (w) {
+                *api = a.name;
+                return w;
+            }
+        }
+        glfwTerminate();
+    }
+
+    // No Mesa (e.g. a Windows desktop): render into a window nobody sees.
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+    if (!glfwInit()) return nullptr;
+    applyContextHints();
+    GLFWwindow* w = glfwCreateWindow(width, height, "OpenGL HUD (offscreen)", NULL, NULL);
+    if (!w) {
+        glfwTerminate();
+        return nullptr;
+    }
+    *api = "hidden window";
+    return w;
+}
+
+OffscreenRenderer::OffscreenRenderer(const OffscreenOptions& opts, const char* api) : opts(opts), api(api) {
+    if (!opts.dumpDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(opts.dumpDir, ec);
+    }
+    printf("offscreen: %dx%d via %s, %s\n", opts.width, opts.height, api, (const char*)glGetString(GL_RENDERER));
+}
+
+void OffscreenRenderer::resize(int w, int h) {
+    if (w == width && h == height && fbo) return;
+    width = w;
+    height = h;
+    if (!fbo) {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorRb);
+        glGenRenderbuffers(1, &depthRb);
+    }
+    // Only ever read back, never sampled, so renderbuffers will do.
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRb);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRb);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Offscreen target incomplete at " << width << "x" << height << std::endl;
+    }
+    windowFramebuffer = fbo;
+}
+
+void OffscreenRenderer::beginFrame(int w, int h) {
+    resize(w, h);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+}
+
+void OffscreenRenderer::present() {
+    glFinish();
+}
+
+void OffscreenRenderer::endFrame(double ms, int drawCalls) {
+    frameMs.push_back((float)ms);
+    drawCallSum += drawCalls;
+    drawCallMax = std::max(drawCallMax, drawCalls);
+    frame++;
+    if (!opts.dumpDir.empty() && frame % opts.dumpEvery == 0) dumpFrame();
+}
+
+void OffscreenRenderer::dumpFrame() {
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%05d.ppm", frame);
+    std::string path = (std::filesystem::path(opts.dumpDir) / name).string();
+    // Binary PPM, top row first; the framebuffer's rows run bottom-up.
+    pixels.resize((size_t)width * height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "offscreen: cannot write " << path << std::endl;
+        dumpFailures++;
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--) fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, f);
+    fclose(f);
+    dumped++;
+}
+
+int OffscreenRenderer::finish() {
+    // The last frame is always kept, whatever the dump interval.
+    if (!opts.dumpDir.empty() && frame > 0 && frame % opts.dumpEvery != 0) dumpFrame();
+
+    std::vector<float> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    auto at = [&](float p) { return sorted.empty() ? 0.0f : sorted[(size_t)(p * (sorted.size() - 1) + 0.5f)]; };
+    double sum = 0.0;
+    for (float v : sorted) sum += v;
+    printf("offscreen: %d frames at %dx%d\n", frame, width, height);
+    printf("  frame avg %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f ms\n",
+        sorted.empty() ? 0.0 : sum / sorted.size(), at(0.50f), at(0.95f), at(0.99f), sorted.empty() ? 0.0f : sorted.back());
+    printf("  draw calls avg %.1f max %d\n", frame ? drawCallSum / frame : 0.0, drawCallMax);
+    const GpuTimers& timers = gpuTimers();
+    for (int i = 0; i < timers.passCount(); i++) {
+        const GpuTimers::Pass& pass = timers.pass(i);
+        printf("  gpu %-16s avg %.3f p99 %.3f ms\n", pass.name, pass.ms.average(), pass.ms.percentile(0.99f));
+    }
+    if (!opts.dumpDir.empty()) printf("  dumped %d frames to %s\n", dumped, opts.dumpDir.c_str());
+    return dumpFailures ? 1 : 0;
+}
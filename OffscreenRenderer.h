@@ -0,0 +1,79 @@
+#ifndef OFFSCREEN_RENDERER_H
+#define OFFSCREEN_RENDERER_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+// Windowless rendering, for machines with no display or GPU, e.g.
+//   opengl.exe --offscreen --frames 300 --size 1280x720 --dump-frames out
+//   opengl.exe --bench all --offscreen
+// The full frame loop runs against GLFW's null platform, with the context
+// from EGL (Mesa's surfaceless platform) or OSMesa; both run on llvmpipe.
+// There is no default framebuffer, so the frame draws into a target here
+// instead of framebuffer 0 (see windowFramebuffer in common.h).
+//
+// Frames use a fixed dt on the fixed default world and a fixed seed, with
+// dynamic resolution off, and the flow field is built in the tick that
+// needs it rather than on its worker (FlowField::setSynchronous), so a given
+// build renders the same images every run: dumps can be compared against
+// golden images.
+struct OffscreenOptions {
+    bool enabled = false;
+    int width = 1280;
+    int height = 720;
+    int frames = 300;               // ignored under --bench, whose ticks decide
+    std::string dumpDir;            // empty: no dumps
+    int dumpEvery = 60;             // dump frame N when N % dumpEvery == 0, and the last
+    bool hud = true;                // --no-hud: the HUD shows live timings, so golden images leave it out
+};
+
+// Returns false (after printing usage) on a malformed command line.
+bool parseOffscreenArgs(int argc, char** argv, OffscreenOptions& opts);
+
+// Initializes GLFW and creates a window with a 3.3 core context that needs
+// no display: null platform with EGL, then with OSMesa, then a
+// hidden window on the desktop platform as a last resort. Sets *api to what
+// was used. Returns null (GLFW terminated) if nothing works.
+GLFWwindow* createOffscreenWindow(int width, int height, const char** api);
+
+class OffscreenRenderer {
+public:
+    static constexpr float kFrameSeconds = 1.0f / 60.0f;
+
+    OffscreenRenderer(const OffscreenOptions& opts, const char* api);
+
+    // (Re)allocates the target at width x height and binds it as the window
+    // framebuffer for this frame.
+    void beginFrame(int width, int height);
+    // Stands in for the swap: waits for the GPU, so frame times include the
+    // frame's rendering as they would with a swap.
+    void present();
+    // Records the frame's stats, then dumps it if due.
+    void endFrame(double frameMs, int drawCalls);
+    bool done() const { return frame >= opts.frames; }
+
+    // Prints frame-time, draw-call and GPU pass stats; returns the exit code
+    // (non-zero if a dump could not be written).
+    int finish();
+
+private:
+    void resize(int w, int h);
+    // Writes the target to <dumpDir>/frame_NNNNN.ppm.
+    void dumpFrame();
+
+    OffscreenOptions opts;
+    const char* api;
+    GLuint fbo = 0, colorRb = 0, depthRb = 0;
+    int width = 0, height = 0;
+    int frame = 0;
+    std::vector<float> frameMs;
+    double drawCallSum = 0.0;
+    int drawCallMax = 0;
+    int dumped = 0, dumpFailures = 0;
+    std::vector<unsigned char> pixels;
+};
+
+#endif
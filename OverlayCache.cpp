@@ -0,0 +1,110 @@
+#include "OverlayCache.h"
+#include "common.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "imgui.h"
+#include "imgui_impl_opengl3.h"
+#include <algorithm>
+#include <iostream>
+
+OverlayCache& overlayCache() {
+    static OverlayCache cache;
+    return cache;
+}
+
+uint64_t OverlayCache::hashState(std::initializer_list<int64_t> values) {
+    // FNV-1a, one step per value
+    uint64_t h = 1469598103934665603ull;
+    for (int64_t v : values) {
+        h ^= (uint64_t)v;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool OverlayCache::refreshDue(uint64_t key, bool interactive, double now) {
+    if (now - secondStart >= 1.0) {
+        lastSecondRefreshes = secondRefreshes;
+        secondRefreshes = 0;
+        secondStart = now;
+    }
+    bool due = !valid || interactive || key != lastKey || now - lastRefresh >= interval;
+    if (due) {
+        lastKey = key;
+        lastRefresh = now;
+        secondRefreshes++;
+    }
+    return due;
+}
+
+void OverlayCache::resize(int w, int h) {
+    if (w == width && h == height && fbo) return;
+    width = w;
+    height = h;
+    if (!fbo) {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &colorTex);
+        glGenVertexArrays(1, &emptyVAO);
+    }
+    glBindTexture(GL_TEXTURE_2D, colorTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Overlay target incomplete at " << width << "x" << height << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, windowFramebuffer);
+}
+
+void OverlayCache::capture(ImDrawData* drawData, int w, int h) {
+    resize(w, h);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(drawData);
+    // The backend sets its own program, VAO and blend state.
+    glState().invalidate();
+    glBindFramebuffer(GL_FRAMEBUFFER, windowFramebuffer);
+    valid = true;
+
+    // The union of the command clip rects bounds everything drawn; the
+    // composite only has to cover that, not the whole screen.
+    float x0 = (float)w, y0 = (float)h, x1 = 0.0f, y1 = 0.0f;
+    ImVec2 off = drawData->DisplayPos, scale = drawData->FramebufferScale;
+    for (const ImDrawList* list : drawData->CmdLists) {
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            if (cmd.UserCallback || cmd.ElemCount == 0) continue;
+            x0 = std::min(x0, (cmd.ClipRect.x - off.x) * scale.x);
+            y0 = std::min(y0, (cmd.ClipRect.y - off.y) * scale.y);
+            x1 = std::max(x1, (cmd.ClipRect.z - off.x) * scale.x);
+            y1 = std::max(y1, (cmd.ClipRect.w - off.y) * scale.y);
+        }
+    }
+    rectX0 = std::clamp((int)x0, 0, w);
+    rectX1 = std::clamp((int)x1 + 1, 0, w);
+    // ImGui's y runs down, the framebuffer's up.
+    rectY0 = std::clamp(h - (int)y1 - 1, 0, h);
+    rectY1 = std::clamp(h - (int)y0, 0, h);
+}
+
+void OverlayCache::composite(Shader& shader) {
+    if (!valid || rectX1 <= rectX0 || rectY1 <= rectY0) return;
+    GLState& gl = glState();
+    gl.setDepthTest(false);
+    gl.setBlend(true);
+    gl.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    shader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTex);
+    shader.setInt("overlay", 0);
+    // Quad corners in NDC; the shader reads the texture by pixel.
+    shader.setVec4("rect", glm::vec4(rectX0, rectY0, rectX1, rectY1) / glm::vec4(width, height, width, height) * 2.0f - 1.0f);
+    gl.bindVertexArray(emptyVAO);
+    frameDrawCalls++;
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    gl.setBlend(false);
+    gl.setDepthTest(true);
+}
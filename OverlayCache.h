@@ -0,0 +1,59 @@
+#ifndef OVERLAY_CACHE_H
+#define OVERLAY_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <initializer_list>
+
+struct ImDrawData;
+class Shader;
+
+// Keeps the ImGui overlay in an offscreen texture so it is only rebuilt when
+// something on it changes. Each frame refreshDue() says whether to run
+// NewFrame/Render this frame; if so the draw data goes into the texture with
+// capture(). Every frame composite() blends the texture over the scene as one
+// quad covering just the windows' area.
+//
+// The texture holds premultiplied color (ImGui's blend into a transparent
+// target yields that), so compositing is ONE, ONE_MINUS_SRC_ALPHA.
+class OverlayCache {
+public:
+    // Folds whatever the overlay shows discretely (counters, toggles, sizes)
+    // into one key; a different key forces a refresh.
+    static uint64_t hashState(std::initializer_list<int64_t> values);
+
+    // Seconds between refreshes while the key stays the same.
+    void setInterval(float seconds) { interval = seconds; }
+    float getInterval() const { return interval; }
+
+    // True if the overlay must be rebuilt this frame: the key changed, the
+    // interval ran out, or it is interactive (menus take input every frame).
+    bool refreshDue(uint64_t key, bool interactive, double now);
+    // Renders draw data into the texture, (re)allocated at width x height.
+    void capture(ImDrawData* drawData, int width, int height);
+    // Blends the last capture over the bound framebuffer. shader must be the
+    // overlay program (shaders/overlay.vert, shaders/overlay.frag).
+    void composite(Shader& shader);
+
+    // Refreshes over the last full second.
+    int refreshesPerSecond() const { return lastSecondRefreshes; }
+
+private:
+    void resize(int w, int h);
+
+    GLuint fbo = 0, colorTex = 0, emptyVAO = 0;
+    int width = 0, height = 0;
+    bool valid = false;
+    // Area covered by the draw data, framebuffer pixels with y up.
+    int rectX0 = 0, rectY0 = 0, rectX1 = 0, rectY1 = 0;
+
+    float interval = 0.1f;
+    uint64_t lastKey = 0;
+    double lastRefresh = 0.0;
+    double secondStart = 0.0;
+    int secondRefreshes = 0, lastSecondRefreshes = 0;
+};
+
+OverlayCache& overlayCache();
+
+#endif
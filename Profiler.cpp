@@ -0,0 +1,239 @@
+#include "Profiler.h"
+#include "imgui.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace {
+    constexpr int kMaxTracks = 32;
+    constexpr uint64_t kRingSize = 1 << 16;
+    constexpr int kFrameHistory = 256;
+
+    // One per thread (or per virtual track). Only the owning thread writes
+    // events/head; readers copy slots out with readEvent, which drops any the
+    // owner has lapped meanwhile. name is only written or read under
+    // registerMutex, since a thread may rename its track while it's drawn.
+    struct Track {
+        char name[32];
+        ProfileEvent* events;
+        std::atomic<uint64_t> head{ 0 };
+        uint32_t depth = 0;
+    };
+
+    Track* tracks[kMaxTracks];
+    std::atomic<int> trackCount{ 0 };
+    std::mutex registerMutex;
+    thread_local Track* localTrack = nullptr;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    uint64_t frameStarts[kFrameHistory];
+    std::atomic<uint64_t> frameIndex{ 0 };
+
+    // Caller holds registerMutex. A null name gives "Thread <index>".
+    Track* createTrack(const char* name) {
+        int index = trackCount.load(std::memory_order_relaxed);
+        if (index >= kMaxTracks) return nullptr;
+        Track* track = new Track();
+        if (name) snprintf(track->name, sizeof(track->name), "%s", name);
+        else snprintf(track->name, sizeof(track->name), "Thread %d", index);
+        track->events = static_cast<ProfileEvent*>(std::calloc(kRingSize, sizeof(ProfileEvent)));
+        tracks[index] = track;
+        trackCount.store(index + 1, std::memory_order_release);
+        return track;
+    }
+
+    Track* threadTrack() {
+        if (!localTrack) {
+            std::lock_guard<std::mutex> lock(registerMutex);
+            localTrack = createTrack(nullptr);
+        }
+        return localTrack;
+    }
+
+    Track* namedTrack(const char* name) {
+        std::lock_guard<std::mutex> lock(registerMutex);
+        int count = trackCount.load(std::memory_order_relaxed);
+        for (int i = 0; i < count; i++) {
+            if (strcmp(tracks[i]->name, name) == 0) return tracks[i];
+        }
+        return createTrack(name);
+    }
+
+    void push(Track* track, const ProfileEvent& e) {
+        uint64_t head = track->head.load(std::memory_order_relaxed);
+        track->events[head & (kRingSize - 1)] = e;
+        track->head.store(head + 1, std::memory_order_release);
+    }
+
+    // Copies event i (below a head loaded with acquire) into out. The owner
+    // may be overwriting the oldest slots while a reader walks the ring, so
+    // head is checked again after the copy: false if the owner has reached
+    // slot i's next use, in which case out may be torn. Older events are
+    // then gone too.
+    bool readEvent(const Track* track, uint64_t i, ProfileEvent& out) {
+        out = track->events[i & (kRingSize - 1)];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return track->head.load(std::memory_order_relaxed) < i + kRingSize;
+    }
+
+    void copyName(const Track* track, char (&out)[32]) {
+        std::lock_guard<std::mutex> lock(registerMutex);
+        memcpy(out, track->name, sizeof(out));
+    }
+
+    ImU32 colorFor(const char* name) {
+        uint32_t h = (uint32_t)(reinterpret_cast<uintptr_t>(name) * 2654435761u);
+        return ImColor::HSV((h >> 8) % 360 / 360.0f, 0.55f, 0.85f);
+    }
+}
+
+uint64_t profilerNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+#if ENABLE_PROFILER
+ProfileZone::ProfileZone(const char* name) : name(name) {
+    Track* track = threadTrack();
+    if (track) track->depth++;
+    start = profilerNowNs();
+}
+
+ProfileZone::~ProfileZone() {
+    uint64_t end = profilerNowNs();
+    Track* track = localTrack;
+    if (!track) return;
+    track->depth--;
+    push(track, { name, start, end, track->depth });
+}
+#endif
+
+void profilerNewFrame() {
+    uint64_t index = frameIndex.load(std::memory_order_relaxed);
+    frameStarts[index % kFrameHistory] = profilerNowNs();
+    frameIndex.store(index + 1, std::memory_order_release);
+}
+
+void profilerSetThreadName(const char* name) {
+    std::lock_guard<std::mutex> lock(registerMutex);
+    if (!localTrack) localTrack = createTrack(name);
+    else snprintf(localTrack->name, sizeof(localTrack->name), "%s", name);
+}
+
+void profilerRecordZone(const char* trackName, const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth) {
+    Track* track = namedTrack(trackName);
+    if (track) push(track, { name, startNs, endNs, depth });
+}
+
+bool profilerExportChromeTrace(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+    int count = trackCount.load(std::memory_order_acquire);
+    for (int t = 0; t < count; t++) {
+        Track* track = tracks[t];
+        char name[32];
+        copyName(track, name);
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", t, name);
+        first = false;
+        uint64_t head = track->head.load(std::memory_order_acquire);
+        uint64_t begin = head > kRingSize ? head - kRingSize : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            ProfileEvent e;
+            if (!readEvent(track, i, e)) continue;
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                e.name, e.startNs / 1000.0, (e.endNs - e.startNs) / 1000.0, t);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return true;
+}
+
+void profilerDrawWindow(bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(720, 360), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", open)) {
+        ImGui::End();
+        return;
+    }
+    static bool frozen = false;
+    static uint64_t windowStart = 0, windowEnd = 0;
+    static float zoom = 1.0f;
+    ImGui::Checkbox("Freeze", &frozen);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderFloat("Zoom", &zoom, 1.0f, 20.0f, "%.1fx");
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace")) {
+        profilerExportChromeTrace("profile_trace.json");
+    }
+
+    uint64_t fi = frameIndex.load(std::memory_order_acquire);
+    if (!frozen && fi >= 2) {
+        windowStart = frameStarts[(fi - 2) % kFrameHistory];
+        windowEnd = frameStarts[(fi - 1) % kFrameHistory];
+    }
+    if (windowEnd <= windowStart) {
+        ImGui::End();
+        return;
+    }
+    double frameMs = (windowEnd - windowStart) / 1e6;
+    ImGui::Text("Frame: %.3f ms", frameMs);
+
+    // --- Flame chart: one lane per track, one row per nesting depth ---
+    ImGui::BeginChild("timeline", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+    const float width = ImGui::GetContentRegionAvail().x * zoom;
+    const double pxPerNs = width / (double)(windowEnd - windowStart);
+    ProfileEvent hovered = {};
+    static char trackNames[kMaxTracks][32];
+    const char* hoveredTrack = nullptr;
+
+    int count = trackCount.load(std::memory_order_acquire);
+    for (int t = 0; t < count; t++) {
+        Track* track = tracks[t];
+        copyName(track, trackNames[t]);
+        ImGui::TextDisabled("%s", trackNames[t]);
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        uint32_t maxDepth = 0;
+
+        // Events are pushed when a zone ends, so walk back from the newest one
+        // until we're past the start of the frame we're showing.
+        uint64_t head = track->head.load(std::memory_order_acquire);
+        uint64_t oldest = head > kRingSize ? head - kRingSize : 0;
+        for (uint64_t i = head; i > oldest; i--) {
+            ProfileEvent e;
+            if (!readEvent(track, i - 1, e)) break;
+            if (e.endNs < windowStart) break;
+            if (e.startNs > windowEnd) continue;
+            uint64_t s = e.startNs < windowStart ? windowStart : e.startNs;
+            uint64_t en = e.endNs > windowEnd ? windowEnd : e.endNs;
+            ImVec2 a(origin.x + (float)((s - windowStart) * pxPerNs), origin.y + e.depth * rowHeight);
+            ImVec2 b(origin.x + (float)((en - windowStart) * pxPerNs), a.y + rowHeight - 1.0f);
+            if (b.x - a.x < 1.0f) b.x = a.x + 1.0f;
+            draw->AddRectFilled(a, b, colorFor(e.name));
+            if (b.x - a.x > 20.0f) {
+                ImVec4 clip(a.x, a.y, b.x - 2.0f, b.y);
+                draw->AddText(ImGui::GetFont(), ImGui::GetFontSize(), ImVec2(a.x + 2.0f, a.y + 2.0f), IM_COL32(0, 0, 0, 255), e.name, nullptr, 0.0f, &clip);
+            }
+            if (ImGui::IsMouseHoveringRect(a, b)) {
+                hovered = e;
+                hoveredTrack = trackNames[t];
+            }
+            if (e.depth > maxDepth) maxDepth = e.depth;
+        }
+        ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight));
+    }
+    if (hoveredTrack) {
+        ImGui::BeginTooltip();
+        ImGui::Text("%s (%s)", hovered.name, hoveredTrack);
+        ImGui::Text("%.3f ms", (hovered.endNs - hovered.startNs) / 1e6);
+        ImGui::EndTooltip();
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
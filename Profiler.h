@@ -0,0 +1,62 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+
+// Hierarchical CPU profiler.
+// PROFILE_SCOPE("name") times the enclosing block on the calling thread. Each
+// thread writes into its own ring buffer with no locks; the UI and the trace
+// exporter read those rings from the main thread.
+// Build with ENABLE_PROFILER=0 and every macro compiles to nothing.
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 1
+#endif
+
+struct ProfileEvent {
+    const char* name;   // must be a string literal (or otherwise outlive the profiler)
+    uint64_t startNs;
+    uint64_t endNs;
+    uint32_t depth;
+};
+
+uint64_t profilerNowNs();
+
+#if ENABLE_PROFILER
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name);
+    ~ProfileZone();
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FRAME() profilerNewFrame()
+#define PROFILE_THREAD(name) profilerSetThreadName(name)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
+
+// Marks the start of a new frame (main thread only).
+void profilerNewFrame();
+void profilerSetThreadName(const char* name);
+
+// Records an already-finished zone on a named virtual track (e.g. GPU timings).
+void profilerRecordZone(const char* track, const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth);
+
+// Writes everything still in the ring buffers as Chrome trace JSON (chrome://tracing, Perfetto).
+bool profilerExportChromeTrace(const char* path);
+
+// ImGui flame graph / timeline of the last completed frame.
+void profilerDrawWindow(bool* open);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef ROLLING_STATS_H
+#define ROLLING_STATS_H
+
+#include <algorithm>
+
+// Keeps the last N samples of a metric (frame times, pass timings, ...) and
+// answers average / percentile queries over that window. No heap use.
+template <int N>
+class RollingStats {
+public:
+    void add(float v) {
+        samples[next] = v;
+        next = (next + 1) % N;
+        if (count < N) count++;
+        lastValue = v;
+    }
+
+    void clear() { count = 0; next = 0; lastValue = 0.0f; }
+
+    int size() const { return count; }
+    float last() const { return lastValue; }
+
+    float average() const {
+        if (count == 0) return 0.0f;
+        double sum = 0.0;
+        for (int i = 0; i < count; i++) sum += samples[i];
+        return (float)(sum / count);
+    }
+
+    float max() const {
+        float m = 0.0f;
+        for (int i = 0; i < count; i++) m = std::max(m, samples[i]);
+        return m;
+    }
+
+    // p in [0, 1], e.g. 0.99f for p99.
+    float percentile(float p) const {
+        if (count == 0) return 0.0f;
+        float sorted[N];
+        std::copy(samples, samples + count, sorted);
+        int k = (int)(p * (count - 1) + 0.5f);
+        std::nth_element(sorted, sorted + k, sorted + count);
+        return sorted[k];
+    }
+
+    // Oldest-to-newest copy, for plotting.
+    int copyOrdered(float* out) const {
+        int start = count < N ? 0 : next;
+        for (int i = 0; i < count; i++) out[i] = samples[(start + i) % N];
+        return count;
+    }
+
+private:
+    float samples[N];
+    int count = 0;
+    int next = 0;
+    float lastValue = 0.0f;
+};
+
+#endif
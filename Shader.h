@@ -5,113 +5,52 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
+#include "GLState.h"
+#include "ShaderCache.h"
 
 class Shader {
 public:
     unsigned int ID;
 
-    // Constructor reads and builds the shader
-    Shader(const char* vertexPath, const char* fragmentPath) {
-        // 1. Retrieve the source code from filePaths
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-
-        // Ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-        try {
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            vShaderFile.close();
-            fShaderFile.close();
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch (std::ifstream::failure& e) {
-            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-        }
-
-        const char* vShaderSource = vertexCode.c_str();
-        const char* fShaderSource = fragmentCode.c_str();
-
-        // 2. Compile Shaders
-        unsigned int vertex, fragment;
-
-        // Vertex Shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderSource, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+    Shader() : ID(0) {}
 
-        // Fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderSource, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-
-        // Shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-
-        // Delete shaders as they're linked into our program and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    // Constructor reads and builds the shader (through the program cache).
+    // To build several at once, default-construct them and use a ShaderBatch.
+    Shader(const char* vertexPath, const char* fragmentPath) {
+        ShaderBatch batch;
+        batch.add(*this, vertexPath, fragmentPath);
+        batch.wait();
     }
 
-    // Activate the shader
+    // Activate the shader (a no-op if it already is, see GLState.h)
     void use() {
-        glUseProgram(ID);
+        glState().useProgram(ID);
     }
 
     // --- Utility Uniform Functions ---
-    void setBool(const std::string& name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    // Names are plain C strings so setting a uniform never builds a temporary std::string.
+    // Values the program already holds are not sent again.
+    void setBool(const char* name, bool value) const {
+        glState().uniform1i(glGetUniformLocation(ID, name), (int)value);
     }
-    void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    void setInt(const char* name, int value) const {
+        glState().uniform1i(glGetUniformLocation(ID, name), value);
     }
-    void setFloat(const std::string& name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    void setFloat(const char* name, float value) const {
+        glState().uniform1f(glGetUniformLocation(ID, name), value);
     }
-    void setVec3(const std::string& name, const glm::vec3& value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    void setVec2(const char* name, const glm::vec2& value) const {
+        glState().uniform2f(glGetUniformLocation(ID, name), &value[0]);
     }
-    void setMat4(const std::string& name, const glm::mat4& mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    void setVec3(const char* name, const glm::vec3& value) const {
+        glState().uniform3f(glGetUniformLocation(ID, name), &value[0]);
     }
-
-private:
-    // Utility function for checking shader compilation/linking errors.
-    void checkCompileErrors(unsigned int shader, std::string type) {
-        int success;
-        char infoLog[1024];
-        if (type != "PROGRAM") {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if (!success) {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            }
-        }
-        else {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if (!success) {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-                std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            }
-        }
+    void setVec4(const char* name, const glm::vec4& value) const {
+        glState().uniform4f(glGetUniformLocation(ID, name), &value[0]);
+    }
+    void setMat4(const char* name, const glm::mat4& mat) const {
+        glState().uniformMatrix4f(glGetUniformLocation(ID, name), glm::value_ptr(mat));
     }
+
 };
 #endif
\ No newline at end of file
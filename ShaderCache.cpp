@@ -0,0 +1,233 @@
+#include "ShaderCache.h"
+#include "Shader.h"
+#include "Profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+    // KHR_parallel_shader_compile and ARB_parallel_shader_compile share these.
+    constexpr GLenum kCompletionStatus = 0x91B1;
+    typedef void (APIENTRYP PFNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+    constexpr uint32_t kMagic = 0x43425053; // "SPBC"
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kMaxBinarySize = 64u << 20; // far past any real program binary
+    const char* kCacheDir = "shader_cache";
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    ShaderStats stats;
+    std::string driverId;
+
+    uint64_t fnv1a(const std::string& s, uint64_t h = 14695981039346656037ull) {
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (ext && strcmp(ext, name) == 0) return true;
+        }
+        return false;
+    }
+
+    std::string readFile(const char* path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return "";
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    void checkCompileErrors(GLuint shader, const char* type, const std::string& path) {
+        int success;
+        char infoLog[1024];
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << " (" << path << ")\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        }
+    }
+
+    bool loadBinary(GLuint program, const std::string& path, uint64_t key) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        CacheHeader h;
+        if (!file.read((char*)&h, sizeof(h)) || h.magic != kMagic || h.version != kVersion || h.key != key) return false;
+        // The header's length is only trusted once the file is known to hold
+        // that much; a truncated or corrupt file is a miss.
+        file.seekg(0, std::ios::end);
+        std::streamoff remaining = (std::streamoff)file.tellg() - (std::streamoff)sizeof(h);
+        if (h.length == 0 || h.length > kMaxBinarySize || (std::streamoff)h.length != remaining) return false;
+        file.seekg(sizeof(h));
+        std::vector<char> data(h.length);
+        if (!file.read(data.data(), h.length)) return false;
+        glProgramBinary(program, h.format, data.data(), (GLsizei)h.length);
+        return true;
+    }
+
+    void saveBinary(GLuint program, const std::string& path, uint64_t key) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        std::vector<char> data(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, data.data());
+
+        std::error_code ec;
+        std::filesystem::create_directories(kCacheDir, ec);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        CacheHeader h = { kMagic, kVersion, key, format, (uint32_t)length };
+        file.write((const char*)&h, sizeof(h));
+        file.write(data.data(), length);
+    }
+}
+
+void shaderCacheInit(GLADloadproc load) {
+    const char* vendor = (const char*)glGetString(GL_VENDOR);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    const char* version = (const char*)glGetString(GL_VERSION);
+    driverId = std::string(vendor ? vendor : "") + "|" + (renderer ? renderer : "") + "|" + (version ? version : "");
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    stats.binaryCache = formats > 0;
+
+    PFNMAXSHADERCOMPILERTHREADSPROC maxThreads = nullptr;
+    if (hasExtension("GL_KHR_parallel_shader_compile")) maxThreads = (PFNMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsKHR");
+    else if (hasExtension("GL_ARB_parallel_shader_compile")) maxThreads = (PFNMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsARB");
+    if (maxThreads) {
+        maxThreads(0xFFFFFFFFu); // let the driver pick
+        stats.parallelCompile = true;
+    }
+}
+
+const ShaderStats& shaderStats() {
+    return stats;
+}
+
+void ShaderBatch::add(Shader& s, const char* vertexPath, const char* fragmentPath) {
+    PROFILE_SCOPE("Shader submit");
+    if (startNs == 0) startNs = profilerNowNs();
+
+    Pending p;
+    p.vertexPath = vertexPath;
+    p.fragmentPath = fragmentPath;
+    p.vertexCode = readFile(vertexPath);
+    p.fragmentCode = readFile(fragmentPath);
+    p.key = fnv1a(p.fragmentCode, fnv1a(p.vertexCode, fnv1a(driverId)));
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)fnv1a(p.vertexPath + "|" + p.fragmentPath));
+    p.cachePath = std::string(kCacheDir) + "/" + name;
+    p.program = glCreateProgram();
+    s.ID = p.program;
+
+    if (stats.binaryCache && loadBinary(p.program, p.cachePath, p.key)) p.fromCache = true;
+    else compile(p);
+    pending.push_back(std::move(p));
+}
+
+void ShaderBatch::compile(Pending& p) {
+    const char* vSource = p.vertexCode.c_str();
+    const char* fSource = p.fragmentCode.c_str();
+    p.vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(p.vertex, 1, &vSource, NULL);
+    glCompileShader(p.vertex);
+    p.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(p.fragment, 1, &fSource, NULL);
+    glCompileShader(p.fragment);
+
+    // No status queries here: they would make the driver finish the compile now.
+    glAttachShader(p.program, p.vertex);
+    glAttachShader(p.program, p.fragment);
+    if (stats.binaryCache) glProgramParameteri(p.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(p.program);
+    p.fromCache = false;
+}
+
+// Called once the driver reports the link finished. False if it had to start over.
+bool ShaderBatch::finish(Pending& p) {
+    GLint linked = 0;
+    glGetProgramiv(p.program, GL_LINK_STATUS, &linked);
+    if (p.fromCache) {
+        if (linked) {
+            stats.cacheHits++;
+            return true;
+        }
+        // Driver refused the binary (usually after an update): build from source.
+        compile(p);
+        return false;
+    }
+
+    checkCompileErrors(p.vertex, "VERTEX", p.vertexPath);
+    checkCompileErrors(p.fragment, "FRAGMENT", p.fragmentPath);
+    if (!linked) {
+        char infoLog[1024];
+        glGetProgramInfoLog(p.program, 1024, NULL, infoLog);
+        std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: PROGRAM (" << p.vertexPath << ", " << p.fragmentPath << ")\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    }
+    // Delete shaders as they're linked into our program and no longer necessary
+    glDetachShader(p.program, p.vertex);
+    glDetachShader(p.program, p.fragment);
+    glDeleteShader(p.vertex);
+    glDeleteShader(p.fragment);
+    p.vertex = p.fragment = 0;
+    if (linked && stats.binaryCache) saveBinary(p.program, p.cachePath, p.key);
+    return true;
+}
+
+bool ShaderBatch::poll() {
+    bool allDone = true;
+    for (Pending& p : pending) {
+        if (p.done) continue;
+        if (stats.parallelCompile) {
+            GLint complete = 0;
+            glGetProgramiv(p.program, kCompletionStatus, &complete);
+            if (!complete) {
+                allDone = false;
+                continue;
+            }
+        }
+        p.done = finish(p);
+        allDone &= p.done;
+    }
+    return allDone;
+}
+
+void ShaderBatch::wait() {
+    if (pending.empty()) return;
+    {
+        PROFILE_SCOPE("Shader wait");
+        while (!poll()) std::this_thread::yield();
+    }
+    float ms = (profilerNowNs() - startNs) / 1e6f;
+    int hits = 0;
+    for (const Pending& p : pending) hits += p.fromCache;
+    stats.programs += (int)pending.size();
+    stats.startupMs += ms;
+    printf("Shaders: %d programs (%d from cache) ready in %.1f ms%s\n", (int)pending.size(), hits, ms,
+        stats.parallelCompile ? ", parallel compile" : "");
+    pending.clear();
+    startNs = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Shader;
+
+// Program binary cache + batched shader builds.
+// Linked programs are saved with glGetProgramBinary to shader_cache/, keyed by
+// the shader paths. Each file stores a hash of both sources and the GL
+// vendor/renderer/version strings; if that doesn't match (edited shader, new
+// driver) or the driver rejects the binary, the program is rebuilt from source
+// and the file rewritten.
+//
+// ShaderBatch issues every compile/link up front and only asks for status when
+// polled, so drivers with KHR_parallel_shader_compile can build them on their
+// own threads while we load models.
+
+// Call once after the GL loader. Without it Shader still works, just uncached.
+void shaderCacheInit(GLADloadproc load);
+
+struct ShaderStats {
+    int programs = 0;
+    int cacheHits = 0;
+    float startupMs = 0.0f;    // submit -> all programs ready, summed over batches
+    bool binaryCache = false;
+    bool parallelCompile = false;
+};
+const ShaderStats& shaderStats();
+
+class ShaderBatch {
+public:
+    ShaderBatch() = default;
+    ShaderBatch(const ShaderBatch&) = delete;
+    ShaderBatch& operator=(const ShaderBatch&) = delete;
+    ~ShaderBatch() { wait(); }
+
+    // Starts building the program (or loading it from the cache) into s.ID.
+    // s must outlive the batch.
+    void add(Shader& s, const char* vertexPath, const char* fragmentPath);
+
+    // Finishes whatever the driver is done with. True once every program is ready.
+    bool poll();
+    // Blocks until every program is ready and reports the startup time.
+    void wait();
+
+private:
+    struct Pending {
+        GLuint program;
+        GLuint vertex = 0, fragment = 0;
+        std::string vertexPath, fragmentPath;
+        std::string vertexCode, fragmentCode;
+        uint64_t key;
+        std::string cachePath;
+        bool fromCache = false;
+        bool done = false;
+    };
+
+    std::vector<Pending> pending;
+    uint64_t startNs = 0;
+
+    void compile(Pending& p);
+    bool finish(Pending& p);
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// One feature test for the SSE2 paths, so every module agrees on it. SSE2
+// is always there on x64, and on 32-bit x86 with /arch:SSE2 or -msse2;
+// other targets take each module's scalar path.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE2 1
+#else
+#define SIMD_SSE2 0
+#endif
+
+#endif
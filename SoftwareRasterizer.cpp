@@ -0,0 +1,457 @@
+#include "SoftwareRasterizer.h"
+#include "common.h"
+#include "logic.h"
+#include "objModel.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace {
+    uint32_t packColor(float r, float g, float b) {
+        auto unorm = [](float v) { return (uint32_t)(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        return unorm(r) | unorm(g) << 8 | unorm(b) << 16 | 0xFF000000u;
+    }
+
+    bool sphereTouchesBox(const glm::vec3& c, float r, const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 d = glm::max(glm::max(min - c, c - max), glm::vec3(0.0f));
+        return glm::dot(d, d) <= r * r;
+    }
+}
+
+struct SoftwareRasterizer::ClipVertex {
+    glm::vec4 clip;
+    glm::vec3 pos;      // world, for FragPos
+    glm::vec3 normal;
+};
+
+SoftwareRasterizer::MeshData SoftwareRasterizer::MeshData::fromArray(const float* vertices, size_t dataSize, const std::vector<int>& layout) {
+    MeshData mesh;
+    int floatsPerVertex = std::accumulate(layout.begin(), layout.end(), 0);
+    int count = (int)(dataSize / (floatsPerVertex * sizeof(float)));
+    for (int i = 0; i < count; i++) {
+        const float* v = vertices + i * floatsPerVertex;
+        // Missing components read as 0, like a GL attribute with fewer of them.
+        glm::vec3 pos(0.0f), normal(0.0f);
+        for (int c = 0; c < std::min(layout[0], 3); c++) pos[c] = v[c];
+        if (layout.size() > 1) {
+            for (int c = 0; c < std::min(layout[1], 3); c++) normal[c] = v[layout[0] + c];
+        }
+        mesh.positions.push_back(pos);
+        mesh.normals.push_back(normal);
+        mesh.indices.push_back((uint32_t)i);
+    }
+    return mesh;
+}
+
+SoftwareRasterizer::MeshData SoftwareRasterizer::MeshData::fromModel(const objModel& model) {
+    MeshData mesh;
+    for (const objMesh& m : model.getMeshes()) {
+        uint32_t base = (uint32_t)mesh.positions.size();
+        for (const Vertex& v : m.vertices) {
+            mesh.positions.push_back(v.Position);
+            mesh.normals.push_back(glm::vec3(v.TexCoords, 0.0f));
+        }
+        for (unsigned int i : m.indices) mesh.indices.push_back(base + i);
+    }
+    return mesh;
+}
+
+SoftwareRasterizer::SoftwareRasterizer() {
+    int threads = std::clamp((int)std::thread::hardware_concurrency(), 1, kMaxThreads);
+    for (int i = 1; i < threads; i++) workers.emplace_back(&SoftwareRasterizer::run, this);
+}
+
+SoftwareRasterizer::~SoftwareRasterizer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+void SoftwareRasterizer::setCamera(const glm::mat4& view, const glm::mat4& projection) {
+    viewProjection = projection * view;
+}
+
+void SoftwareRasterizer::setLight(const glm::vec3& pos, const glm::vec3& c) {
+    lightPos = pos;
+    lightColor = c;
+}
+
+void SoftwareRasterizer::addLight(const glm::vec3& pos, float radius, const glm::vec3& c) {
+    if (lights.size() < 65536) lights.push_back({ pos, radius, c });
+}
+
+void SoftwareRasterizer::begin(int w, int h, const glm::vec3& clearColor) {
+    if (w != frameWidth || h != frameHeight) {
+        frameWidth = w;
+        frameHeight = h;
+        rowPitch = (w + 3) & ~3; // whole groups of four
+        tilesX = (rowPitch + kTile - 1) / kTile;
+        tilesY = (h + kTile - 1) / kTile;
+        color.assign((size_t)rowPitch * h, 0);
+        depthBuffer.assign((size_t)rowPitch * h, 1.0f);
+        bins.assign((size_t)tilesX * tilesY, {});
+    }
+    std::fill(color.begin(), color.end(), packColor(clearColor.r, clearColor.g, clearColor.b));
+    std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+    for (auto& bin : bins) bin.clear();
+    tris.clear();
+    lightRefs.clear();
+    setupTime = 0;
+}
+
+void SoftwareRasterizer::draw(const MeshData& mesh, const glm::mat4& model, const glm::vec3& c) {
+    frameDrawCalls++;
+    drawTransformed(mesh, model, glm::mat3(glm::transpose(glm::inverse(model))), c);
+}
+
+void SoftwareRasterizer::drawInstanced(const MeshData& mesh, const CubeInstance* instances, int count) {
+    frameDrawCalls++;
+    for (int i = 0; i < count; i++) {
+        const CubeInstance& inst = instances[i];
+        // default.vert's getRotationMatrix; GLSL and glm both fill column by column.
+        float sx = sinf(inst.rotation.x), cx = cosf(inst.rotation.x);
+        float sy = sinf(inst.rotation.y), cy = cosf(inst.rotation.y);
+        float sz = sinf(inst.rotation.z), cz = cosf(inst.rotation.z);
+        glm::mat4 rx(1, 0, 0, 0, 0, cx, -sx, 0, 0, sx, cx, 0, 0, 0, 0, 1);
+        glm::mat4 ry(cy, 0, sy, 0, 0, 1, 0, 0, -sy, 0, cy, 0, 0, 0, 0, 1);
+        glm::mat4 rz(cz, -sz, 0, 0, sz, cz, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+        glm::mat4 rotation = rz * ry * rx;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), inst.pos) * rotation * glm::scale(glm::mat4(1.0f), glm::vec3(inst.scale));
+        drawTransformed(mesh, model, glm::mat3(rotation), inst.color);
+    }
+}
+
+void SoftwareRasterizer::drawTransformed(const MeshData& mesh, const glm::mat4& model, const glm::mat3& normalMatrix, const glm::vec3& c) {
+    if (mesh.positions.empty()) return;
+    uint64_t start = profilerNowNs();
+    glm::mat4 mvp = viewProjection * model;
+
+    // 1. Vertices, and the draw's world bounds for picking its lights.
+    static thread_local std::vector<ClipVertex> verts;
+    verts.resize(mesh.positions.size());
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    for (size_t i = 0; i < verts.size(); i++) {
+        glm::vec4 p(mesh.positions[i], 1.0f);
+        verts[i].clip = mvp * p;
+        verts[i].pos = glm::vec3(model * p);
+        verts[i].normal = normalMatrix * mesh.normals[i];
+        boundsMin = glm::min(boundsMin, verts[i].pos);
+        boundsMax = glm::max(boundsMax, verts[i].pos);
+    }
+    // A light contributes nothing past its radius, so the ones whose sphere
+    // misses the bounds can be skipped for the whole draw.
+    uint32_t lightsBegin = (uint32_t)lightRefs.size();
+    for (size_t i = 0; i < lights.size(); i++) {
+        if (sphereTouchesBox(lights[i].pos, lights[i].radius, boundsMin, boundsMax)) lightRefs.push_back((uint16_t)i);
+    }
+    uint32_t lightCount = (uint32_t)lightRefs.size() - lightsBegin;
+
+    // 2. Triangles: drop those wholly outside one frustum plane, clip the
+    // ones crossing near or far (x and y are left to the screen bounds).
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const ClipVertex* v[3] = { &verts[mesh.indices[i]], &verts[mesh.indices[i + 1]], &verts[mesh.indices[i + 2]] };
+        int outside = 0x3F, crossing = 0;
+        for (const ClipVertex* cv : v) {
+            const glm::vec4& p = cv->clip;
+            int out = (p.x < -p.w) | (p.x > p.w) << 1 | (p.y < -p.w) << 2 | (p.y > p.w) << 3 | (p.z < -p.w) << 4 | (p.z > p.w) << 5;
+            outside &= out;
+            crossing |= out & 0x30;
+        }
+        if (outside) continue;
+        if (!crossing) {
+            setupTriangle(*v[0], *v[1], *v[2], c, lightsBegin, lightCount);
+            continue;
+        }
+        ClipVertex poly[2][5];
+        int n = 3;
+        for (int k = 0; k < 3; k++) poly[0][k] = *v[k];
+        int cur = 0;
+        for (int plane = 0; plane < 2 && n > 0; plane++) {
+            // Signed distance: z + w >= 0 (near), w - z >= 0 (far).
+            auto dist = [plane](const ClipVertex& cv) { return plane == 0 ? cv.clip.z + cv.clip.w : cv.clip.w - cv.clip.z; };
+            int m = 0;
+            for (int k = 0; k < n; k++) {
+                const ClipVertex& a = poly[cur][k];
+                const ClipVertex& b = poly[cur][(k + 1) % n];
+                float da = dist(a), db = dist(b);
+                if (da >= 0.0f) poly[cur ^ 1][m++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f)) {
+                    float t = da / (da - db);
+                    ClipVertex& o = poly[cur ^ 1][m++];
+                    o.clip = a.clip + (b.clip - a.clip) * t;
+                    o.pos = a.pos + (b.pos - a.pos) * t;
+                    o.normal = a.normal + (b.normal - a.normal) * t;
+                }
+            }
+            n = m;
+            cur ^= 1;
+        }
+        for (int k = 1; k + 1 < n; k++) setupTriangle(poly[cur][0], poly[cur][k], poly[cur][k + 1], c, lightsBegin, lightCount);
+    }
+    setupTime += profilerNowNs() - start;
+}
+
+void SoftwareRasterizer::setupTriangle(const ClipVertex& va, const ClipVertex& vb, const ClipVertex& vc, const glm::vec3& c, uint32_t lightsBegin, uint32_t lightCount) {
+    struct Screen {
+        float x, y, z, iw;
+        const ClipVertex* v;
+    };
+    auto project = [this](const ClipVertex& v) {
+        float iw = 1.0f / v.clip.w;
+        return Screen{ (v.clip.x * iw * 0.5f + 0.5f) * frameWidth, (v.clip.y * iw * 0.5f + 0.5f) * frameHeight, v.clip.z * iw * 0.5f + 0.5f, iw, &v };
+    };
+    Screen a = project(va), b = project(vb), cc = project(vc);
+    float area = (b.x - a.x) * (cc.y - a.y) - (b.y - a.y) * (cc.x - a.x);
+    if (!(fabsf(area) > 1e-8f)) return;
+    // Nothing is culled (the GL path doesn't cull faces): wind every triangle the same way.
+    if (area < 0.0f) {
+        std::swap(b, cc);
+        area = -area;
+    }
+    // Clamp while still in float: vertices near the camera land far off screen.
+    int x0 = (int)std::clamp(floorf(std::min({ a.x, b.x, cc.x })), 0.0f, (float)frameWidth);
+    int x1 = (int)std::clamp(ceilf(std::max({ a.x, b.x, cc.x })), -1.0f, (float)(frameWidth - 1));
+    int y0 = (int)std::clamp(floorf(std::min({ a.y, b.y, cc.y })), 0.0f, (float)frameHeight);
+    int y1 = (int)std::clamp(ceilf(std::max({ a.y, b.y, cc.y })), -1.0f, (float)(frameHeight - 1));
+    if (x0 > x1 || y0 > y1) return;
+
+    Triangle t;
+    // Edge e runs from[e] -> to[e] and is zero on both, so it is the
+    // barycentric weight of the vertex opposite it once divided by the area.
+    const Screen* from[3] = { &b, &cc, &a };
+    const Screen* to[3] = { &cc, &a, &b };
+    for (int e = 0; e < 3; e++) {
+        t.edge[e][0] = -(to[e]->y - from[e]->y);
+        t.edge[e][1] = to[e]->x - from[e]->x;
+        t.edge[e][2] = (to[e]->y - from[e]->y) * from[e]->x - (to[e]->x - from[e]->x) * from[e]->y;
+    }
+    float inv = 1.0f / area;
+    auto plane = [&](float* out, float fa, float fb, float fc) {
+        for (int k = 0; k < 3; k++) out[k] = (t.edge[0][k] * fa + t.edge[1][k] * fb + t.edge[2][k] * fc) * inv;
+    };
+    // Depth is affine in screen space; attributes are, once divided by w.
+    plane(t.depth, a.z, b.z, cc.z);
+    plane(t.invW, a.iw, b.iw, cc.iw);
+    for (int k = 0; k < 3; k++) {
+        plane(t.pos[k], a.v->pos[k] * a.iw, b.v->pos[k] * b.iw, cc.v->pos[k] * cc.iw);
+        plane(t.normal[k], a.v->normal[k] * a.iw, b.v->normal[k] * b.iw, cc.v->normal[k] * cc.iw);
+    }
+    t.color = c;
+    t.x0 = x0;
+    t.y0 = y0;
+    t.x1 = x1;
+    t.y1 = y1;
+    t.lightsBegin = lightsBegin;
+    t.lightCount = lightCount;
+
+    uint32_t index = (uint32_t)tris.size();
+    tris.push_back(t);
+    for (int ty = y0 / kTile; ty <= y1 / kTile; ty++) {
+        for (int tx = x0 / kTile; tx <= x1 / kTile; tx++) bins[ty * tilesX + tx].push_back(index);
+    }
+}
+
+void SoftwareRasterizer::finish() {
+    PROFILE_SCOPE("Software raster");
+    uint64_t start = profilerNowNs();
+    nextTile = 0;
+    shadedTotal = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        pending = (int)workers.size();
+    }
+    cv.notify_all();
+    rasterizeTiles();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCv.wait(lock, [this] { return pending == 0; });
+    }
+    pixelsShaded = shadedTotal;
+    rasterTime = profilerNowNs() - start;
+}
+
+void SoftwareRasterizer::run() {
+    PROFILE_THREAD("Raster");
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        rasterizeTiles();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) doneCv.notify_one();
+    }
+}
+
+void SoftwareRasterizer::rasterizeTiles() {
+    long long shaded = 0;
+    int tileCount = tilesX * tilesY;
+    for (int tile; (tile = nextTile.fetch_add(1)) < tileCount;) rasterizeTile(tile, shaded);
+    shadedTotal += shaded;
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile, long long& shaded) {
+    int tileX0 = (tile % tilesX) * kTile, tileY0 = (tile / tilesX) * kTile;
+    int tileX1 = std::min(tileX0 + kTile, rowPitch) - 1, tileY1 = std::min(tileY0 + kTile, frameHeight) - 1;
+    glm::vec3 ambient = 0.2f * lightColor;
+
+    for (uint32_t index : bins[tile]) {
+        const Triangle& t = tris[index];
+        int xStart = std::max(t.x0, tileX0) & ~3, xEnd = std::min(t.x1, tileX1);
+        int yStart = std::max(t.y0, tileY0), yEnd = std::min(t.y1, tileY1);
+        const uint16_t* refs = lightRefs.data() + t.lightsBegin;
+
+        for (int y = yStart; y <= yEnd; y++) {
+            float py = y + 0.5f;
+            uint32_t* colorRow = &color[(size_t)y * rowPitch];
+            float* depthRow = &depthBuffer[(size_t)y * rowPitch];
+#if SIMD_SSE2
+            // Planes at this row: A * x + (B * py + C).
+            auto rowPlane = [py](const float* p) { return _mm_set1_ps(p[1] * py + p[2]); };
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), width = _mm_set1_ps((float)frameWidth);
+            __m128 px = _mm_add_ps(_mm_set1_ps(xStart + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+            const __m128 pxStep = _mm_set1_ps(4.0f);
+            for (int x = xStart; x <= xEnd; x += 4, px = _mm_add_ps(px, pxStep)) {
+                auto at = [&](const float* p) { return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), px), rowPlane(p)); };
+                __m128 inside = _mm_and_ps(_mm_cmpge_ps(at(t.edge[0]), zero), _mm_cmpge_ps(at(t.edge[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(at(t.edge[2]), zero));
+                inside = _mm_and_ps(inside, _mm_cmplt_ps(px, width)); // the row's padding
+                if (!_mm_movemask_ps(inside)) continue;
+                __m128 z = at(t.depth);
+                __m128 oldZ = _mm_loadu_ps(depthRow + x);
+                __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, oldZ));
+                int mask = _mm_movemask_ps(pass);
+                if (!mask) continue;
+                _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, oldZ)));
+                shaded += std::popcount((unsigned)mask);
+
+                // default.frag, four fragments at once.
+                __m128 w = _mm_div_ps(one, at(t.invW));
+                __m128 fx = _mm_mul_ps(at(t.pos[0]), w), fy = _mm_mul_ps(at(t.pos[1]), w), fz = _mm_mul_ps(at(t.pos[2]), w);
+                // The normal over w only differs from the normal by a positive scale, which normalizing drops.
+                __m128 nx = at(t.normal[0]), ny = at(t.normal[1]), nz = at(t.normal[2]);
+                __m128 nLen = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)), _mm_set1_ps(1e-30f)));
+                nx = _mm_div_ps(nx, nLen);
+                ny = _mm_div_ps(ny, nLen);
+                nz = _mm_div_ps(nz, nLen);
+                __m128 lx = _mm_sub_ps(_mm_set1_ps(lightPos.x), fx), ly = _mm_sub_ps(_mm_set1_ps(lightPos.y), fy), lz = _mm_sub_ps(_mm_set1_ps(lightPos.z), fz);
+                __m128 lLen = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)), _mm_set1_ps(1e-30f)));
+                __m128 diff = _mm_max_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz)), lLen), zero);
+                __m128 r = _mm_mul_ps(diff, _mm_set1_ps(lightColor.r));
+                __m128 g = _mm_mul_ps(diff, _mm_set1_ps(lightColor.g));
+                __m128 b = _mm_mul_ps(diff, _mm_set1_ps(lightColor.b));
+                for (uint32_t i = 0; i < t.lightCount; i++) {
+                    const Light& light = lights[refs[i]];
+                    __m128 tx = _mm_sub_ps(_mm_set1_ps(light.pos.x), fx), ty = _mm_sub_ps(_mm_set1_ps(light.pos.y), fy), tz = _mm_sub_ps(_mm_set1_ps(light.pos.z), fz);
+                    __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz));
+                    __m128 falloff = _mm_sub_ps(one, _mm_div_ps(dist2, _mm_set1_ps(light.radius * light.radius)));
+                    falloff = _mm_min_ps(_mm_max_ps(falloff, zero), one);
+                    if (!_mm_movemask_ps(_mm_cmpgt_ps(falloff, zero))) continue;
+                    __m128 lit = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz)), _mm_sqrt_ps(_mm_max_ps(dist2, _mm_set1_ps(1e-4f))));
+                    __m128 k = _mm_mul_ps(_mm_max_ps(lit, zero), _mm_mul_ps(falloff, falloff));
+                    r = _mm_add_ps(r, _mm_mul_ps(k, _mm_set1_ps(light.color.r)));
+                    g = _mm_add_ps(g, _mm_mul_ps(k, _mm_set1_ps(light.color.g)));
+                    b = _mm_add_ps(b, _mm_mul_ps(k, _mm_set1_ps(light.color.b)));
+                }
+                // (ambient + diffuse) * baseColor, to 8 bits with rounding.
+                const __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+                auto unorm = [&](__m128 v, float add, float base) {
+                    v = _mm_mul_ps(_mm_add_ps(v, _mm_set1_ps(add)), _mm_set1_ps(base));
+                    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), scale), half));
+                };
+                __m128i rgba = _mm_or_si128(_mm_or_si128(unorm(r, ambient.r, t.color.r), _mm_slli_epi32(unorm(g, ambient.g, t.color.g), 8)),
+                    _mm_or_si128(_mm_slli_epi32(unorm(b, ambient.b, t.color.b), 16), _mm_set1_epi32((int)0xFF000000u)));
+                __m128i keep = _mm_castps_si128(pass);
+                __m128i old = _mm_loadu_si128((const __m128i*)(colorRow + x));
+                _mm_storeu_si128((__m128i*)(colorRow + x), _mm_or_si128(_mm_and_si128(keep, rgba), _mm_andnot_si128(keep, old)));
+            }
+#else
+            for (int x = std::max(t.x0, tileX0); x <= xEnd; x++) {
+                float px = x + 0.5f;
+                auto at = [&](const float* p) { return p[0] * px + p[1] * py + p[2]; };
+                if (at(t.edge[0]) < 0.0f || at(t.edge[1]) < 0.0f || at(t.edge[2]) < 0.0f) continue;
+                float z = at(t.depth);
+                if (!(z < depthRow[x])) continue;
+                depthRow[x] = z;
+                shaded++;
+
+                float w = 1.0f / at(t.invW);
+                glm::vec3 fragPos(at(t.pos[0]) * w, at(t.pos[1]) * w, at(t.pos[2]) * w);
+                glm::vec3 norm(at(t.normal[0]), at(t.normal[1]), at(t.normal[2]));
+                norm /= sqrtf(std::max(glm::dot(norm, norm), 1e-30f));
+                glm::vec3 toMain = lightPos - fragPos;
+                float diff = std::max(glm::dot(norm, toMain) / sqrtf(std::max(glm::dot(toMain, toMain), 1e-30f)), 0.0f);
+                glm::vec3 diffuse = diff * lightColor;
+                for (uint32_t i = 0; i < t.lightCount; i++) {
+                    const Light& light = lights[refs[i]];
+                    glm::vec3 toLight = light.pos - fragPos;
+                    float dist2 = glm::dot(toLight, toLight);
+                    float falloff = std::clamp(1.0f - dist2 / (light.radius * light.radius), 0.0f, 1.0f);
+                    float lit = std::max(glm::dot(norm, toLight) / sqrtf(std::max(dist2, 1e-4f)), 0.0f);
+                    diffuse += lit * falloff * falloff * light.color;
+                }
+                glm::vec3 result = (ambient + diffuse) * t.color;
+                colorRow[x] = packColor(result.r, result.g, result.b);
+            }
+#endif
+        }
+    }
+}
+
+bool SoftwareRasterizer::writePpm(const std::string& path) const {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", frameWidth, frameHeight);
+    std::vector<unsigned char> row((size_t)frameWidth * 3);
+    for (int y = frameHeight - 1; y >= 0; y--) {
+        const uint32_t* src = &color[(size_t)y * rowPitch];
+        for (int x = 0; x < frameWidth; x++) {
+            row[x * 3] = (unsigned char)(src[x] & 0xFF);
+            row[x * 3 + 1] = (unsigned char)(src[x] >> 8 & 0xFF);
+            row[x * 3 + 2] = (unsigned char)(src[x] >> 16 & 0xFF);
+        }
+        fwrite(row.data(), 1, row.size(), f);
+    }
+    fclose(f);
+    return true;
+}
+
+void rasterizeWorld(SoftwareRasterizer& raster, const SoftwareWorldMeshes& meshes, const glm::mat4& view, const glm::mat4& projection) {
+    PROFILE_SCOPE("Software draws");
+    player& p = players[0];
+    raster.setCamera(view, projection);
+    raster.setLight(p.pos, glm::vec3(1.0f, 1.0f, 1.0f));
+    raster.clearLights();
+    for (auto& e : emersons) raster.addLight(e.pos + glm::vec3(0.0f, 1.5f, 0.0f), 10.0f, glm::vec3(0.6f, 0.2f, 0.8f));
+    for (auto& proj : projectiles) raster.addLight(proj.pos, 5.0f, glm::vec3(1.0f, 0.8f, 0.5f));
+    for (auto& f : splashFlashes) raster.addLight(f.pos + glm::vec3(0.0f, 0.5f, 0.0f), 6.0f * f.life, f.color * (2.0f * f.life));
+
+    raster.drawInstanced(meshes.cube, cubes.data(), (int)cubes.size());
+    for (auto& pill : pillars) raster.draw(meshes.pillar, glm::translate(glm::mat4(1.0f), pill.pos), pill.color);
+    raster.draw(meshes.floater, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 10.0f, 0.0f)), glm::vec3(1.0f, 1.0f, 1.0f));
+    for (auto& e : emersons) raster.draw(meshes.emerson, emersonTransform(e), glm::vec3(1.0f, 0.0f, 1.0f));
+    for (auto& proj : projectiles) raster.draw(meshes.projectile, projectileTransform(proj), proj.color);
+    for (auto& s : splashParticles) {
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), s.pos), glm::vec3(0.3f * s.life));
+        raster.draw(meshes.cube, model, s.color);
+    }
+    if (usingSkyCamera) {
+        glm::mat4 pModel = glm::translate(glm::mat4(1.0f), p.pos);
+        pModel = glm::rotate(pModel, glm::radians(-p.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+        pModel = glm::rotate(pModel, glm::radians(p.pitch), glm::vec3(0.0f, 0.0f, 1.0f));
+        pModel = glm::scale(pModel, glm::vec3(0.8f));
+        raster.draw(meshes.cube, pModel, p.color);
+    }
+}
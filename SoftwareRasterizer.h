@@ -0,0 +1,147 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CubeInstance;
+class objModel;
+
+// CPU rendering backend for machines with no GPU or GL at all. It takes the
+// same draws as the forward GL path's default program (default.vert +
+// default.frag) - a mesh with a model matrix and color, or instanced cubes -
+// and shades them the same way: ambient and diffuse from the main light plus
+// the point lights, per pixel, into an RGBA8 color and a float depth buffer.
+//
+// draw() only transforms, clips (near and far planes, as GL does) and sets
+// triangles up, binning each into the kTile x kTile screen tiles its bounds
+// touch. finish() then rasterizes: the main thread and the workers take tiles
+// off a shared counter, and a tile runs its bin in submission order, so each
+// pixel is only ever touched by one thread and the image does not depend on
+// the thread count. Within a triangle, edge functions, depth and the
+// perspective-correct attributes are planes stepped four pixels at a time
+// with SSE2.
+class SoftwareRasterizer {
+public:
+    static constexpr int kTile = 32;
+    static constexpr int kMaxThreads = 16;
+
+    // CPU copy of a mesh, laid out the way default.vert reads it.
+    struct MeshData {
+        std::vector<glm::vec3> positions;   // aPos
+        std::vector<glm::vec3> normals;     // aNormal
+        std::vector<uint32_t> indices;      // three per triangle
+
+        // Same arguments as Mesh's constructor: interleaved floats, position
+        // first and normal second.
+        static MeshData fromArray(const float* vertices, size_t dataSize, const std::vector<int>& layout);
+        // objModel meshes carry a texcoord where default.vert expects the
+        // normal, and GL reads it as (u, v, 0); so does this, to match.
+        static MeshData fromModel(const objModel& model);
+    };
+
+    SoftwareRasterizer();
+    ~SoftwareRasterizer();
+    SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+    SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+    // Uniforms of the default program.
+    void setCamera(const glm::mat4& view, const glm::mat4& projection);
+    void setLight(const glm::vec3& pos, const glm::vec3& color);
+    // Point lights, as given to LightGrid::add().
+    void clearLights() { lights.clear(); }
+    void addLight(const glm::vec3& pos, float radius, const glm::vec3& color);
+
+    // Starts a frame: clears color to clearColor and depth to 1.
+    void begin(int width, int height, const glm::vec3& clearColor);
+    // isInstanced = 0: model matrix, playerColor.
+    void draw(const MeshData& mesh, const glm::mat4& model, const glm::vec3& color);
+    // isInstanced = 1: one copy per instance with its scale, rotation and color.
+    void drawInstanced(const MeshData& mesh, const CubeInstance* instances, int count);
+    // Rasterizes everything drawn since begin().
+    void finish();
+
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+    // RGBA8, bottom row first like glReadPixels, rows pitch() pixels apart.
+    const uint32_t* pixels() const { return color.data(); }
+    int pitch() const { return rowPitch; }
+    // Binary PPM, top row first.
+    bool writePpm(const std::string& path) const;
+
+    // Last frame: triangles that reached setup, pixels that passed the
+    // depth test, and the time spent in each half.
+    long long triangleCount() const { return (long long)tris.size(); }
+    long long pixelCount() const { return pixelsShaded; }
+    uint64_t setupNs() const { return setupTime; }
+    uint64_t rasterNs() const { return rasterTime; }
+    int threadCount() const { return (int)workers.size() + 1; }
+
+private:
+    struct ClipVertex;
+    // A triangle ready to rasterize: edge functions, window depth, 1/w and
+    // the world position and normal over w, all as planes A*x + B*y + C
+    // over pixel centres. Edges are >= 0 inside.
+    struct Triangle {
+        float edge[3][3];
+        float depth[3];
+        float invW[3];
+        float pos[3][3];
+        float normal[3][3];
+        glm::vec3 color;
+        int x0, y0, x1, y1;
+        uint32_t lightsBegin, lightCount;
+    };
+    struct Light {
+        glm::vec3 pos;
+        float radius;
+        glm::vec3 color;
+    };
+
+    void drawTransformed(const MeshData& mesh, const glm::mat4& model, const glm::mat3& normalMatrix, const glm::vec3& color);
+    void setupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const glm::vec3& color, uint32_t lightsBegin, uint32_t lightCount);
+    void rasterizeTiles();
+    void rasterizeTile(int tile, long long& shaded);
+    void run();
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec3 lightPos = glm::vec3(0.0f), lightColor = glm::vec3(1.0f);
+    std::vector<Light> lights;
+    std::vector<uint16_t> lightRefs;        // per draw: the lights touching its bounds
+
+    int frameWidth = 0, frameHeight = 0, rowPitch = 0;
+    int tilesX = 0, tilesY = 0;
+    std::vector<uint32_t> color;
+    std::vector<float> depthBuffer;
+    std::vector<Triangle> tris;
+    std::vector<std::vector<uint32_t>> bins;   // triangle indices per tile, in draw order
+
+    long long pixelsShaded = 0;
+    uint64_t setupTime = 0, rasterTime = 0;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable cv, doneCv;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool quit = false;
+    std::atomic<int> nextTile{ 0 };
+    std::atomic<long long> shadedTotal{ 0 };
+};
+
+// The world as the forward GL path draws it in source.cpp: instanced cubes,
+// pillars, the floater, emersons, projectiles, splash particles and the
+// player in sky view, lit by the same point lights. The terrain, health bars
+// and debug hitboxes are left out.
+struct SoftwareWorldMeshes {
+    SoftwareRasterizer::MeshData cube, pillar, floater, emerson, projectile;
+};
+void rasterizeWorld(SoftwareRasterizer& raster, const SoftwareWorldMeshes& meshes, const glm::mat4& view, const glm::mat4& projection);
+
+#endif
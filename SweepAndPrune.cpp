@@ -0,0 +1,197 @@
+#include "SweepAndPrune.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace {
+    inline uint64_t pairKey(const SweepAndPrune::Pair& p) { return ((uint64_t)p.a << 32) | (uint32_t)p.b; }
+    inline bool pairLess(const SweepAndPrune::Pair& x, const SweepAndPrune::Pair& y) { return pairKey(x) < pairKey(y); }
+}
+
+SweepAndPrune& broadphase() {
+    static SweepAndPrune sap;
+    return sap;
+}
+
+void SweepAndPrune::beginSync() {
+    tick++;
+    // Ids freed last tick have had their end events reported: safe to reuse.
+    freeList.insert(freeList.end(), pendingFree.begin(), pendingFree.end());
+    pendingFree.clear();
+}
+
+void SweepAndPrune::sync(uint64_t key, const glm::vec3& min, const glm::vec3& max, uint32_t layer, uint32_t mask) {
+    int id;
+    auto it = keyToProxy.find(key);
+    if (it != keyToProxy.end()) {
+        id = it->second;
+    }
+    else {
+        if (!freeList.empty()) {
+            id = freeList.back();
+            freeList.pop_back();
+        }
+        else {
+            id = (int)proxies.size();
+            proxies.push_back(Proxy());
+        }
+        keyToProxy[key] = id;
+        added.push_back(id);
+    }
+    Proxy& p = proxies[id];
+    p.min = min;
+    p.max = max;
+    p.key = key;
+    p.layer = layer;
+    p.mask = mask;
+    p.lastSync = tick;
+}
+
+inline void SweepAndPrune::test(const SweepBox& p, const SweepBox& q) {
+    // Non-short-circuit &: whether a candidate passes is close to a coin
+    // flip, so one combined branch beats five mispredicted ones.
+    bool hit = ((p.layer & q.mask) != 0) & ((q.layer & p.mask) != 0) &
+        (p.max[1] >= q.min[1]) & (q.max[1] >= p.min[1]) &
+        (p.max[2] >= q.min[2]) & (q.max[2] >= p.min[2]);
+    if (!hit) return;
+    current.push_back(p.id < q.id ? Pair{ p.id, q.id } : Pair{ q.id, p.id });
+}
+
+void SweepAndPrune::sweepSelf(const std::vector<SweepBox>& boxes) {
+    size_t n = boxes.size();
+    for (size_t i = 0; i < n; i++) {
+        float end = boxes[i].max[0];
+        for (size_t j = i + 1; j < n && boxes[j].min[0] <= end; j++) test(boxes[i], boxes[j]);
+    }
+}
+
+// Two sorted lists walked together: whichever box starts first scans the
+// other list for boxes starting before it ends, so each overlap is seen once.
+void SweepAndPrune::sweepPair(const std::vector<SweepBox>& a, const std::vector<SweepBox>& b) {
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i].min[0] < b[j].min[0]) {
+            float end = a[i].max[0];
+            for (size_t k = j; k < b.size() && b[k].min[0] <= end; k++) test(a[i], b[k]);
+            i++;
+        }
+        else {
+            float end = b[j].max[0];
+            for (size_t k = i; k < a.size() && a[k].min[0] <= end; k++) test(a[k], b[j]);
+            j++;
+        }
+    }
+}
+
+void SweepAndPrune::endSync() {
+    PROFILE_SCOPE("Broadphase");
+
+    // 1. Drop proxies that weren't synced this tick.
+    size_t live = 0;
+    for (int id : sorted) {
+        Proxy& p = proxies[id];
+        if (p.lastSync == tick) {
+            sorted[live++] = id;
+            continue;
+        }
+        keyToProxy.erase(p.key);
+        pendingFree.push_back(id);
+    }
+    sorted.resize(live);
+
+    // 2. Sweep along the axis where the centres are most spread out, so the
+    // 1D overlap test rejects as much as possible. Only switch once another
+    // axis is clearly better: a switch costs a full sort.
+    glm::vec3 sum(0.0f), sumSq(0.0f);
+    for (int id : sorted) {
+        glm::vec3 c = (proxies[id].min + proxies[id].max) * 0.5f;
+        sum += c;
+        sumSq += c * c;
+    }
+    for (int id : added) {
+        glm::vec3 c = (proxies[id].min + proxies[id].max) * 0.5f;
+        sum += c;
+        sumSq += c * c;
+    }
+    int axis = sortAxis;
+    size_t count = sorted.size() + added.size();
+    if (count > 0) {
+        glm::vec3 variance = sumSq / (float)count - (sum * sum) / (float)(count * count);
+        int best = variance.x >= variance.y ? (variance.x >= variance.z ? 0 : 2) : (variance.y >= variance.z ? 1 : 2);
+        if (variance[best] > variance[sortAxis] * 1.25f) axis = best;
+    }
+
+    // 3. Re-sort. Same axis as last tick: insertion sort, about O(n) for
+    // coherent motion, then merge in the sorted newcomers. New axis: the old
+    // order is no help, full sort.
+    auto minOf = [&](int id) { return proxies[id].min[axis]; };
+    auto byMin = [&](int x, int y) { return minOf(x) < minOf(y); };
+    if (axis != sortAxis) {
+        sorted.insert(sorted.end(), added.begin(), added.end());
+        std::sort(sorted.begin(), sorted.end(), byMin);
+        sortAxis = axis;
+    }
+    else {
+        for (size_t i = 1; i < sorted.size(); i++) {
+            int id = sorted[i];
+            float v = minOf(id);
+            size_t j = i;
+            while (j > 0 && minOf(sorted[j - 1]) > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = id;
+        }
+        std::sort(added.begin(), added.end(), byMin);
+        size_t mid = sorted.size();
+        sorted.insert(sorted.end(), added.begin(), added.end());
+        std::inplace_merge(sorted.begin(), sorted.begin() + mid, sorted.end(), byMin);
+    }
+    added.clear();
+
+    // 4. Split into one sorted list per layer (by lowest layer bit), as
+    // packed copies with the sweep axis first so the scans don't chase ids
+    // into the proxy array. Layer pairs the masks rule out are never swept:
+    // a crowd of cubes that don't collide with each other costs nothing.
+    for (auto& bucket : buckets) bucket.boxes.clear();
+    for (int id : sorted) {
+        const Proxy& p = proxies[id];
+        int bit = 0;
+        while (bit < 31 && !(p.layer & (1u << bit))) bit++;
+        if ((int)buckets.size() <= bit) buckets.resize(bit + 1);
+        Bucket& bucket = buckets[bit];
+        if (bucket.boxes.empty()) bucket.layers = bucket.masks = 0;
+        bucket.layers |= p.layer;
+        bucket.masks |= p.mask;
+        SweepBox b;
+        for (int k = 0; k < 3; k++) {
+            b.min[k] = p.min[(axis + k) % 3];
+            b.max[k] = p.max[(axis + k) % 3];
+        }
+        b.layer = p.layer;
+        b.mask = p.mask;
+        b.id = id;
+        bucket.boxes.push_back(b);
+    }
+
+    // 5. Sweep every layer pair that can interact: each box only meets the
+    // ones that start before it ends.
+    previous.swap(current);
+    current.clear();
+    for (size_t x = 0; x < buckets.size(); x++) {
+        for (size_t y = x; y < buckets.size(); y++) {
+            const Bucket& bx = buckets[x];
+            const Bucket& by = buckets[y];
+            if (bx.boxes.empty() || by.boxes.empty()) continue;
+            if (!(bx.layers & by.masks) || !(by.layers & bx.masks)) continue;
+            if (x == y) sweepSelf(bx.boxes);
+            else sweepPair(bx.boxes, by.boxes);
+        }
+    }
+
+    // 6. Events: difference of the sorted pair lists.
+    std::sort(current.begin(), current.end(), pairLess);
+    beginEvents.clear();
+    endEvents.clear();
+    std::set_difference(current.begin(), current.end(), previous.begin(), previous.end(), std::back_inserter(beginEvents), pairLess);
+    std::set_difference(previous.begin(), previous.end(), current.begin(), current.end(), std::back_inserter(endEvents), pairLess);
+}
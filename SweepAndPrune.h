@@ -0,0 +1,82 @@
+#ifndef SWEEP_AND_PRUNE_H
+#define SWEEP_AND_PRUNE_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Collision layers. A pair is only considered if each side's layer is in the
+// other side's mask.
+enum CollisionLayer : uint32_t {
+    LAYER_PLAYER  = 1 << 0,
+    LAYER_ENEMY   = 1 << 1,
+    LAYER_EMERSON = 1 << 2,
+    LAYER_PILLAR  = 1 << 3,
+};
+
+// Sweep-and-prune broadphase over AABBs with a persistent pair set.
+// Every tick: beginSync(), sync() each live entity under a stable key,
+// endSync(). Proxies not synced are removed. endSync() picks the axis with the
+// most variance in box centres, re-sorts the proxies along it with an
+// insertion sort (nearly free when things moved a little since last tick),
+// sweeps for overlaps, and diffs them against last tick's pairs to produce
+// begin / end events.
+class SweepAndPrune {
+public:
+    struct Pair {
+        int a, b;   // proxy ids, a < b
+    };
+
+    void beginSync();
+    void sync(uint64_t key, const glm::vec3& min, const glm::vec3& max, uint32_t layer, uint32_t mask);
+    void endSync();
+
+    const std::vector<Pair>& pairs() const { return current; }    // overlapping now
+    const std::vector<Pair>& begins() const { return beginEvents; } // started this tick
+    const std::vector<Pair>& ends() const { return endEvents; }     // stopped this tick
+
+    uint64_t key(int proxy) const { return proxies[proxy].key; }
+    uint32_t layer(int proxy) const { return proxies[proxy].layer; }
+    int proxyCount() const { return (int)keyToProxy.size(); }
+    int axis() const { return sortAxis; }
+
+private:
+    struct Proxy {
+        glm::vec3 min, max;
+        uint64_t key;
+        uint32_t layer, mask;
+        uint32_t lastSync;
+    };
+    struct SweepBox {
+        float min[3], max[3];  // [0] is the sweep axis, [1] and [2] the other two
+        uint32_t layer, mask;
+        int id;
+    };
+    struct Bucket {
+        std::vector<SweepBox> boxes;   // sorted on the sweep axis
+        uint32_t layers, masks;        // unions over the boxes
+    };
+
+    void test(const SweepBox& p, const SweepBox& q);
+    void sweepSelf(const std::vector<SweepBox>& boxes);
+    void sweepPair(const std::vector<SweepBox>& a, const std::vector<SweepBox>& b);
+
+    std::vector<Proxy> proxies;
+    std::unordered_map<uint64_t, int> keyToProxy;
+    std::vector<int> freeList;
+    std::vector<int> pendingFree;  // reused only after this tick's events, so ids stay unambiguous
+    std::vector<int> sorted;       // live proxy ids ordered by min on sortAxis
+    std::vector<int> added;        // new this tick, merged into sorted by endSync
+    std::vector<Bucket> buckets;   // per lowest layer bit, rebuilt each endSync
+    int sortAxis = 0;
+    uint32_t tick = 0;
+
+    std::vector<Pair> current, previous;
+    std::vector<Pair> beginEvents, endEvents;
+};
+
+// The game's broadphase, synced once per simulation tick.
+SweepAndPrune& broadphase();
+
+#endif
@@ -0,0 +1,279 @@
+#include "Terrain.h"
+#include "common.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    constexpr int kSamples = Terrain::kCells + 1;
+
+    // Lattice value noise in [-1, 1].
+    float lattice(int x, int z) {
+        uint32_t h = (uint32_t)x * 374761393u + (uint32_t)z * 668265263u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        h ^= h >> 16;
+        return (h & 0xffff) / 32767.5f - 1.0f;
+    }
+
+    float valueNoise(float x, float z) {
+        int ix = (int)std::floor(x), iz = (int)std::floor(z);
+        float tx = x - ix, tz = z - iz;
+        tx = tx * tx * (3.0f - 2.0f * tx);
+        tz = tz * tz * (3.0f - 2.0f * tz);
+        float a = lattice(ix, iz), b = lattice(ix + 1, iz);
+        float c = lattice(ix, iz + 1), d = lattice(ix + 1, iz + 1);
+        return (a + (b - a) * tx) + ((c + (d - c) * tx) - (a + (b - a) * tx)) * tz;
+    }
+
+    float fbm(float x, float z) {
+        float sum = 0.0f, amp = 0.5f, norm = 0.0f;
+        for (int i = 0; i < 5; i++) {
+            sum += valueNoise(x, z) * amp;
+            norm += amp;
+            x *= 2.0f;
+            z *= 2.0f;
+            amp *= 0.5f;
+        }
+        return sum / norm;
+    }
+
+    bool sphereHitsBox(const glm::vec3& c, float r, const glm::vec3& bmin, const glm::vec3& bmax) {
+        glm::vec3 d = glm::max(glm::max(bmin - c, c - bmax), glm::vec3(0.0f));
+        return glm::dot(d, d) <= r * r;
+    }
+
+    bool boxInFrustum(const glm::vec4* planes, const glm::vec3& bmin, const glm::vec3& bmax) {
+        for (int i = 0; i < 6; i++) {
+            const glm::vec4& p = planes[i];
+            // Corner furthest along the plane normal
+            glm::vec3 v(p.x >= 0.0f ? bmax.x : bmin.x, p.y >= 0.0f ? bmax.y : bmin.y, p.z >= 0.0f ? bmax.z : bmin.z);
+            if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f) return false;
+        }
+        return true;
+    }
+}
+
+Terrain& terrain() {
+    static Terrain t;
+    return t;
+}
+
+Terrain::Terrain() {
+    PROFILE_SCOPE("Terrain generate");
+    // Gentle bumps around the arena, hills further out. Never below groundy,
+    // so anything placed for the old flat floor still starts above ground.
+    heights.resize(kSamples * kSamples);
+    for (int z = 0; z < kSamples; z++) {
+        for (int x = 0; x < kSamples; x++) {
+            float wx = kOrigin + x * kCellSize, wz = kOrigin + z * kCellSize;
+            float r = std::sqrt(wx * wx + wz * wz);
+            float s = std::clamp((r - 40.0f) / 70.0f, 0.0f, 1.0f);
+            float amp = 0.6f + 9.0f * s * s * (3.0f - 2.0f * s);
+            heights[z * kSamples + x] = groundy + amp * (0.5f + 0.5f * fbm(wx / 48.0f, wz / 48.0f));
+        }
+    }
+    maxHeight = *std::max_element(heights.begin(), heights.end());
+
+    // Height range of every quadtree node: leaves from the samples they cover
+    // (edges shared with neighbours), parents from their children.
+    int leaves = kCells / kLeafCells;
+    nodeRange[0].resize(leaves * leaves);
+    for (int nz = 0; nz < leaves; nz++) {
+        for (int nx = 0; nx < leaves; nx++) {
+            glm::vec2 range(FLT_MAX, -FLT_MAX);
+            for (int z = nz * kLeafCells; z <= (nz + 1) * kLeafCells; z++) {
+                for (int x = nx * kLeafCells; x <= (nx + 1) * kLeafCells; x++) {
+                    range.x = std::min(range.x, sample(x, z));
+                    range.y = std::max(range.y, sample(x, z));
+                }
+            }
+            nodeRange[0][nz * leaves + nx] = range;
+        }
+    }
+    for (int level = 1; level < kLevels; level++) {
+        int n = leaves >> level;
+        const std::vector<glm::vec2>& child = nodeRange[level - 1];
+        nodeRange[level].resize(n * n);
+        for (int nz = 0; nz < n; nz++) {
+            for (int nx = 0; nx < n; nx++) {
+                glm::vec2 range(FLT_MAX, -FLT_MAX);
+                for (int c = 0; c < 4; c++) {
+                    const glm::vec2& r = child[(nz * 2 + (c >> 1)) * n * 2 + nx * 2 + (c & 1)];
+                    range.x = std::min(range.x, r.x);
+                    range.y = std::max(range.y, r.y);
+                }
+                nodeRange[level][nz * n + nx] = range;
+            }
+        }
+    }
+
+    // Each level covers twice the distance of the one below; the root covers
+    // the whole map from anywhere on it.
+    for (int level = 0; level < kLevels; level++) lodRange[level] = 32.0f * (float)(1 << level);
+    lodRange[kLevels - 1] = std::max(lodRange[kLevels - 1], kCells * kCellSize * 2.0f);
+}
+
+float Terrain::heightAt(float x, float z) const {
+    float fx = std::clamp((x - kOrigin) / kCellSize, 0.0f, (float)kCells);
+    float fz = std::clamp((z - kOrigin) / kCellSize, 0.0f, (float)kCells);
+    int ix = std::min((int)fx, kCells - 1), iz = std::min((int)fz, kCells - 1);
+    float tx = fx - ix, tz = fz - iz;
+    float a = sample(ix, iz), b = sample(ix + 1, iz);
+    float c = sample(ix, iz + 1), d = sample(ix + 1, iz + 1);
+    float top = a + (b - a) * tx;
+    float bottom = c + (d - c) * tx;
+    return top + (bottom - top) * tz;
+}
+
+glm::vec3 Terrain::normalAt(float x, float z) const {
+    float l = heightAt(x - kCellSize, z), r = heightAt(x + kCellSize, z);
+    float d = heightAt(x, z - kCellSize), u = heightAt(x, z + kCellSize);
+    return glm::normalize(glm::vec3(l - r, 2.0f * kCellSize, d - u));
+}
+
+bool Terrain::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, float& t) const {
+    // Only the stretch of the ray below the highest sample can hit.
+    float tStart = 0.0f, tEnd = maxDist;
+    if (origin.y > maxHeight) {
+        if (dir.y >= 0.0f) return false;
+        tStart = (origin.y - maxHeight) / -dir.y;
+    }
+    if (dir.y > 0.0f) tEnd = std::min(tEnd, (maxHeight - origin.y) / dir.y);
+    if (tStart > tEnd) return false;
+
+    // March in half-cell steps until the ray goes under the surface, then
+    // bisect the last step.
+    const float step = 0.5f * kCellSize;
+    auto above = [&](float s) {
+        glm::vec3 p = origin + dir * s;
+        return p.y >= heightAt(p.x, p.z);
+    };
+    if (!above(tStart)) return false; // starts underground
+    float prev = tStart;
+    while (prev < tEnd) {
+        float next = std::min(prev + step, tEnd);
+        if (!above(next)) {
+            float lo = prev, hi = next;
+            for (int i = 0; i < 10; i++) {
+                float mid = 0.5f * (lo + hi);
+                if (above(mid)) lo = mid;
+                else hi = mid;
+            }
+            t = hi;
+            return true;
+        }
+        prev = next;
+    }
+    return false;
+}
+
+void Terrain::initGL() {
+    glGenTextures(1, &heightTex);
+    glBindTexture(GL_TEXTURE_2D, heightTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, kSamples, kSamples, 0, GL_RED, GL_FLOAT, heights.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // One kLeafCells^2 grid over [0,1]^2, stored quadrant by quadrant so a
+    // node can draw any of its children's areas at its own resolution.
+    const int half = kLeafCells / 2;
+    std::vector<float> verts;
+    verts.reserve(4 * half * half * 12);
+    for (int q = 0; q < 4; q++) {
+        for (int z = 0; z < half; z++) {
+            for (int x = 0; x < half; x++) {
+                float x0 = (float)((q & 1) * half + x) / kLeafCells, x1 = x0 + 1.0f / kLeafCells;
+                float z0 = (float)((q >> 1) * half + z) / kLeafCells, z1 = z0 + 1.0f / kLeafCells;
+                float quad[12] = { x0, z0, x0, z1, x1, z0,   x1, z0, x0, z1, x1, z1 };
+                verts.insert(verts.end(), quad, quad + 12);
+            }
+        }
+    }
+    quarterVerts = half * half * 6;
+
+    glGenVertexArrays(1, &gridVAO);
+    glGenBuffers(1, &gridVBO);
+    glState().bindVertexArray(gridVAO);
+    glState().bindBuffer(GL_ARRAY_BUFFER, gridVBO);
+    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glState().bindVertexArray(0);
+}
+
+// CDLOD selection. Returns false if the node is outside its level's range,
+// in which case the parent draws that area at the parent's level.
+bool Terrain::select(int level, int x, int z, const glm::vec4* planes, const glm::vec3& cameraPos) {
+    float size = kCellSize * (float)(kLeafCells << level);
+    const glm::vec2& range = nodeRange[level][z * ((kCells / kLeafCells) >> level) + x];
+    glm::vec3 bmin(kOrigin + x * size, range.x, kOrigin + z * size);
+    glm::vec3 bmax(bmin.x + size, range.y, bmin.z + size);
+    if (!sphereHitsBox(cameraPos, lodRange[level], bmin, bmax)) return false;
+    if (!boxInFrustum(planes, bmin, bmax)) return true; // handled: nothing to draw
+    if (level == 0 || !sphereHitsBox(cameraPos, lodRange[level - 1], bmin, bmax)) {
+        selection.push_back({ level, x, z, 0xF });
+        return true;
+    }
+    int quarters = 0;
+    for (int c = 0; c < 4; c++) {
+        if (!select(level - 1, x * 2 + (c & 1), z * 2 + (c >> 1), planes, cameraPos)) quarters |= 1 << c;
+    }
+    if (quarters) selection.push_back({ level, x, z, quarters });
+    return true;
+}
+
+void Terrain::draw(Shader& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPos) {
+    glm::vec4 planes[6];
+    {
+        PROFILE_SCOPE("Terrain select");
+        // Frustum planes straight from the matrix rows (Gribb-Hartmann).
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; i++) row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        for (int i = 0; i < 3; i++) {
+            planes[i * 2] = row[3] + row[i];
+            planes[i * 2 + 1] = row[3] - row[i];
+        }
+        selection.clear();
+        if (!select(kLevels - 1, 0, 0, planes, cameraPos)) selection.push_back({ kLevels - 1, 0, 0, 0xF });
+        lastNodes = (int)selection.size();
+    }
+
+    shader.setInt("heightmap", 0);
+    shader.setVec4("terrain", glm::vec4(kOrigin, kOrigin, kCellSize, (float)kSamples));
+    shader.setFloat("gridDim", (float)kLeafCells);
+    shader.setVec3("cameraPos", cameraPos);
+    GLint nodeLoc = glGetUniformLocation(shader.ID, "node");
+    GLint morphLoc = glGetUniformLocation(shader.ID, "morph");
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heightTex);
+    glState().bindVertexArray(gridVAO);
+    for (const NodeDraw& n : selection) {
+        float size = kCellSize * (float)(kLeafCells << n.level);
+        const float node[3] = { kOrigin + n.x * size, kOrigin + n.z * size, size };
+        glState().uniform3f(nodeLoc, node);
+        // Morph over the last 30% of the level's range, fully coarse at its
+        // edge; nodes of one level share it, so it is only sent once.
+        float end = lodRange[n.level];
+        float start = n.level > 0 ? lodRange[n.level - 1] : 0.0f;
+        const float morph[2] = { start + (end - start) * 0.7f, end };
+        glState().uniform2f(morphLoc, morph);
+        if (n.quarters == 0xF) {
+            frameDrawCalls++;
+            glDrawArrays(GL_TRIANGLES, 0, quarterVerts * 4);
+            continue;
+        }
+        for (int q = 0; q < 4; q++) {
+            if (!(n.quarters & (1 << q))) continue;
+            frameDrawCalls++;
+            glDrawArrays(GL_TRIANGLES, q * quarterVerts, quarterVerts);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,62 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Shader;
+
+// Heightfield ground. Heights live on a regular grid of kCells x kCells cells
+// (kCells + 1 samples per side); the simulation reads them with an O(1)
+// bilinear lookup. Rendering is CDLOD: a quadtree of chunks over the grid,
+// each with its height range for culling, picks per-node LOD levels by
+// distance to the camera, and every selected node is drawn with the same
+// shared grid mesh, heights fetched from a texture in the vertex shader.
+// Vertices morph towards the next coarser level over the end of each LOD
+// range, so levels meet without cracks or popping.
+class Terrain {
+public:
+    static constexpr int kCells = 256;         // per side
+    static constexpr float kCellSize = 1.0f;
+    static constexpr float kOrigin = -128.0f;  // world x/z of the grid corner
+    static constexpr int kLeafCells = 16;      // finest quadtree node, and the grid mesh resolution
+    static constexpr int kLevels = 5;          // leaf (16 cells) .. root (256 cells)
+
+    Terrain();
+
+    // Ground height under x/z, bilinear between samples. Clamps at the edges.
+    float heightAt(float x, float z) const;
+    glm::vec3 normalAt(float x, float z) const;
+    // First ground hit along a unit ray within maxDist.
+    bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, float& t) const;
+
+    // GL side. initGL() needs a context; draw() expects shader to be the
+    // terrain program (shaders/terrain.vert) with view/projection already set.
+    void initGL();
+    void draw(Shader& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPos);
+    int drawnNodes() const { return lastNodes; }
+
+private:
+    struct NodeDraw {
+        int level, x, z;
+        int quarters;   // bit per child quadrant drawn at this level
+    };
+
+    float sample(int x, int z) const { return heights[z * (kCells + 1) + x]; }
+    bool select(int level, int x, int z, const glm::vec4* planes, const glm::vec3& cameraPos);
+
+    std::vector<float> heights;
+    std::vector<glm::vec2> nodeRange[kLevels];  // min/max height per node, per level
+    float lodRange[kLevels];
+    float maxHeight;
+
+    GLuint heightTex = 0, gridVAO = 0, gridVBO = 0;
+    int quarterVerts = 0;
+    std::vector<NodeDraw> selection;
+    int lastNodes = 0;
+};
+
+Terrain& terrain();
+
+#endif
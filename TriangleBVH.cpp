@@ -0,0 +1,289 @@
+#include "TriangleBVH.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    constexpr int kBins = 12;
+    constexpr int kMaxStack = 128;
+
+    struct Box {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+        void grow(const glm::vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+        void grow(const Box& b) { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+        float area() const {
+            glm::vec3 d = max - min;
+            return d.x < 0.0f ? 0.0f : 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+        }
+    };
+
+    struct BuildTri {
+        Box box;
+        glm::vec3 centroid;
+    };
+
+    struct BinaryNode {
+        Box box;
+        int left = -1, right = -1;   // -1: leaf
+        int start = 0, count = 0;
+    };
+
+    // Top-down binned SAH build into a binary tree over order[].
+    struct Builder {
+        const std::vector<BuildTri>& tris;
+        std::vector<uint32_t>& order;
+        std::vector<BinaryNode> nodes;
+
+        int build(int start, int count) {
+            BinaryNode node;
+            Box centroids;
+            for (int i = start; i < start + count; i++) {
+                node.box.grow(tris[order[i]].box);
+                centroids.grow(tris[order[i]].centroid);
+            }
+            node.start = start;
+            node.count = count;
+            int index = (int)nodes.size();
+            nodes.push_back(node);
+            if (count <= TriangleBVH::kLeafSize) return index;
+
+            // Cheapest split over kBins centroid bins on each axis.
+            float bestCost = FLT_MAX;
+            int bestAxis = -1, bestSplit = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                float extent = centroids.max[axis] - centroids.min[axis];
+                if (extent <= 1e-12f) continue;
+                float scale = kBins / extent;
+                Box binBox[kBins];
+                int binCount[kBins] = {};
+                for (int i = start; i < start + count; i++) {
+                    const BuildTri& t = tris[order[i]];
+                    int b = std::min(kBins - 1, (int)((t.centroid[axis] - centroids.min[axis]) * scale));
+                    binBox[b].grow(t.box);
+                    binCount[b]++;
+                }
+                float leftArea[kBins - 1];
+                int leftCount[kBins - 1];
+                Box acc;
+                int n = 0;
+                for (int b = 0; b < kBins - 1; b++) {
+                    acc.grow(binBox[b]);
+                    n += binCount[b];
+                    leftArea[b] = acc.area();
+                    leftCount[b] = n;
+                }
+                acc = Box();
+                n = 0;
+                for (int b = kBins - 1; b > 0; b--) {
+                    acc.grow(binBox[b]);
+                    n += binCount[b];
+                    float cost = leftArea[b - 1] * leftCount[b - 1] + acc.area() * n;
+                    if (leftCount[b - 1] > 0 && n > 0 && cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = b;
+                    }
+                }
+            }
+
+            int mid = start + count / 2;
+            if (bestAxis >= 0) {
+                float scale = kBins / (centroids.max[bestAxis] - centroids.min[bestAxis]);
+                float lo = centroids.min[bestAxis];
+                auto it = std::partition(order.begin() + start, order.begin() + start + count, [&](uint32_t i) {
+                    return std::min(kBins - 1, (int)((tris[i].centroid[bestAxis] - lo) * scale)) < bestSplit;
+                    });
+                mid = (int)(it - order.begin());
+                if (mid == start || mid == start + count) mid = start + count / 2;
+            }
+            // (All centroids equal: just halve the range.)
+            int left = build(start, mid - start);
+            int right = build(mid, start + count - mid);
+            nodes[index].left = left;
+            nodes[index].right = right;
+            return index;
+        }
+    };
+}
+
+void TriangleBVH::build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    nodes.clear();
+    tris.clear();
+    int triCount = (int)(indices.size() / 3);
+    if (triCount == 0) return;
+
+    std::vector<BuildTri> buildTris(triCount);
+    std::vector<uint32_t> order(triCount);
+    for (int i = 0; i < triCount; i++) {
+        BuildTri& t = buildTris[i];
+        for (int k = 0; k < 3; k++) t.box.grow(positions[indices[i * 3 + k]]);
+        t.centroid = (t.box.min + t.box.max) * 0.5f;
+        order[i] = i;
+    }
+    Builder builder{ buildTris, order, {} };
+    builder.nodes.reserve(triCount * 2);
+    builder.build(0, triCount);
+
+    // Triangles in leaf order, so a leaf is a contiguous range.
+    tris.resize(triCount);
+    for (int i = 0; i < triCount; i++) {
+        const glm::vec3& a = positions[indices[order[i] * 3 + 0]];
+        const glm::vec3& b = positions[indices[order[i] * 3 + 1]];
+        const glm::vec3& c = positions[indices[order[i] * 3 + 2]];
+        tris[i] = { a, b - a, c - a };
+    }
+
+    // Collapse to 4-wide: keep opening the largest inner child until a node has four.
+    const std::vector<BinaryNode>& bin = builder.nodes;
+    nodes.reserve(bin.size() / 2 + 1);
+    struct Collapser {
+        const std::vector<BinaryNode>& bin;
+        std::vector<Node>& out;
+        int collapse(int b) {
+            int kids[4];
+            int numKids = 0;
+            if (bin[b].left < 0) kids[numKids++] = b; // whole tree is one leaf
+            else {
+                kids[numKids++] = bin[b].left;
+                kids[numKids++] = bin[b].right;
+            }
+            while (numKids < 4) {
+                int best = -1;
+                float bestArea = -1.0f;
+                for (int i = 0; i < numKids; i++) {
+                    if (bin[kids[i]].left >= 0 && bin[kids[i]].box.area() > bestArea) {
+                        bestArea = bin[kids[i]].box.area();
+                        best = i;
+                    }
+                }
+                if (best < 0) break;
+                int open = kids[best];
+                kids[best] = bin[open].left;
+                kids[numKids++] = bin[open].right;
+            }
+
+            int index = (int)out.size();
+            out.push_back(Node());
+            Node n;
+            for (int i = 0; i < 4; i++) {
+                if (i >= numKids) {
+                    n.minX[i] = n.minY[i] = n.minZ[i] = FLT_MAX;
+                    n.maxX[i] = n.maxY[i] = n.maxZ[i] = -FLT_MAX;
+                    n.child[i] = 0;
+                    n.count[i] = -1;
+                    continue;
+                }
+                const BinaryNode& k = bin[kids[i]];
+                n.minX[i] = k.box.min.x; n.minY[i] = k.box.min.y; n.minZ[i] = k.box.min.z;
+                n.maxX[i] = k.box.max.x; n.maxY[i] = k.box.max.y; n.maxZ[i] = k.box.max.z;
+                if (k.left < 0) {
+                    n.child[i] = k.start;
+                    n.count[i] = k.count;
+                }
+                else {
+                    n.child[i] = collapse(kids[i]);
+                    n.count[i] = 0;
+                }
+            }
+            out[index] = n;
+            return index;
+        }
+    };
+    Collapser{ bin, nodes }.collapse(0);
+}
+
+bool TriangleBVH::intersectTri(int i, const glm::vec3& origin, const glm::vec3& dir, float tMax, float& t) const {
+    // Moller-Trumbore, two-sided.
+    const Tri& tri = tris[i];
+    glm::vec3 p = glm::cross(dir, tri.e2);
+    float det = glm::dot(tri.e1, p);
+    if (fabsf(det) < 1e-12f) return false;
+    float invDet = 1.0f / det;
+    glm::vec3 s = origin - tri.v0;
+    float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(s, tri.e1);
+    float v = glm::dot(dir, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = glm::dot(tri.e2, q) * invDet;
+    return t >= 0.0f && t <= tMax;
+}
+
+bool TriangleBVH::raycast(const glm::vec3& origin, const glm::vec3& dir, float tMax, Hit& hit) const {
+    if (nodes.empty()) return false;
+    glm::vec3 invDir = 1.0f / dir; // +-inf on axis-parallel rays is fine for the slab test
+    float best = tMax;
+    int bestTri = -1;
+
+#if SIMD_SSE2
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 ix = _mm_set1_ps(invDir.x), iy = _mm_set1_ps(invDir.y), iz = _mm_set1_ps(invDir.z);
+#endif
+
+    int stack[kMaxStack];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const Node& n = nodes[stack[--sp]];
+        alignas(16) float tnear[4];
+        int mask = 0;
+#if SIMD_SSE2
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minX), ox), ix);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxX), ox), ix);
+        __m128 tmin = _mm_min_ps(t0, t1), tmax = _mm_max_ps(t0, t1);
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minY), oy), iy);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxY), oy), iy);
+        tmin = _mm_max_ps(tmin, _mm_min_ps(t0, t1));
+        tmax = _mm_min_ps(tmax, _mm_max_ps(t0, t1));
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minZ), oz), iz);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxZ), oz), iz);
+        tmin = _mm_max_ps(_mm_max_ps(tmin, _mm_min_ps(t0, t1)), _mm_setzero_ps());
+        tmax = _mm_min_ps(_mm_min_ps(tmax, _mm_max_ps(t0, t1)), _mm_set1_ps(best));
+        mask = _mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+        _mm_store_ps(tnear, tmin);
+#else
+        for (int i = 0; i < 4; i++) {
+            float ax = (n.minX[i] - origin.x) * invDir.x, bx = (n.maxX[i] - origin.x) * invDir.x;
+            float ay = (n.minY[i] - origin.y) * invDir.y, by = (n.maxY[i] - origin.y) * invDir.y;
+            float az = (n.minZ[i] - origin.z) * invDir.z, bz = (n.maxZ[i] - origin.z) * invDir.z;
+            float lo = std::max(std::max(std::min(ax, bx), std::min(ay, by)), std::max(std::min(az, bz), 0.0f));
+            float hi = std::min(std::min(std::max(ax, bx), std::max(ay, by)), std::min(std::max(az, bz), best));
+            tnear[i] = lo;
+            if (lo <= hi) mask |= 1 << i;
+        }
+#endif
+        // Leaves are tested right away; inner children are pushed far to near
+        // so the nearest is popped first and tightens 'best' early.
+        int inner[4];
+        int numInner = 0;
+        for (int i = 0; i < 4; i++) {
+            if (!(mask & (1 << i)) || n.count[i] < 0) continue;
+            if (n.count[i] > 0) {
+                for (int k = n.child[i]; k < n.child[i] + n.count[i]; k++) {
+                    float t;
+                    if (intersectTri(k, origin, dir, best, t)) {
+                        best = t;
+                        bestTri = k;
+                    }
+                }
+            }
+            else {
+                inner[numInner++] = i;
+            }
+        }
+        std::sort(inner, inner + numInner, [&](int a, int b) { return tnear[a] > tnear[b]; });
+        for (int i = 0; i < numInner && sp < kMaxStack; i++) stack[sp++] = n.child[inner[i]];
+    }
+
+    if (bestTri < 0) return false;
+    hit.t = best;
+    hit.triangle = bestTri;
+    return true;
+}
+
+glm::vec3 TriangleBVH::triangleNormal(int triangle) const {
+    const Tri& t = tris[triangle];
+    return glm::normalize(glm::cross(t.e1, t.e2));
+}
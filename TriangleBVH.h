@@ -0,0 +1,52 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over a mesh's triangles, in the mesh's local space.
+// Built once at load with a binned SAH split into a binary tree, which is then
+// collapsed into 4-wide nodes so a traversal step tests four child boxes with
+// one SSE slab test. Leaves hold up to kLeafSize triangles.
+class TriangleBVH {
+public:
+    static constexpr int kLeafSize = 4;
+
+    struct Hit {
+        float t;        // along the ray, in units of dir (0..1 for segments)
+        int triangle;
+    };
+
+    void build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+    bool empty() const { return nodes.empty(); }
+
+    // Closest hit of origin + t * dir for t in [0, tMax].
+    bool raycast(const glm::vec3& origin, const glm::vec3& dir, float tMax, Hit& hit) const;
+    // Closest hit on the segment a -> b (hit.t in [0, 1]).
+    bool segment(const glm::vec3& a, const glm::vec3& b, Hit& hit) const { return raycast(a, b - a, 1.0f, hit); }
+
+    glm::vec3 triangleNormal(int triangle) const;
+    int triangleCount() const { return (int)tris.size(); }
+    int nodeCount() const { return (int)nodes.size(); }
+
+private:
+    // Four children per node, stored SoA so the slab test loads each axis as one vector.
+    struct alignas(16) Node {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int32_t child[4];   // node index, or first triangle of a leaf
+        int32_t count[4];   // 0 = inner node, > 0 = leaf triangle count, -1 = empty slot
+    };
+    // Precomputed for Moller-Trumbore.
+    struct Tri {
+        glm::vec3 v0, e1, e2;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Tri> tris;  // in leaf order
+
+    bool intersectTri(int i, const glm::vec3& origin, const glm::vec3& dir, float tMax, float& t) const;
+};
+
+#endif
@@ -0,0 +1,311 @@
+#include "World.h"
+#include "common.h"
+#include "logic.h"
+#include "TriangleBVH.h"
+#include "Terrain.h"
+#include "Arena.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace {
+    constexpr float kCellSize = 4.0f;
+    constexpr int kMaxCellsPerSide = 256;
+
+    // Cubes that can be hit, binned by x/z. A cube is a sphere of radius
+    // scale, same as the projectile test, and goes into every cell it overlaps,
+    // so a hit always lies in a cell the ray walks through.
+    struct CubeGrid {
+        float minX = 0.0f, minZ = 0.0f, invCell = 1.0f;
+        int dimX = 0, dimZ = 0;
+        std::vector<int> cellStart;
+        std::vector<int> items;       // cube indices by cell
+        std::vector<uint32_t> stamp;  // per cube, last packet that listed it
+        uint32_t stampValue = 0;
+
+        void build() {
+            int n = (int)cubes.size();
+            if (stamp.size() < (size_t)n) stamp.resize(n, 0);
+            float maxX = -FLT_MAX, maxZ = -FLT_MAX;
+            minX = minZ = FLT_MAX;
+            for (auto& c : cubes) {
+                minX = std::min(minX, c.pos.x - c.scale);
+                maxX = std::max(maxX, c.pos.x + c.scale);
+                minZ = std::min(minZ, c.pos.z - c.scale);
+                maxZ = std::max(maxZ, c.pos.z + c.scale);
+            }
+            if (n == 0) {
+                dimX = dimZ = 0;
+                return;
+            }
+            float cell = std::max(kCellSize, std::max(maxX - minX, maxZ - minZ) / (kMaxCellsPerSide - 1));
+            invCell = 1.0f / cell;
+            dimX = (int)((maxX - minX) * invCell) + 1;
+            dimZ = (int)((maxZ - minZ) * invCell) + 1;
+            cellStart.assign(dimX * dimZ + 1, 0);
+
+            // Two passes: count, then scatter with the counts turned into offsets.
+            for (int pass = 0; pass < 2; pass++) {
+                for (int i = 0; i < n; i++) {
+                    const CubeInstance& c = cubes[i];
+                    if (!c.chases || c.timeAlive >= 0) continue;
+                    int x0 = cellX(c.pos.x - c.scale), x1 = cellX(c.pos.x + c.scale);
+                    int z0 = cellZ(c.pos.z - c.scale), z1 = cellZ(c.pos.z + c.scale);
+                    for (int z = z0; z <= z1; z++)
+                        for (int x = x0; x <= x1; x++) {
+                            if (pass == 0) cellStart[z * dimX + x]++;
+                            else items[--cellStart[z * dimX + x]] = i;
+                        }
+                }
+                if (pass == 0) {
+                    for (size_t c = 1; c < cellStart.size(); c++) cellStart[c] += cellStart[c - 1];
+                    items.resize(cellStart.back());
+                }
+            }
+        }
+        int cellX(float x) const { return std::clamp((int)((x - minX) * invCell), 0, dimX - 1); }
+        int cellZ(float z) const { return std::clamp((int)((z - minZ) * invCell), 0, dimZ - 1); }
+
+        // 2D DDA state for one ray through the grid.
+        struct Walker {
+            int x, z, stepX, stepZ;
+            float tx, tz, dtx, dtz;
+            float tEnter, tEnd;   // entry distance of the current cell, end of the ray
+            bool active;
+        };
+
+        Walker start(const glm::vec3& o, const glm::vec3& d, float tMax) const {
+            Walker w;
+            w.active = false;
+            if (dimX == 0) return w;
+            // Clip the ray to the grid rectangle.
+            float cell = 1.0f / invCell;
+            float t0 = 0.0f, t1 = tMax;
+            if (!clip(o.x, d.x, minX, minX + dimX * cell, t0, t1) || !clip(o.z, d.z, minZ, minZ + dimZ * cell, t0, t1)) return w;
+            w.x = cellX(o.x + d.x * t0);
+            w.z = cellZ(o.z + d.z * t0);
+            w.stepX = d.x > 0.0f ? 1 : -1;
+            w.stepZ = d.z > 0.0f ? 1 : -1;
+            w.tx = d.x != 0.0f ? (minX + (w.x + (w.stepX > 0 ? 1 : 0)) * cell - o.x) / d.x : FLT_MAX;
+            w.tz = d.z != 0.0f ? (minZ + (w.z + (w.stepZ > 0 ? 1 : 0)) * cell - o.z) / d.z : FLT_MAX;
+            w.dtx = d.x != 0.0f ? cell / fabsf(d.x) : FLT_MAX;
+            w.dtz = d.z != 0.0f ? cell / fabsf(d.z) : FLT_MAX;
+            w.tEnter = t0;
+            w.tEnd = t1;
+            w.active = true;
+            return w;
+        }
+
+        // Appends the cubes of the walker's current cell not yet listed for
+        // this packet, then steps to the next cell.
+        void step(Walker& w, std::vector<int>& out) {
+            int c = w.z * dimX + w.x;
+            for (int k = cellStart[c]; k < cellStart[c + 1]; k++) {
+                int i = items[k];
+                if (stamp[i] == stampValue) continue;
+                stamp[i] = stampValue;
+                out.push_back(i);
+            }
+            if (w.tx < w.tz) {
+                w.tEnter = w.tx;
+                w.x += w.stepX;
+                w.tx += w.dtx;
+            }
+            else {
+                w.tEnter = w.tz;
+                w.z += w.stepZ;
+                w.tz += w.dtz;
+            }
+            if (w.tEnter > w.tEnd || w.x < 0 || w.z < 0 || w.x >= dimX || w.z >= dimZ) w.active = false;
+        }
+
+        static bool clip(float o, float d, float lo, float hi, float& t0, float& t1) {
+            if (d == 0.0f) return o >= lo && o <= hi;
+            float a = (lo - o) / d, b = (hi - o) / d;
+            if (a > b) std::swap(a, b);
+            t0 = std::max(t0, a);
+            t1 = std::min(t1, b);
+            return t0 <= t1;
+        }
+    };
+
+    CubeGrid grid;
+    std::vector<int> candidates;
+
+    // Nearest sphere hit for up to four rays at once, over candidates[first..].
+    // best/bestIdx are updated in place.
+    void packetVsCubes(const World::Ray* rays, int n, size_t first, float* best, int* bestIdx) {
+#if SIMD_SSE2
+        alignas(16) float ox[4], oy[4], oz[4], dx[4], dy[4], dz[4];
+        for (int k = 0; k < 4; k++) {
+            const World::Ray& r = rays[k < n ? k : 0];
+            ox[k] = r.origin.x; oy[k] = r.origin.y; oz[k] = r.origin.z;
+            dx[k] = r.dir.x; dy[k] = r.dir.y; dz[k] = r.dir.z;
+        }
+        __m128 vox = _mm_load_ps(ox), voy = _mm_load_ps(oy), voz = _mm_load_ps(oz);
+        __m128 vdx = _mm_load_ps(dx), vdy = _mm_load_ps(dy), vdz = _mm_load_ps(dz);
+        __m128 vbest = _mm_loadu_ps(best);
+        __m128i vidx = _mm_loadu_si128((const __m128i*)bestIdx);
+        const __m128 zero = _mm_setzero_ps();
+        for (size_t j = first; j < candidates.size(); j++) {
+            int i = candidates[j];
+            const CubeInstance& c = cubes[i];
+            // |o + t d - c|^2 = r^2 with |d| = 1: t = b -+ sqrt(b^2 - cc)
+            __m128 lx = _mm_sub_ps(_mm_set1_ps(c.pos.x), vox);
+            __m128 ly = _mm_sub_ps(_mm_set1_ps(c.pos.y), voy);
+            __m128 lz = _mm_sub_ps(_mm_set1_ps(c.pos.z), voz);
+            __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, vdx), _mm_mul_ps(ly, vdy)), _mm_mul_ps(lz, vdz));
+            __m128 cc = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)),
+                _mm_set1_ps(c.scale * c.scale));
+            __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), cc);
+            __m128 s = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+            __m128 t = _mm_max_ps(_mm_sub_ps(b, s), zero); // origin inside the sphere hits at 0
+            __m128 hit = _mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmplt_ps(t, vbest));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(_mm_add_ps(b, s), zero)); // sphere not behind the origin
+            vbest = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, vbest));
+            __m128i h = _mm_castps_si128(hit);
+            vidx = _mm_or_si128(_mm_and_si128(h, _mm_set1_epi32(i)), _mm_andnot_si128(h, vidx));
+        }
+        _mm_storeu_ps(best, vbest);
+        _mm_storeu_si128((__m128i*)bestIdx, vidx);
+#else
+        for (size_t j = first; j < candidates.size(); j++) {
+            int i = candidates[j];
+            const CubeInstance& c = cubes[i];
+            for (int k = 0; k < n; k++) {
+                glm::vec3 l = c.pos - rays[k].origin;
+                float b = glm::dot(l, rays[k].dir);
+                float disc = b * b - (glm::dot(l, l) - c.scale * c.scale);
+                if (disc < 0.0f) continue;
+                float s = sqrtf(disc);
+                float t = std::max(b - s, 0.0f);
+                if (b + s >= 0.0f && t < best[k]) {
+                    best[k] = t;
+                    bestIdx[k] = i;
+                }
+            }
+        }
+#endif
+    }
+
+    bool rayVsBox(const glm::vec3& o, const glm::vec3& d, const glm::vec3& lo, const glm::vec3& hi, float tMax, float& t) {
+        float t0 = 0.0f, t1 = tMax;
+        for (int a = 0; a < 3; a++) {
+            float inv = 1.0f / d[a];
+            float ta = (lo[a] - o[a]) * inv, tb = (hi[a] - o[a]) * inv;
+            if (ta > tb) std::swap(ta, tb);
+            t0 = std::max(t0, ta);
+            t1 = std::min(t1, tb);
+            if (t0 > t1) return false;
+        }
+        t = t0;
+        return true;
+    }
+}
+
+namespace World {
+    void raycastBatch(const Ray* rays, int count, RayHit* hits) {
+        PROFILE_SCOPE("Raycast batch");
+        grid.build();
+
+        // Emersons rotate, so their inverse transforms are computed once per batch.
+        glm::mat4* emersonInv = frameArena().allocArray<glm::mat4>(emersons.size());
+        for (size_t i = 0; i < emersons.size(); i++) emersonInv[i] = glm::inverse(emersonTransform(emersons[i]));
+
+        for (int base = 0; base < count; base += 4) {
+            int n = std::min(4, count - base);
+            const Ray* packet = rays + base;
+            float best[4] = { -1.0f, -1.0f, -1.0f, -1.0f }; // unused lanes never hit
+            int bestIdx[4] = { -1, -1, -1, -1 };
+            HitType type[4] = { HIT_NONE, HIT_NONE, HIT_NONE, HIT_NONE };
+
+            // 1. Ground first: it caps how far the grid walk has to go.
+            for (int k = 0; k < n; k++) {
+                const Ray& r = packet[k];
+                best[k] = r.maxDist;
+                float t;
+                if (terrain().raycast(r.origin, r.dir, r.maxDist, t)) {
+                    best[k] = t;
+                    type[k] = HIT_GROUND;
+                }
+            }
+
+            // 2. Cubes: the four rays walk the grid in lockstep, one cell each
+            // per round. New candidates are tested against the whole packet,
+            // and a ray stops once its next cell starts past its closest hit.
+            candidates.clear();
+            grid.stampValue++;
+            CubeGrid::Walker walkers[4];
+            bool any = false;
+            for (int k = 0; k < n; k++) {
+                walkers[k] = grid.start(packet[k].origin, packet[k].dir, best[k]);
+                any |= walkers[k].active;
+            }
+            float before[4] = { best[0], best[1], best[2], best[3] };
+            while (any) {
+                size_t first = candidates.size();
+                for (int k = 0; k < n; k++) {
+                    if (walkers[k].active) grid.step(walkers[k], candidates);
+                }
+                if (candidates.size() > first) packetVsCubes(packet, n, first, best, bestIdx);
+                any = false;
+                for (int k = 0; k < n; k++) {
+                    if (walkers[k].tEnter > best[k]) walkers[k].active = false;
+                    any |= walkers[k].active;
+                }
+            }
+            for (int k = 0; k < n; k++) {
+                if (best[k] < before[k]) type[k] = HIT_CUBE;
+            }
+
+            // 3. Emersons and pillars per ray, through their mesh BVHs.
+            for (int k = 0; k < n; k++) {
+                const Ray& r = packet[k];
+                for (size_t i = 0; i < emersons.size(); i++) {
+                    glm::vec3 lo = glm::vec3(emersonInv[i] * glm::vec4(r.origin, 1.0f));
+                    glm::vec3 ld = glm::mat3(emersonInv[i]) * r.dir; // rigid, so t stays in world units
+                    float t;
+                    bool hit;
+                    if (emersonBVH && !emersonBVH->empty()) {
+                        TriangleBVH::Hit h;
+                        hit = emersonBVH->raycast(lo, ld, best[k], h);
+                        t = h.t;
+                    }
+                    else hit = rayVsBox(lo, ld, emersonMinBounds, emersonMaxBounds, best[k], t);
+                    if (hit && t < best[k]) {
+                        best[k] = t;
+                        bestIdx[k] = (int)i;
+                        type[k] = HIT_EMERSON;
+                    }
+                }
+                for (size_t i = 0; i < pillars.size(); i++) {
+                    glm::vec3 lo = r.origin - pillars[i].pos;
+                    float t;
+                    bool hit;
+                    if (pillarBVH && !pillarBVH->empty()) {
+                        TriangleBVH::Hit h;
+                        hit = pillarBVH->raycast(lo, r.dir, best[k], h);
+                        t = h.t;
+                    }
+                    else hit = rayVsBox(lo, r.dir, pillarMinBounds, pillarMaxBounds, best[k], t);
+                    if (hit && t < best[k]) {
+                        best[k] = t;
+                        bestIdx[k] = (int)i;
+                        type[k] = HIT_PILLAR;
+                    }
+                }
+            }
+
+            for (int k = 0; k < n; k++) {
+                RayHit& h = hits[base + k];
+                h.type = type[k];
+                h.index = type[k] == HIT_GROUND ? -1 : bestIdx[k];
+                h.t = type[k] == HIT_NONE ? packet[k].maxDist : best[k];
+                h.point = packet[k].origin + packet[k].dir * h.t;
+            }
+        }
+    }
+}
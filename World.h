@@ -0,0 +1,40 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <glm/glm.hpp>
+
+// Instant ray queries against the current world state (cubes, emersons,
+// pillars, ground), for hitscan weapons and line-of-sight checks.
+namespace World {
+    enum HitType { HIT_NONE, HIT_GROUND, HIT_CUBE, HIT_EMERSON, HIT_PILLAR };
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 dir;      // unit length
+        float maxDist;
+    };
+
+    struct RayHit {
+        HitType type;
+        int index;          // into cubes / emersons / pillars
+        float t;            // distance along the ray
+        glm::vec3 point;
+    };
+
+    // First hit of every ray: hits[i] belongs to rays[i].
+    // Cubes are binned into an x/z grid once per call and walked with a 2D DDA.
+    // Rays go through in packets of four that walk the grid in lockstep; each
+    // new cube is tested against the whole packet with SSE, so coherent rays
+    // (a shotgun blast, a fan of LOS checks) share the broadphase work, and a
+    // ray drops out once its closest hit is nearer than its next cell.
+    // Emersons and pillars use their model BVHs.
+    void raycastBatch(const Ray* rays, int count, RayHit* hits);
+
+    inline RayHit raycast(const Ray& ray) {
+        RayHit hit;
+        raycastBatch(&ray, 1, &hit);
+        return hit;
+    }
+}
+
+#endif
@@ -0,0 +1,379 @@
+#include "WorldPartition.h"
+#include "logic.h"
+#include "Terrain.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace {
+    constexpr int kCellCount = WorldPartition::kCells * WorldPartition::kCells;
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 4 + 2 * 5 + 4;
+    constexpr size_t kPillarSize = 15, kEmersonSize = 16, kCubeSize = 17;
+
+    struct Writer {
+        std::vector<uint8_t>& out;
+        template <typename T> void put(T v) {
+            size_t at = out.size();
+            out.resize(at + sizeof(T));
+            memcpy(out.data() + at, &v, sizeof(T));
+        }
+        void putVec3(const glm::vec3& v) { put(v.x); put(v.y); put(v.z); }
+    };
+
+    struct Reader {
+        const std::vector<uint8_t>& in;
+        size_t at = 0;
+        template <typename T> T get() {
+            T v;
+            memcpy(&v, in.data() + at, sizeof(T));
+            at += sizeof(T);
+            return v;
+        }
+        glm::vec3 getVec3() { float x = get<float>(), y = get<float>(); return glm::vec3(x, y, get<float>()); }
+    };
+
+    uint8_t toByte(float c) { return (uint8_t)std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f); }
+
+    emers makeEmerson(const glm::vec3& pos, float health) {
+        emers e;
+        e.pos = pos;
+        e.vel = glm::vec3(0.0f);
+        e.height = 3.0f;
+        e.health = health;
+        return e;
+    }
+}
+
+WorldPartition& worldPartition() {
+    static WorldPartition partition;
+    return partition;
+}
+
+WorldPartition::WorldPartition() {
+    worker = std::thread(&WorldPartition::run, this);
+}
+
+WorldPartition::~WorldPartition() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_all();
+    worker.join(); // drains queued saves first
+}
+
+int WorldPartition::cellOf(const glm::vec3& pos) {
+    // Anything past the edge belongs to the edge cell.
+    int x = std::clamp((int)floorf((pos.x - kOrigin) / kCellSize), 0, kCells - 1);
+    int z = std::clamp((int)floorf((pos.z - kOrigin) / kCellSize), 0, kCells - 1);
+    return z * kCells + x;
+}
+
+float WorldPartition::distanceToCell(const glm::vec3& pos, int cell) {
+    glm::vec2 min(kOrigin + (cell % kCells) * kCellSize, kOrigin + (cell / kCells) * kCellSize);
+    glm::vec2 p(pos.x, pos.z);
+    glm::vec2 d = glm::max(glm::max(min - p, p - (min + kCellSize)), glm::vec2(0.0f));
+    return glm::length(d);
+}
+
+std::string WorldPartition::cellPath(int cell) const {
+    return dir + "/cell_" + std::to_string(cell % kCells) + "_" + std::to_string(cell / kCells) + ".bin";
+}
+
+std::vector<uint8_t> WorldPartition::encode(const CellData& data) {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(kHeaderSize + data.pillars.size() * kPillarSize + data.emersons.size() * kEmersonSize + data.cubes.size() * kCubeSize);
+    Writer w{ bytes };
+    w.put('W'); w.put('C'); w.put('E'); w.put('L');
+    w.put(kVersion);
+    w.put((uint16_t)(data.cell % kCells));
+    w.put((uint16_t)(data.cell / kCells));
+    w.put((uint16_t)data.pillars.size());
+    w.put((uint16_t)data.emersons.size());
+    w.put((uint32_t)data.cubes.size());
+    for (const pillar& p : data.pillars) {
+        w.putVec3(p.pos);
+        w.put(toByte(p.color.r)); w.put(toByte(p.color.g)); w.put(toByte(p.color.b));
+    }
+    for (const emers& e : data.emersons) {
+        w.putVec3(e.pos);
+        w.put(e.health);
+    }
+    for (const CubeRecord& c : data.cubes) {
+        w.putVec3(c.pos);
+        w.put(c.health);
+        w.put((uint8_t)(c.chases ? 1 : 0));
+    }
+    return bytes;
+}
+
+bool WorldPartition::decode(const std::vector<uint8_t>& bytes, CellData& data) {
+    if (bytes.size() < kHeaderSize || memcmp(bytes.data(), "WCEL", 4) != 0) return false;
+    Reader r{ bytes, 4 };
+    if (r.get<uint16_t>() != kVersion) return false;
+    int x = r.get<uint16_t>(), z = r.get<uint16_t>();
+    if (z * kCells + x != data.cell) return false;
+    size_t pillarCount = r.get<uint16_t>(), emersonCount = r.get<uint16_t>(), cubeCount = r.get<uint32_t>();
+    if (bytes.size() != kHeaderSize + pillarCount * kPillarSize + emersonCount * kEmersonSize + cubeCount * kCubeSize) return false;
+
+    data.pillars.resize(pillarCount);
+    for (pillar& p : data.pillars) {
+        p.pos = r.getVec3();
+        float red = r.get<uint8_t>() / 255.0f, green = r.get<uint8_t>() / 255.0f;
+        p.color = glm::vec3(red, green, r.get<uint8_t>() / 255.0f);
+    }
+    data.emersons.resize(emersonCount);
+    for (emers& e : data.emersons) {
+        glm::vec3 pos = r.getVec3();
+        e = makeEmerson(pos, r.get<float>());
+    }
+    data.cubes.resize(cubeCount);
+    for (CubeRecord& c : data.cubes) {
+        c.pos = r.getVec3();
+        c.health = r.get<float>();
+        c.chases = r.get<uint8_t>() & 1;
+    }
+    return true;
+}
+
+// The content initGame used to hardcode (four pillars round the arena, one
+// emerson), plus more of both scattered over the rest of the map.
+std::vector<WorldPartition::CellData> WorldPartition::defaultWorld() {
+    std::vector<CellData> cells(kCellCount);
+    for (int i = 0; i < kCellCount; i++) cells[i].cell = i;
+    auto addPillar = [&](float x, float z) {
+        pillar p;
+        p.pos = glm::vec3(x, terrain().heightAt(x, z) - groundy, z); // base on the ground
+        p.color = glm::vec3(0.8f, 0.2f, 0.2f);
+        cells[cellOf(p.pos)].pillars.push_back(p);
+    };
+    auto addEmerson = [&](float x, float y, float z) {
+        emers e = makeEmerson(glm::vec3(x, y, z), 1000.0f);
+        cells[cellOf(e.pos)].emersons.push_back(e);
+    };
+
+    const float corners[4][2] = { { 30.0f, 30.0f }, { -30.0f, 30.0f }, { 30.0f, -30.0f }, { -30.0f, -30.0f } };
+    for (auto& c : corners) addPillar(c[0], c[1]);
+    addEmerson(12.0f, 3.0f, 0.0f);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(kOrigin + 8.0f, -kOrigin - 8.0f);
+    for (int placed = 0; placed < 40;) {
+        float x = coord(rng), z = coord(rng);
+        if (x * x + z * z < 45.0f * 45.0f) continue; // keep the arena as it was
+        addPillar(x, z);
+        placed++;
+    }
+    for (int placed = 0; placed < 8;) {
+        float x = coord(rng), z = coord(rng);
+        if (x * x + z * z < 50.0f * 50.0f) continue;
+        addEmerson(x, terrain().heightAt(x, z) + 4.0f, z);
+        placed++;
+    }
+    return cells;
+}
+
+void WorldPartition::writeDefaultWorld() {
+    std::filesystem::create_directories(dir);
+    for (const CellData& cell : defaultWorld()) {
+        std::vector<uint8_t> bytes = encode(cell);
+        std::ofstream out(cellPath(cell.cell), std::ios::binary);
+        out.write((const char*)bytes.data(), bytes.size());
+    }
+    std::cout << "World: wrote default world to " << dir << std::endl;
+}
+
+void WorldPartition::init(const std::string& directory, const glm::vec3& pos) {
+    PROFILE_SCOPE("World init");
+    dir = directory;
+    if (dir.empty()) {
+        for (CellData& data : defaultWorld()) {
+            if (distanceToCell(pos, data.cell) < kLoadRadius) integrate(data);
+        }
+        return;
+    }
+    std::error_code ec;
+    bool any = false;
+    for (int i = 0; i < kCellCount && !any; i++) any = std::filesystem::exists(cellPath(i), ec);
+    if (!any) writeDefaultWorld();
+
+    // The first cells load right here: the game can't start without them.
+    for (int i = 0; i < kCellCount; i++) {
+        if (state[i] != CELL_UNLOADED || distanceToCell(pos, i) >= kLoadRadius) continue;
+        CellData data;
+        data.cell = i;
+        std::ifstream in(cellPath(i), std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!bytes.empty() && !decode(bytes, data)) std::cout << "World: bad cell file " << cellPath(i) << std::endl;
+        integrate(data);
+    }
+}
+
+bool WorldPartition::integrate(CellData& data) {
+    for (pillar p : data.pillars) {
+        p.id = nextEntityId();
+        pillars.push_back(p);
+    }
+    for (emers e : data.emersons) {
+        e.id = nextEntityId();
+        emersons.push_back(e);
+    }
+    for (const CubeRecord& c : data.cubes) createCollider(c.pos, c.chases, c.health);
+    state[data.cell] = CELL_LOADED;
+    loads++;
+    return !data.pillars.empty();
+}
+
+// Moves everything standing in the given cells out of the live arrays and
+// queues the cells to be written.
+bool WorldPartition::evict(const std::vector<int>& cells) {
+    std::vector<CellData> out(cells.size());
+    int slot[kCellCount];
+    std::fill(slot, slot + kCellCount, -1);
+    for (size_t i = 0; i < cells.size(); i++) {
+        out[i].cell = cells[i];
+        slot[cells[i]] = (int)i;
+    }
+    bool pillarsChanged = false;
+    std::erase_if(pillars, [&](const pillar& p) {
+        int s = slot[cellOf(p.pos)];
+        if (s < 0) return false;
+        out[s].pillars.push_back(p);
+        pillarsChanged = true;
+        return true;
+    });
+    std::erase_if(emersons, [&](const emers& e) {
+        int s = slot[cellOf(e.pos)];
+        if (s < 0) return false;
+        out[s].emersons.push_back(e);
+        return true;
+    });
+    std::erase_if(cubes, [&](const CubeInstance& c) {
+        int s = slot[cellOf(c.pos)];
+        if (s < 0) return false;
+        if (c.timeAlive < 0) out[s].cubes.push_back({ c.pos, c.health, c.chases }); // dying cubes just go
+        return true;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (CellData& data : out) {
+            jobs.push_back({ true, data.cell, encode(data) });
+            state[data.cell] = CELL_UNLOADED;
+            unloads++;
+        }
+    }
+    cv.notify_one();
+    return pillarsChanged;
+}
+
+bool WorldPartition::update(const glm::vec3& pos) {
+    if (dir.empty()) return false;
+    PROFILE_SCOPE("World streaming");
+    std::vector<int> far;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < kCellCount; i++) {
+            float d = distanceToCell(pos, i);
+            if (state[i] == CELL_UNLOADED && d < kLoadRadius) {
+                state[i] = CELL_LOADING;
+                jobs.push_back({ false, i, {} });
+                queued = true;
+            }
+            else if (state[i] == CELL_LOADED && d > kUnloadRadius) {
+                far.push_back(i);
+            }
+        }
+    }
+    if (queued) cv.notify_one();
+
+    bool pillarsChanged = false;
+    if (!far.empty()) pillarsChanged |= evict(far);
+
+    std::vector<CellData> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(finished);
+    }
+    for (CellData& data : done) pillarsChanged |= integrate(data);
+    return pillarsChanged;
+}
+
+void WorldPartition::flush() {
+    if (dir.empty()) return;
+    std::vector<int> resident;
+    for (int i = 0; i < kCellCount; i++) if (state[i] == CELL_LOADED) resident.push_back(i);
+    if (!resident.empty()) evict(resident);
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return jobs.empty() && busy == 0; });
+}
+
+WorldPartition::Stats WorldPartition::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s{};
+    for (int i = 0; i < kCellCount; i++) {
+        if (state[i] == CELL_LOADED) s.loaded++;
+        else if (state[i] == CELL_LOADING) s.pending++;
+    }
+    s.loads = loads;
+    s.unloads = unloads;
+    s.lastLoadMs = lastLoadMs;
+    return s;
+}
+
+void WorldPartition::run() {
+    PROFILE_THREAD("World streaming");
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return quit || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            busy++;
+        }
+        // Jobs run in order, so a cell unloaded and quickly reloaded is read
+        // back only after its save has landed.
+        std::string path = cellPath(job.cell);
+        if (job.save) {
+            PROFILE_SCOPE("Save cell");
+            // Write aside and rename, so a crash mid-write never leaves a torn cell.
+            std::string tmp = path + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary);
+                out.write((const char*)job.bytes.data(), job.bytes.size());
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmp, path, ec);
+            if (ec) std::cout << "World: failed to save " << path << ": " << ec.message() << std::endl;
+            std::lock_guard<std::mutex> lock(mutex);
+            busy--;
+        }
+        else {
+            PROFILE_SCOPE("Load cell");
+            uint64_t start = profilerNowNs();
+            CellData data;
+            data.cell = job.cell;
+            std::ifstream in(path, std::ios::binary);
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            // A missing cell is just empty; a damaged one is reported and skipped.
+            if (!bytes.empty() && !decode(bytes, data)) {
+                std::cout << "World: bad cell file " << path << std::endl;
+                data = CellData();
+                data.cell = job.cell;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(std::move(data));
+            lastLoadMs = (profilerNowNs() - start) / 1e6f;
+            busy--;
+        }
+        cv.notify_all();
+    }
+}
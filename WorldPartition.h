@@ -0,0 +1,107 @@
+#ifndef WORLD_PARTITION_H
+#define WORLD_PARTITION_H
+
+#include "common.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Splits the world's pillars, emersons and cubes into fixed-size cells on the
+// x/z plane, each stored in its own file (world/cell_<x>_<z>.bin). Only
+// cells near the player are resident. A worker thread reads and writes the
+// files; the main thread only moves already-decoded entities in and out of
+// the live arrays, so crossing into new cells never waits on the disk.
+// Cells load inside kLoadRadius and unload past kUnloadRadius; the gap keeps a
+// player walking along a border from thrashing a cell in and out.
+//
+// Cell file, little-endian:
+//   char magic[4] "WCEL", u16 version, u16 cellX, u16 cellZ,
+//   u16 pillars, u16 emersons, u32 cubes, then the records:
+//   pillar  f32 x, y, z, u8 r, g, b                        15 bytes
+//   emerson f32 x, y, z, f32 health                         16 bytes
+//   cube    f32 x, y, z, f32 health, u8 flags (1 = chases)  17 bytes
+class WorldPartition {
+public:
+    static constexpr int kCells = 8;              // per side
+    static constexpr float kCellSize = 32.0f;
+    static constexpr float kOrigin = -128.0f;     // world x/z of the grid corner (matches the terrain)
+    static constexpr float kLoadRadius = 64.0f;
+    static constexpr float kUnloadRadius = 96.0f;
+
+    struct Stats {
+        int loaded;
+        int pending;          // loads queued or in flight
+        int loads, unloads;   // since start
+        float lastLoadMs;     // worker time to read and decode the last cell
+    };
+
+    WorldPartition();
+    ~WorldPartition();
+    WorldPartition(const WorldPartition&) = delete;
+    WorldPartition& operator=(const WorldPartition&) = delete;
+
+    // Points the partition at a directory, writing the default world there if
+    // it has no cells yet, and loads the cells around pos before returning.
+    // An empty dir builds the default world in memory and loads the cells
+    // around pos for good: the benchmark's fixed, disk-independent world.
+    void init(const std::string& dir, const glm::vec3& pos);
+    // Once per tick: queues loads and unloads around pos and moves finished
+    // loads into the live arrays. Returns true if the set of pillars changed.
+    bool update(const glm::vec3& pos);
+    // Writes every resident cell back and waits for the worker to finish.
+    void flush();
+
+    Stats stats() const;
+
+private:
+    enum CellState : uint8_t { CELL_UNLOADED, CELL_LOADING, CELL_LOADED };
+
+    struct CubeRecord {
+        glm::vec3 pos;
+        float health;
+        bool chases;
+    };
+    struct CellData {
+        int cell;
+        std::vector<pillar> pillars;
+        std::vector<emers> emersons;
+        std::vector<CubeRecord> cubes;
+    };
+    struct Job {
+        bool save;
+        int cell;
+        std::vector<uint8_t> bytes;   // save: the encoded cell
+    };
+
+    static int cellOf(const glm::vec3& pos);
+    static float distanceToCell(const glm::vec3& pos, int cell);
+    std::string cellPath(int cell) const;
+    static std::vector<uint8_t> encode(const CellData& data);
+    static bool decode(const std::vector<uint8_t>& bytes, CellData& data);
+    bool integrate(CellData& data);
+    bool evict(const std::vector<int>& cells);
+    static std::vector<CellData> defaultWorld();
+    void writeDefaultWorld();
+    void run();
+
+    std::string dir;
+    CellState state[kCells * kCells] = {};
+    int loads = 0, unloads = 0;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::vector<CellData> finished;
+    int busy = 0;             // jobs taken by the worker and not yet done
+    float lastLoadMs = 0.0f;
+    bool quit = false;
+};
+
+WorldPartition& worldPartition();
+
+#endif
@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstdint>
 #include <vector>
 
 struct CubeInstance {
@@ -20,6 +21,7 @@ struct CubeInstance {
     bool chases;
     float health;
     float height;
+    uint32_t id;        // stable across erases, keys the broadphase proxy
 };
 struct projectile {
     glm::vec3 pos;
@@ -36,6 +38,12 @@ struct SplashParticle {
     float life;
     glm::vec3 color;
 };
+// Brief point light where a splash went off.
+struct SplashFlash {
+    glm::vec3 pos;
+    glm::vec3 color;
+    float life;
+};
 struct unbreakable {
     glm::vec3 pos;
     glm::vec3 color;
@@ -60,10 +68,12 @@ struct emers {
     glm::vec3 vel;
     float height;
     float health;
+    uint32_t id;        // from nextEntityId, keys the broadphase proxy
 };
 struct pillar {
     glm::vec3 pos;
     glm::vec3 color;
+    uint32_t id;        // from nextEntityId, keys the broadphase proxy
 };
 // --- Global Data Declarations (The "Announcements") ---
 // initialized in global.cpp
@@ -74,6 +84,7 @@ extern std::vector<unbreakable> unbreakables;
 extern std::vector<pillar> pillars;
 extern std::vector<emers> emersons; 
 extern std::vector<SplashParticle> splashParticles;
+extern std::vector<SplashFlash> splashFlashes;
 
 extern int height;
 extern int width;
@@ -88,6 +99,12 @@ extern int totalKills;
 extern int colliders;
 extern float lastX;
 extern float lastY;
+extern bool showProfiler;
+extern bool exportTraceRequested;
+extern bool exportFrameTimesRequested;
+extern bool captureCommandsRequested;
+extern bool hitscanWeapon;
+extern bool deferredShading;
 extern double lcxpos, lcypos;
 
 extern float enemySpeed;
@@ -106,6 +123,7 @@ extern float sensitivity;
 //gl
 extern GLFWwindow* window;
 extern GLFWmonitor* primaryMonitor;
+extern unsigned int windowFramebuffer; // what the frame presents from: 0, or the offscreen target
 extern unsigned int unbreakVAO, unbreakVBO;
 
 //temp
@@ -115,5 +133,16 @@ extern float tempZ;
 
 //world
 extern float groundy;
+extern float worldTime;
+extern glm::vec3 emersonMinBounds;
+extern glm::vec3 emersonMaxBounds;
+extern glm::vec3 pillarMinBounds;
+extern glm::vec3 pillarMaxBounds;
+class TriangleBVH;
+extern const TriangleBVH* emersonBVH; // null until the model is loaded: hits fall back to the box
+extern const TriangleBVH* pillarBVH;
+
+//stats
+extern int frameDrawCalls;
 
 #endif
\ No newline at end of file
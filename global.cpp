@@ -8,6 +8,7 @@ std::vector<unbreakable> unbreakables;
 std::vector<pillar> pillars;
 std::vector<emers> emersons;
 std::vector<SplashParticle> splashParticles;
+std::vector<SplashFlash> splashFlashes;
 
 // window
 int height = 800;
@@ -18,6 +19,12 @@ float deltaTime = 0.0f;
 bool firstMouse = true;
 bool isPaused = true;
 float lastX, lastY;
+bool showProfiler = false;
+bool exportTraceRequested = false;
+bool exportFrameTimesRequested = false;
+bool captureCommandsRequested = false;
+bool hitscanWeapon = false;
+bool deferredShading = false;
 double lcxpos, lcypos;
 int totalClicks, totalHits, totalKills;
 int colliders = 3;
@@ -38,6 +45,7 @@ float sensitivity = 0.1f;
 // OpenGL handles
 GLFWwindow* window = nullptr;
 GLFWmonitor* primaryMonitor;
+unsigned int windowFramebuffer = 0;
 unsigned int unbreakVAO = 0;
 unsigned int unbreakVBO = 0;
 
@@ -47,4 +55,14 @@ float tempRotationY = 0.0f;
 float tempRotationZ = 0.0f;
 
 //world
-float groundy = -1.0f;
\ No newline at end of file
+float groundy = -1.0f;
+float worldTime = 0.0f;
+glm::vec3 emersonMinBounds = glm::vec3(0.0f);
+glm::vec3 emersonMaxBounds = glm::vec3(0.0f);
+glm::vec3 pillarMinBounds = glm::vec3(-1.0f);
+glm::vec3 pillarMaxBounds = glm::vec3(1.0f);
+const TriangleBVH* emersonBVH = nullptr;
+const TriangleBVH* pillarBVH = nullptr;
+
+//stats
+int frameDrawCalls = 0;
\ No newline at end of file
@@ -3,9 +3,25 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
+#include "Profiler.h"
+#include "Arena.h"
+#include "FlowField.h"
+#include "NeighborGrid.h"
+#include "TriangleBVH.h"
+#include "World.h"
+#include "SweepAndPrune.h"
+#include "Terrain.h"
+#include "WorldPartition.h"
+#include "InputQueue.h"
+#include <algorithm>
+#include <cfloat>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) { glViewport(0, 0, width, height); }
 
+// Left button as of this tick, from the queued button events. firePressed
+// catches a click released again before the tick saw it held.
+static bool fireHeld = false, firePressed = false;
+
 void processInput(GLFWwindow* window) {
     player& p = players[0];
     static bool pPressed = false;
@@ -25,6 +41,40 @@ void processInput(GLFWwindow* window) {
     else {
         pPressed = false;
     }
+    // F3 toggles the profiler window, F9 dumps a Chrome trace, F10 the frame-time histogram,
+    // F11 the frame's scene commands
+    static bool f3Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS) {
+        if (!f3Pressed) showProfiler = !showProfiler;
+        f3Pressed = true;
+    }
+    else {
+        f3Pressed = false;
+    }
+    static bool f9Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS) {
+        if (!f9Pressed) exportTraceRequested = true;
+        f9Pressed = true;
+    }
+    else {
+        f9Pressed = false;
+    }
+    static bool f10Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS) {
+        if (!f10Pressed) exportFrameTimesRequested = true;
+        f10Pressed = true;
+    }
+    else {
+        f10Pressed = false;
+    }
+    static bool f11Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS) {
+        if (!f11Pressed) captureCommandsRequested = true;
+        f11Pressed = true;
+    }
+    else {
+        f11Pressed = false;
+    }
     if (!isPaused) {
         float speed = mySpeed * deltaTime;
         // 1. Calculate a "flat" forward vector so looking up doesn't make you fly
@@ -36,7 +86,7 @@ void processInput(GLFWwindow* window) {
         if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) p.pos += speed * right;
         if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) p.pos -= speed * p.up;
         if (glfwGetKey(window, GLFW_KEY_PERIOD) == GLFW_PRESS) resetPlayer();
-        float groundLevel = -1.0f + players[0].height; // ground y + player height
+        float groundLevel = terrain().heightAt(p.pos.x, p.pos.z) + p.height; // where handleGravity rests the player
         if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && p.pos.y <= groundLevel + 0.01f) {
             p.vel.y = 7.0f; // Give an upward "kick"
         }
@@ -51,6 +101,27 @@ void processInput(GLFWwindow* window) {
             rPressed = false;
         }
 
+        static bool hPressed = false;
+        if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS) {
+            if (!hPressed) {
+                hitscanWeapon = !hitscanWeapon;
+                hPressed = true;
+            }
+        }
+        else {
+            hPressed = false;
+        }
+
+        static bool gPressed = false;
+        if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) {
+            if (!gPressed) {
+                deferredShading = !deferredShading;
+                gPressed = true;
+            }
+        }
+        else {
+            gPressed = false;
+        }
         static bool mPressed = false;
         if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
             if (!mPressed) {
@@ -61,7 +132,7 @@ void processInput(GLFWwindow* window) {
         else {
             mPressed = false;
         }
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+        if (fireHeld || firePressed) {
             float currentTime = (float)glfwGetTime();
             float cooldown = 0.05f;
             if (!ImGui::GetIO().WantCaptureMouse) {
@@ -84,27 +155,87 @@ void switchCamera() {
     usingSkyCamera = !usingSkyCamera;
 }
 
+// The GLFW callbacks only queue the event; the tick that owns it applies it.
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
-    if (isPaused) return;
-    player& p = players[0];
-    float xpos = (float)xposIn;
-    float ypos = (float)yposIn;
-    if (firstMouse) {
-        lastX = xpos;
-        lastY = ypos;
-        firstMouse = false;
-    }
+    InputEvent e = {};
+    e.type = InputEvent::CursorMove;
+    e.x = (float)xposIn;
+    e.y = (float)yposIn;
+    pushInputEvent(e);
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    InputEvent e = {};
+    e.type = InputEvent::MouseButton;
+    e.button = button;
+    e.action = action;
+    pushInputEvent(e);
+}
+
+// Turns the cursor's offset from (lastX, lastY) into yaw and pitch.
+static void turnToCursor(player& p, float xpos, float ypos) {
     float xoffset = (xpos - lastX) * sensitivity;
     float yoffset = (lastY - ypos) * sensitivity;
-    lastX = xpos;
-    lastY = ypos;
     p.yaw += xoffset;
     if (p.yaw > 360.0f) p.yaw -= 360.0f;
     if (p.yaw < 0.0f) p.yaw += 360.0f;
     p.pitch += yoffset;
     if (p.pitch > 89.0f) p.pitch = 89.0f;
     if (p.pitch < -89.0f) p.pitch = -89.0f;
+}
 
+uint64_t consumeInput(uint64_t tickNs) {
+    player& p = players[0];
+    InputQueue& queue = inputQueue();
+    uint64_t newestNs = 0;
+    firePressed = false;
+    for (uint32_t n = queue.size(); n > 0; n--) {
+        const InputEvent& e = queue.peek(0);
+        if (e.timeNs > tickNs) break; // arrived during this tick; the next one owns it
+        if (e.type == InputEvent::CursorMove) {
+            if (!isPaused) {
+                if (firstMouse) {
+                    lastX = e.x;
+                    lastY = e.y;
+                    firstMouse = false;
+                }
+                turnToCursor(p, e.x, e.y);
+                lastX = e.x;
+                lastY = e.y;
+                newestNs = e.timeNs;
+            }
+        }
+        else if (e.button == GLFW_MOUSE_BUTTON_LEFT) {
+            fireHeld = e.action == GLFW_PRESS;
+            firePressed |= fireHeld;
+        }
+        queue.pop();
+    }
+    // One trig evaluation per tick rather than per event.
+    if (newestNs) applyLook(p);
+    return newestNs;
+}
+
+glm::vec3 latchLook(const player& p, uint64_t& eventNs) {
+    eventNs = 0;
+    if (isPaused || firstMouse) return p.front;
+    const InputQueue& queue = inputQueue();
+    for (uint32_t i = queue.size(); i > 0; i--) {
+        const InputEvent& e = queue.peek(i - 1);
+        if (e.type != InputEvent::CursorMove) continue;
+        // The offsets telescope, so the newest position alone gives the
+        // sum of every move still queued.
+        player latched = p;
+        turnToCursor(latched, e.x, e.y);
+        applyLook(latched);
+        eventNs = e.timeNs;
+        return latched.front;
+    }
+    return p.front;
+}
+
+// Rebuilds the look direction from yaw/pitch.
+void applyLook(player& p) {
     glm::vec3 front;
     front.x = cos(glm::radians(p.yaw)) * cos(glm::radians(p.pitch));
     front.y = sin(glm::radians(p.pitch));
@@ -112,12 +243,19 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
     p.front = glm::normalize(front);
 }
 
+// Spawns chasers until there are colliders live ones.
+static void topUpColliders() {
+    int colliderCount = 0;
+    for (auto& c : cubes) if (c.timeAlive < 0) colliderCount++;
+    while (colliderCount < colliders) {
+        spawnEnemyAtRadius(15.0f, 30.0f);
+        colliderCount++;
+    }
+}
 void resetAll() {
     cubes.clear();
     resetPlayer();
-    for (int i = 0; i < colliders; i++) {
-        spawnEnemyAtRadius(15, 30);
-    }
+    topUpColliders();
 }
 void resetPlayer() {
     player& p = players[0];
@@ -132,13 +270,34 @@ void resetPlayer() {
     totalHits = 0;
     totalKills = 0;
     totalClicks = 0;
+    if (!window) return; // headless runs have no cursor to recenter
     glfwGetWindowSize(window, &width, &height);
     lastX = (float)width / 2.0f;
     lastY = (float)height / 2.0f;
+    inputQueue().clear(); // moves queued so far are relative to the old cursor position
     mouse_callback(window, lastX, lastY);
     glfwSetCursorPos(window, lastX, lastY);
 }
-void initGame() {
+// Pillar footprints block the chasers' flow field, grown by half a cube so
+// chasers path around them rather than clip the edge.
+static void refreshBlockers() {
+    std::vector<FlowField::Blocker> blockers;
+    for (auto& pill : pillars) {
+        FlowField::Blocker b;
+        b.min = glm::vec2(pill.pos.x + pillarMinBounds.x, pill.pos.z + pillarMinBounds.z) - 0.5f;
+        b.max = glm::vec2(pill.pos.x + pillarMaxBounds.x, pill.pos.z + pillarMaxBounds.z) + 0.5f;
+        blockers.push_back(b);
+    }
+    flowField().setBlockers(std::move(blockers));
+}
+void initGame(const std::string& worldDir) {
+    // Reserve past the peak seen in play so shoot/createSplash/spawning
+    // never regrow these mid-game (erase_if keeps the capacity).
+    cubes.reserve(1024);
+    projectiles.reserve(256);
+    splashParticles.reserve(4096);
+    splashFlashes.reserve(256);
+
     player playerone;
     playerone.pos = glm::vec3(-3.0f, 0.0f, 0.0f);
     playerone.front = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -151,29 +310,49 @@ void initGame() {
     players.push_back(playerone);
     cameraPos = playerone.pos;
 
-    glm::vec3 positions[] = {
-        glm::vec3(20.0f, 0.0f,  20.0f),
-        glm::vec3(-20.0f, 0.0f,  20.0f),
-        glm::vec3(20.0f, 0.0f, -20.0f),
-        glm::vec3(-20.0f, 0.0f, -20.0f)
-    };
-    for (int i = 0; i < 4; i++) {
-        pillar p;
-        p.pos = positions[i]*1.5f;
-        p.color = glm::vec3(0.8f, 0.2f, 0.2f);
-        pillars.push_back(p);
-    }
+    // Pillars, emersons and saved cubes come from the world's cells around
+    // the player. Unlike resetAll (the R key), start-up keeps the cubes just
+    // loaded and only adds chasers if there are too few.
+    worldPartition().init(worldDir, playerone.pos);
+    refreshBlockers();
 
-    emers emerson;
-    emerson.pos = glm::vec3(12.0f, 3.0f, 0.0f);
-    emerson.health = 1000.0f;
-    emerson.vel = glm::vec3(0.0f, 0.0f, 0.0f);
-    emerson.height = 3.0f;
-    emersons.push_back(emerson);
-
-    resetAll();
+    resetPlayer();
+    topUpColliders();
+}
+// Once per tick before updateWorld: streams cells in and out around the player.
+void streamWorld() {
+    if (worldPartition().update(players[0].pos)) refreshBlockers();
+}
+// Shotgun blast resolved instantly with one raycast batch, no projectiles.
+static void shootHitscan() {
+    const int pellets = 8;
+    const float dmg = 0.5f;
+    World::Ray rays[pellets];
+    glm::vec3 right = glm::normalize(glm::cross(cameraFront, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::vec3 up = glm::cross(right, cameraFront);
+    for (int i = 0; i < pellets; i++) {
+        float sx = ((rand() % 100) / 100.0f - 0.5f) * 0.08f;
+        float sy = ((rand() % 100) / 100.0f - 0.5f) * 0.08f;
+        rays[i].origin = cameraPos;
+        rays[i].dir = glm::normalize(cameraFront + right * sx + up * sy);
+        rays[i].maxDist = 75.0f; // same reach as a projectile
+    }
+    World::RayHit hits[pellets];
+    World::raycastBatch(rays, pellets, hits);
+    for (auto& h : hits) {
+        if (h.type == World::HIT_NONE) continue;
+        if (h.type == World::HIT_CUBE) cubes[h.index].health -= dmg;
+        else if (h.type == World::HIT_EMERSON) emersons[h.index].health -= dmg;
+        glm::vec3 color = h.type == World::HIT_GROUND || h.type == World::HIT_PILLAR ? glm::vec3(0.7f, 0.9f, 1.0f) : glm::vec3(0.7f, 0.3f, 0.0f);
+        createSplash(h.point, color);
+    }
 }
+
 void shoot() {
+    if (hitscanWeapon) {
+        shootHitscan();
+        return;
+    }
     projectile projectile;
     projectile.pos = cameraPos + (cameraFront * 1.0f);
     projectile.color = glm::vec3(1.0f, 1.0f, 1.0f);
@@ -190,8 +369,14 @@ void shoot() {
     projectiles.push_back(projectile);
 }
 
+uint32_t nextEntityId() {
+    static uint32_t nextId = 0;
+    return nextId++;
+}
 void createCollider(glm::vec3 pos, bool chases, float health) {
+    static uint32_t nextId = 0;
     CubeInstance cube;
+    cube.id = nextId++;
     cube.color = glm::vec3(0.0f, 0.5f, 0.3f);
     cube.pos = pos;
     cube.chases = chases;
@@ -227,6 +412,7 @@ void spawnEnemyAtRadius(float minRadius, float maxRadius) {
 }
 
 void createSplash(glm::vec3 pos, glm::vec3 color) {
+    splashFlashes.push_back({ pos, color, 1.0f });
     int particleCount = 20;
     for (int i = 0; i < particleCount; i++) {
         SplashParticle p;
@@ -253,38 +439,359 @@ void createSplash(glm::vec3 pos, glm::vec3 color) {
     }
 }
 
+glm::mat4 emersonTransform(const emers& e) {
+    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    modelMatrix = glm::translate(modelMatrix, e.pos);
+    modelMatrix = glm::rotate(modelMatrix, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    modelMatrix = glm::rotate(modelMatrix, worldTime * 2.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+    return modelMatrix;
+}
+
+glm::mat4 projectileTransform(const projectile& proj) {
+    glm::mat4 bulletModel = glm::mat4(1.0f);
+    bulletModel = glm::translate(bulletModel, proj.pos);
+    // 1. Rotation: Face the direction of travel
+    if (glm::length(proj.vel) > 0.1f) {
+        float angle = atan2(proj.vel.x, proj.vel.z);
+        bulletModel = glm::rotate(bulletModel, angle, glm::vec3(0, 1, 0));
+    }
+    // 2. Rotation: Apply any spinning from proj.rotation
+    bulletModel = glm::rotate(bulletModel, proj.rotation.x, glm::vec3(1, 0, 0));
+    bulletModel = glm::rotate(bulletModel, proj.rotation.y, glm::vec3(0, 1, 0));
+    bulletModel = glm::rotate(bulletModel, proj.rotation.z, glm::vec3(0, 0, 1));
+    // 3. Scale: Adjust based on your .obj size
+    return glm::scale(bulletModel, glm::vec3(0.1f));
+}
+
+static void updateProjectiles() {
+    PROFILE_SCOPE("Projectiles");
+    // Emerson's hitbox transform only changes once per frame, so invert it once
+    // here instead of once per projectile.
+    glm::mat4* emersonInv = frameArena().allocArray<glm::mat4>(emersons.size());
+    for (size_t i = 0; i < emersons.size(); i++) {
+        emersonInv[i] = glm::inverse(emersonTransform(emersons[i]));
+    }
+
+    for (auto& proj : projectiles) {
+        glm::vec3 movement = proj.vel * deltaTime;
+        glm::vec3 prevPos = proj.pos;
+        proj.pos += movement;
+        proj.rotation += proj.rotVel * deltaTime;
+        proj.distanceTraveled += glm::length(movement);
+        if (proj.distanceTraveled >= 75.0f) {
+            createSplash(proj.pos, glm::vec3(rand(), rand(), rand()));
+            proj.dmg = 0; // Mark for deletion
+            continue;     // Skip collision check since it's dead
+        }
+        for (auto& enemy : cubes) {
+            if (enemy.chases) {
+                float dist = glm::distance(proj.pos, enemy.pos);
+                if (dist < (enemy.scale)) {
+                    enemy.health -= proj.dmg;
+                    proj.dmg = 0; // Mark projectile for deletion
+                    createSplash(proj.pos, glm::vec3(0.7f, 0.3f, 0.0f));
+                }
+            }
+        }
+        for (size_t i = 0; i < emersons.size(); i++) {
+            auto& emerson = emersons[i];
+            if (proj.dmg <= 0) break;
+            glm::vec3 localProjPos = glm::vec3(emersonInv[i] * glm::vec4(proj.pos, 1.0f));
+            bool hit;
+            glm::vec3 hitPos = proj.pos;
+            if (emersonBVH && !emersonBVH->empty()) {
+                // Exact: this tick's path against the mesh triangles, so fast
+                // shots can't skip through and near misses past the box don't count.
+                glm::vec3 localPrev = glm::vec3(emersonInv[i] * glm::vec4(prevPos, 1.0f));
+                TriangleBVH::Hit h;
+                hit = emersonBVH->segment(localPrev, localProjPos, h);
+                if (hit) hitPos = prevPos + movement * h.t;
+            }
+            else {
+                hit = (localProjPos.x >= emersonMinBounds.x && localProjPos.x <= emersonMaxBounds.x) &&
+                    (localProjPos.y >= emersonMinBounds.y && localProjPos.y <= emersonMaxBounds.y) &&
+                    (localProjPos.z >= emersonMinBounds.z && localProjPos.z <= emersonMaxBounds.z);
+            }
+
+            if (hit) {
+                emerson.health -= proj.dmg;
+                proj.dmg = 0;
+                createSplash(hitPos, glm::vec3(0.7f, 0.3f, 0.0f));
+            }
+        }
+    }
+    std::erase_if(projectiles, [](const projectile& p) { return p.dmg <= 0; });
+}
+
+static void updateParticles() {
+    PROFILE_SCOPE("Particles");
+    for (auto& p : splashParticles) {
+        p.vel.y += gravity * deltaTime; // Apply gravity to splash too
+        p.pos += p.vel * deltaTime;
+        p.life -= deltaTime * 1.5f;    // Particles last about 0.6 seconds
+        float ground = terrain().heightAt(p.pos.x, p.pos.z);
+        if (p.pos.y < ground) {
+            // Snap to surface so it doesn't get stuck underground
+            p.pos.y = ground;
+
+            // Invert Y velocity and reduce it (0.4f = 40% energy kept)
+            p.vel.y = -p.vel.y * 0.4f;
+
+            // Friction: Slow down horizontal movement on impact
+            p.vel.x *= 0.8f;
+            p.vel.z *= 0.8f;
+        }
+    }
+    // Remove dead particles
+    std::erase_if(splashParticles, [](const SplashParticle& p) {
+        return p.life <= 0.0f;
+        });
+    for (auto& f : splashFlashes) f.life -= deltaTime * 5.0f; // a fifth of a second
+    std::erase_if(splashFlashes, [](const SplashFlash& f) { return f.life <= 0.0f; });
+}
+
+// Cleanup and Spawning
+static void updateChasers() {
+    PROFILE_SCOPE("Chasers");
+    player& p = players[0];
+    FlowField& field = flowField();
+    field.update();
+    field.setGoal(p.pos);
+
+    float step = enemySpeed * deltaTime;
+    for (auto& c : cubes) {
+        // Only live chasers move; dying cubes (timeAlive >= 0) just shrink in place.
+        if (!c.chases || c.timeAlive >= 0) continue;
+        glm::vec2 toPlayer(p.pos.x - c.pos.x, p.pos.z - c.pos.z);
+        float dist = glm::length(toPlayer);
+        if (dist < 1.5f) continue;
+        glm::vec2 dir = field.direction(c.pos);
+        // No field yet, off the grid, or already in the player's cell: go straight.
+        if (dir == glm::vec2(0.0f)) dir = toPlayer / dist;
+        c.pos.x += dir.x * step;
+        c.pos.z += dir.y * step;
+    }
+}
+
+// Pushes overlapping live cubes apart. Neighbours come from a cell grid, so
+// this stays linear in the number of cubes instead of testing every pair.
+static void updateSeparation() {
+    PROFILE_SCOPE("Separation");
+    static NeighborGrid grid;
+    LinearArena& arena = frameArena();
+    float* xs = arena.allocArray<float>(cubes.size());
+    float* zs = arena.allocArray<float>(cubes.size());
+    int* ids = arena.allocArray<int>(cubes.size());
+    int n = 0;
+    for (int i = 0; i < (int)cubes.size(); i++) {
+        if (cubes[i].timeAlive >= 0) continue; // dying cubes don't push
+        xs[n] = cubes[i].pos.x;
+        zs[n] = cubes[i].pos.z;
+        ids[n++] = i;
+    }
+    if (n < 2) return;
+
+    const float radius = 1.1f; // cube width plus a small gap
+    grid.build(xs, zs, n, radius);
+    float* pushX = arena.allocArray<float>(n);
+    float* pushZ = arena.allocArray<float>(n);
+    grid.separation(pushX, pushZ);
+
+    // Each side of a pair resolves half the overlap, eased in over a few ticks.
+    float k = 0.5f * std::min(1.0f, 10.0f * deltaTime);
+    for (int j = 0; j < n; j++) {
+        CubeInstance& c = cubes[ids[j]];
+        c.pos.x += pushX[j] * k;
+        c.pos.z += pushZ[j] * k;
+    }
+}
+
+// Broadphase keys: the kind and the entity's id (0 for the player). Ids
+// survive the erases that shift vector indices, so a body that did not move
+// keeps its proxy and its contacts.
+enum ContactKind : uint64_t { KIND_CUBE, KIND_PLAYER, KIND_EMERSON, KIND_PILLAR };
+static uint64_t contactKey(ContactKind kind, uint32_t id) { return ((uint64_t)kind << 32) | id; }
+
+// Id -> current index in items, for the keys handed back by the broadphase.
+// Ids only grow, so a table from the oldest live id up stays small.
+template <typename T>
+static int* indexById(const std::vector<T>& items, uint32_t& minId) {
+    minId = UINT32_MAX;
+    uint32_t maxId = 0;
+    for (auto& it : items) {
+        minId = std::min(minId, it.id);
+        maxId = std::max(maxId, it.id);
+    }
+    if (items.empty()) return nullptr;
+    int* index = frameArena().allocArray<int>(maxId - minId + 1);
+    for (int i = 0; i < (int)items.size(); i++) index[items[i].id - minId] = i;
+    return index;
+}
+
+// Moves box a out of box b along whichever of x / z overlaps least. Ground
+// contact is left to gravity.
+static void pushOut(glm::vec3& pos, const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax) {
+    float dx = std::min(aMax.x, bMax.x) - std::max(aMin.x, bMin.x);
+    float dz = std::min(aMax.z, bMax.z) - std::max(aMin.z, bMin.z);
+    if (dx <= 0.0f || dz <= 0.0f) return;
+    if (dx < dz) pos.x += (aMin.x + aMax.x < bMin.x + bMax.x) ? -dx : dx;
+    else pos.z += (aMin.z + aMax.z < bMin.z + bMax.z) ? -dz : dz;
+}
+
+// Solid contacts between the player, live cubes, emersons and pillars. The
+// sweep-and-prune broadphase only hands back pairs whose boxes overlap and
+// whose layers care about each other, so this costs the real contacts, not
+// every entity against every other. Cube-vs-cube is left to updateSeparation.
+static void updateContacts() {
+    PROFILE_SCOPE("Contacts");
+    SweepAndPrune& sap = broadphase();
+    player& p = players[0];
+    const glm::vec3 playerHalf(0.4f, 0.0f, 0.4f);
+    glm::vec3 playerMin = p.pos - playerHalf - glm::vec3(0.0f, p.height, 0.0f);
+    glm::vec3 playerMax = p.pos + playerHalf + glm::vec3(0.0f, 0.1f, 0.0f);
+
+    sap.beginSync();
+    sap.sync(contactKey(KIND_PLAYER, 0), playerMin, playerMax, LAYER_PLAYER, LAYER_ENEMY | LAYER_EMERSON | LAYER_PILLAR);
+    for (auto& c : cubes) {
+        if (c.timeAlive >= 0) continue; // dying cubes are just an effect
+        glm::vec3 half(0.5f * c.scale);
+        sap.sync(contactKey(KIND_CUBE, c.id), c.pos - half, c.pos + half, LAYER_ENEMY, LAYER_PLAYER | LAYER_EMERSON | LAYER_PILLAR);
+    }
+    glm::vec3* emersonMin = frameArena().allocArray<glm::vec3>(emersons.size());
+    glm::vec3* emersonMax = frameArena().allocArray<glm::vec3>(emersons.size());
+    bool emersonLoaded = emersonMinBounds.x <= emersonMaxBounds.x; // empty box until the model loads
+    for (size_t i = 0; i < emersons.size() && emersonLoaded; i++) {
+        // World box around the spinning model box.
+        glm::mat4 m = emersonTransform(emersons[i]);
+        emersonMin[i] = glm::vec3(FLT_MAX);
+        emersonMax[i] = glm::vec3(-FLT_MAX);
+        for (int k = 0; k < 8; k++) {
+            glm::vec3 corner((k & 1) ? emersonMaxBounds.x : emersonMinBounds.x,
+                (k & 2) ? emersonMaxBounds.y : emersonMinBounds.y,
+                (k & 4) ? emersonMaxBounds.z : emersonMinBounds.z);
+            glm::vec3 w = glm::vec3(m * glm::vec4(corner, 1.0f));
+            emersonMin[i] = glm::min(emersonMin[i], w);
+            emersonMax[i] = glm::max(emersonMax[i], w);
+        }
+        sap.sync(contactKey(KIND_EMERSON, emersons[i].id), emersonMin[i], emersonMax[i], LAYER_EMERSON, LAYER_PLAYER | LAYER_ENEMY);
+    }
+    for (size_t i = 0; i < pillars.size(); i++) {
+        sap.sync(contactKey(KIND_PILLAR, pillars[i].id), pillars[i].pos + pillarMinBounds, pillars[i].pos + pillarMaxBounds, LAYER_PILLAR, LAYER_PLAYER | LAYER_ENEMY);
+    }
+    sap.endSync();
+    if (sap.pairs().empty()) return;
+
+    uint32_t minCube, minEmerson, minPillar;
+    int* cubeIndex = indexById(cubes, minCube);
+    int* emersonIndex = indexById(emersons, minEmerson);
+    int* pillarIndex = indexById(pillars, minPillar);
+
+    auto bounds = [&](uint64_t key, glm::vec3*& pos, glm::vec3& bMin, glm::vec3& bMax) {
+        uint32_t id = (uint32_t)key;
+        switch ((ContactKind)(key >> 32)) {
+        case KIND_CUBE: {
+            CubeInstance& c = cubes[cubeIndex[id - minCube]];
+            pos = &c.pos;
+            bMin = c.pos - glm::vec3(0.5f * c.scale);
+            bMax = c.pos + glm::vec3(0.5f * c.scale);
+            break;
+        }
+        case KIND_PLAYER:
+            pos = &p.pos;
+            bMin = p.pos - playerHalf - glm::vec3(0.0f, p.height, 0.0f);
+            bMax = p.pos + playerHalf + glm::vec3(0.0f, 0.1f, 0.0f);
+            break;
+        case KIND_EMERSON: {
+            int i = emersonIndex[id - minEmerson];
+            pos = nullptr;
+            bMin = emersonMin[i];
+            bMax = emersonMax[i];
+            break;
+        }
+        case KIND_PILLAR: {
+            int i = pillarIndex[id - minPillar];
+            pos = nullptr;
+            bMin = pillars[i].pos + pillarMinBounds;
+            bMax = pillars[i].pos + pillarMaxBounds;
+            break;
+        }
+        }
+    };
+
+    // Emersons and pillars don't move. The player shoves cubes aside rather
+    // than being blocked by them, so only the cube gets pushed there.
+    for (const SweepAndPrune::Pair& pair : sap.pairs()) {
+        uint64_t ka = sap.key(pair.a), kb = sap.key(pair.b);
+        if ((ContactKind)(ka >> 32) > (ContactKind)(kb >> 32)) std::swap(ka, kb);
+        glm::vec3 *posA, *posB, aMin, aMax, bMin, bMax;
+        bounds(ka, posA, aMin, aMax);
+        bounds(kb, posB, bMin, bMax);
+        // kinds are ordered cube < player < emerson < pillar, so a always moves
+        pushOut(*posA, aMin, aMax, bMin, bMax);
+    }
+}
+
+static void updateSpawning() {
+    PROFILE_SCOPE("Spawning");
+    std::erase_if(cubes, [](const CubeInstance& cube) {
+        return (cube.scale <= 0.0f && cube.timeAlive >= 0) || (cube.timeAlive < 0 && cube.health <= 0.0f);
+        });
+    topUpColliders();
+}
+
+// One simulation step of deltaTime. Needs no window or GL context, so the
+// benchmarks can drive it headless.
+void updateWorld() {
+    PROFILE_SCOPE("Simulation");
+    if (!isPaused) {
+        updateChasers();
+        updateSeparation();
+        handleGravity();
+        updateContacts();
+        updateProjectiles();
+    }
+    updateParticles();
+    updateSpawning();
+}
+
 void handleGravity() {
+    PROFILE_SCOPE("Gravity");
+    const Terrain& t = terrain();
     // 1. Apply constant Gravity to velocity
     for (auto& p : players) {
         p.vel.y += gravity * deltaTime;
         // 2. Apply vertical velocity to position
         p.pos.y += p.vel.y * deltaTime;
-        if (p.pos.y < groundy + p.height) {
-            p.pos.y = groundy + p.height;
+        float ground = t.heightAt(p.pos.x, p.pos.z);
+        if (p.pos.y < ground + p.height) {
+            p.pos.y = ground + p.height;
             p.vel.y = 0.0f;
         }
     }
     for (auto& c : cubes) {
         c.vel.y += gravity * deltaTime;
         c.pos.y += c.vel.y * deltaTime;
-        if (c.pos.y < groundy + c.height) {
-            c.pos.y = groundy + c.height;
+        float ground = t.heightAt(c.pos.x, c.pos.z);
+        if (c.pos.y < ground + c.height) {
+            c.pos.y = ground + c.height;
             c.vel.y = 0.0f;
         }
     }
     for (auto& c : emersons) {
         c.vel.y += gravity * deltaTime;
         c.pos.y += c.vel.y * deltaTime;
-        if (c.pos.y < groundy + c.height) {
-            c.pos.y = groundy + c.height;
+        float ground = t.heightAt(c.pos.x, c.pos.z);
+        if (c.pos.y < ground + c.height) {
+            c.pos.y = ground + c.height;
             c.vel.y = 0.0f;
         }
     }
     for (auto& c : projectiles) {
         c.vel.y += gravity * deltaTime;
         c.pos.y += c.vel.y * deltaTime;
-        if (c.pos.y < groundy) {
-            c.pos.y = groundy;
+        float ground = t.heightAt(c.pos.x, c.pos.z);
+        if (c.pos.y < ground) {
+            c.pos.y = ground;
             c.vel.y = 0.0f;
             c.dmg = 0;
             createSplash(c.pos, glm::vec3(0.7f, 0.9f, 1.0f));
@@ -1,11 +1,22 @@
 #ifndef LOGIC_H
 #define LOGIC_H
 #include "common.h"
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+// Applies the queued mouse events stamped up to tickNs: look and the fire
+// button. Returns the stamp of the newest cursor move applied, 0 if none.
+uint64_t consumeInput(uint64_t tickNs);
+// Late latch: the look direction from the newest queued cursor position,
+// including moves the next tick has yet to consume. Leaves p and the queue
+// untouched; eventNs gets that move's stamp, or 0 if nothing is queued.
+glm::vec3 latchLook(const player& p, uint64_t& eventNs);
 void processInput(GLFWwindow* window);
 void createCollider(glm::vec3, bool, float);
+// Stable id for an emerson or pillar entering the world; indices shift as cells unload.
+uint32_t nextEntityId();
 void switchCamera();
 void resetPlayer();
 void spawnEnemyAtRadius(float minRadius, float maxRadius);
@@ -13,6 +24,11 @@ void resetAll();
 void createSplash(glm::vec3 pos, glm::vec3 color);
 void createUnbreakable(glm::vec3 pos);
 void shoot();
-void initGame();
+void initGame(const std::string& worldDir);
+void streamWorld();
 void handleGravity();
+void updateWorld();
+void applyLook(player& p);
+glm::mat4 emersonTransform(const emers& e);
+glm::mat4 projectileTransform(const projectile& proj);
 #endif
\ No newline at end of file
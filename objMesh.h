@@ -1,5 +1,10 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <vector>
+#include <utility>
+#include "common.h"
+#include "CommandBuffer.h"
+#include "GLState.h"
 struct Vertex {
     glm::vec3 Position;
     glm::vec2 TexCoords;
@@ -11,14 +16,21 @@ public:
     std::vector<unsigned int> indices;
     unsigned int VAO;
 
-    objMesh(std::vector<Vertex> v, std::vector<unsigned int> i) : vertices(v), indices(i) {
-        setupMesh();
+    // upload = false keeps the data CPU-side only (headless runs have no GL context).
+    objMesh(std::vector<Vertex> v, std::vector<unsigned int> i, bool upload = true) : vertices(std::move(v)), indices(std::move(i)) {
+        VAO = VBO = EBO = 0;
+        if (upload) setupMesh();
     }
 
+    // The VAO is left bound, so drawing the mesh again binds nothing.
     void Draw() {
-        glBindVertexArray(VAO);
+        frameDrawCalls++;
+        glState().bindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    }
+    void Draw(CommandBuffer& cmds) const {
+        cmds.bindVertexArray(VAO);
+        cmds.drawElements(GL_TRIANGLES, (GLsizei)indices.size());
     }
 
 private:
@@ -28,11 +40,11 @@ private:
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
         // Vertex Positions
@@ -42,6 +54,6 @@ private:
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 
-        glBindVertexArray(0);
+        glState().bindVertexArray(0);
     }
 };
\ No newline at end of file
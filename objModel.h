@@ -8,6 +8,7 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "objMesh.h"
+#include "TriangleBVH.h"
 
 class objModel {
 public:
@@ -15,18 +16,28 @@ public:
     glm::vec3 minBounds = glm::vec3(std::numeric_limits<float>::max());
     glm::vec3 maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
 
-    objModel(const std::string& path) { loadModel(path); }
+    objModel(const std::string& path, bool upload = true) : upload(upload) { loadModel(path); }
 
     void Draw() {
         for (unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw();
     }
+    void Draw(CommandBuffer& cmds) const {
+        for (const objMesh& mesh : meshes) mesh.Draw(cmds);
+    }
 
     // Helper to get the total size of the model
     glm::vec3 getSize() { return maxBounds - minBounds; }
 
+    // Triangles of all meshes, built at load, for exact local-space ray/segment hits.
+    const TriangleBVH& getBVH() const { return bvh; }
+    // CPU-side mesh data, e.g. for the software rasterizer.
+    const std::vector<objMesh>& getMeshes() const { return meshes; }
+
 private:
     std::vector<objMesh> meshes;
+    bool upload;
+    TriangleBVH bvh;
 
     void loadModel(std::string path) {
         Assimp::Importer importer;
@@ -37,6 +48,15 @@ private:
             return;
         }
         processNode(scene->mRootNode, scene);
+
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        for (auto& mesh : meshes) {
+            uint32_t base = (uint32_t)positions.size();
+            for (auto& v : mesh.vertices) positions.push_back(v.Position);
+            for (unsigned int i : mesh.indices) indices.push_back(base + i);
+        }
+        bvh.build(positions, indices);
     }
 
     void processNode(aiNode* node, const aiScene* scene) {
@@ -52,6 +72,8 @@ private:
     objMesh processMesh(aiMesh* mesh, const aiScene* scene) {
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
             Vertex vertex;
@@ -74,6 +96,6 @@ private:
             for (unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
-        return objMesh(vertices, indices);
+        return objMesh(std::move(vertices), std::move(indices), upload);
     }
 };
\ No newline at end of file
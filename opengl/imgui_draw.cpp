@@ -802,6 +802,138 @@ void ImDrawList::PrimQuadUV(const ImVec2& a, const ImVec2& b, const ImVec2& c, c
 #define IM_FIXNORMAL2F_MAX_INVLEN2          100.0f // 500.0f (see #4053, #3366)
 #define IM_FIXNORMAL2F(VX,VY)               { float d2 = VX*VX + VY*VY; if (d2 > 0.000001f) { float inv_len2 = 1.0f / d2; if (inv_len2 > IM_FIXNORMAL2F_MAX_INVLEN2) inv_len2 = IM_FIXNORMAL2F_MAX_INVLEN2; VX *= inv_len2; VY *= inv_len2; } } (void)0
 
+// Tessellation helpers shared by AddPolyline() and AddConvexPolyFilled().
+// - With SSE they handle four segments or two points per iteration, with a scalar loop for the remainder.
+// - Both paths perform the same float operations in the same order as the macros above (_mm_rsqrt_ps lanes match _mm_rsqrt_ss),
+//   so the vertices they produce are identical to the scalar ones.
+
+// Normal of each segment i -> i+1, wrapping to point 0 after the last point.
+static void ImDrawList_ComputeSegmentNormals(const ImVec2* points, int points_count, int segment_count, ImVec2* out_normals)
+{
+    int i = 0;
+#ifdef IMGUI_ENABLE_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (; i + 4 < points_count && i + 4 <= segment_count; i += 4)
+    {
+        const float* p = &points[i].x;
+        const __m128 d01 = _mm_sub_ps(_mm_loadu_ps(p + 2), _mm_loadu_ps(p));       // dx0 dy0 dx1 dy1
+        const __m128 d23 = _mm_sub_ps(_mm_loadu_ps(p + 6), _mm_loadu_ps(p + 4));   // dx2 dy2 dx3 dy3
+        const __m128 dx = _mm_shuffle_ps(d01, d23, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 dy = _mm_shuffle_ps(d01, d23, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 nonzero = _mm_cmpgt_ps(d2, zero);
+        const __m128 inv_len = _mm_or_ps(_mm_and_ps(nonzero, _mm_rsqrt_ps(d2)), _mm_andnot_ps(nonzero, one));
+        const __m128 nx = _mm_mul_ps(dy, inv_len);
+        const __m128 ny = _mm_xor_ps(_mm_mul_ps(dx, inv_len), sign);
+        _mm_storeu_ps(&out_normals[i].x, _mm_unpacklo_ps(nx, ny));
+        _mm_storeu_ps(&out_normals[i + 2].x, _mm_unpackhi_ps(nx, ny));
+    }
+#endif
+    for (; i < segment_count; i++)
+    {
+        const int i2 = (i + 1) == points_count ? 0 : i + 1;
+        float dx = points[i2].x - points[i].x;
+        float dy = points[i2].y - points[i].y;
+        IM_NORMALIZE2F_OVER_ZERO(dx, dy);
+        out_normals[i].x = dy;
+        out_normals[i].y = -dx;
+    }
+}
+
+// Normal at each point: the average of the segment normals on either side, fixed up with IM_FIXNORMAL2F().
+// The first point of an open line has no segment before it and takes the normal of the first segment as-is.
+static void ImDrawList_ComputePointNormals(const ImVec2* seg_normals, int points_count, bool closed, ImVec2* out_normals)
+{
+    if (closed)
+    {
+        float dm_x = (seg_normals[points_count - 1].x + seg_normals[0].x) * 0.5f;
+        float dm_y = (seg_normals[points_count - 1].y + seg_normals[0].y) * 0.5f;
+        IM_FIXNORMAL2F(dm_x, dm_y);
+        out_normals[0].x = dm_x;
+        out_normals[0].y = dm_y;
+    }
+    else
+    {
+        out_normals[0] = seg_normals[0];
+    }
+    int i = 1;
+#ifdef IMGUI_ENABLE_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 min_d2 = _mm_set1_ps(0.000001f);
+    const __m128 max_invlen2 = _mm_set1_ps(IM_FIXNORMAL2F_MAX_INVLEN2);
+    for (; i + 2 <= points_count; i += 2)
+    {
+        const __m128 dm = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&seg_normals[i - 1].x), _mm_loadu_ps(&seg_normals[i].x)), half);
+        const __m128 sq = _mm_mul_ps(dm, dm);
+        const __m128 d2 = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1))); // x*x + y*y in both lanes of a point
+        const __m128 inv_len2 = _mm_min_ps(_mm_div_ps(one, d2), max_invlen2);
+        const __m128 fix = _mm_cmpgt_ps(d2, min_d2);
+        _mm_storeu_ps(&out_normals[i].x, _mm_mul_ps(dm, _mm_or_ps(_mm_and_ps(fix, inv_len2), _mm_andnot_ps(fix, one))));
+    }
+#endif
+    for (; i < points_count; i++)
+    {
+        float dm_x = (seg_normals[i - 1].x + seg_normals[i].x) * 0.5f;
+        float dm_y = (seg_normals[i - 1].y + seg_normals[i].y) * 0.5f;
+        IM_FIXNORMAL2F(dm_x, dm_y);
+        out_normals[i].x = dm_x;
+        out_normals[i].y = dm_y;
+    }
+}
+
+// Writes SLOTS vertices per point, at points[i] + normals[i] * scales[slot] with a per-slot uv and color.
+// A zero scale writes the point itself.
+template<int SLOTS>
+static void ImDrawList_WriteFringeVertices(ImDrawVert* vtx, const ImVec2* points, const ImVec2* normals, int points_count, const float* scales, const ImVec2* uvs, const ImU32* cols)
+{
+    int i = 0;
+#ifdef IMGUI_ENABLE_SSE
+    // Position and uv go out as one 16-byte store when the vertex layout allows it.
+    if (offsetof(ImDrawVert, uv) == offsetof(ImDrawVert, pos) + sizeof(ImVec2))
+    {
+        __m128 scale_v[SLOTS], uv_v[SLOTS];
+        for (int s = 0; s < SLOTS; s++)
+        {
+            scale_v[s] = _mm_set1_ps(scales[s]);
+            uv_v[s] = _mm_setr_ps(uvs[s].x, uvs[s].y, uvs[s].x, uvs[s].y);
+        }
+        for (; i + 2 <= points_count; i += 2, vtx += SLOTS * 2)
+        {
+            const __m128 p = _mm_loadu_ps(&points[i].x);
+            const __m128 n = _mm_loadu_ps(&normals[i].x);
+            for (int s = 0; s < SLOTS; s++)
+            {
+                const __m128 v = (scales[s] == 0.0f) ? p : _mm_add_ps(p, _mm_mul_ps(n, scale_v[s]));
+                _mm_storeu_ps(&vtx[s].pos.x, _mm_movelh_ps(v, uv_v[s]));          // point i
+                _mm_storeu_ps(&vtx[SLOTS + s].pos.x, _mm_movehl_ps(uv_v[s], v));  // point i + 1
+                vtx[s].col = cols[s];
+                vtx[SLOTS + s].col = cols[s];
+            }
+        }
+    }
+#endif
+    for (; i < points_count; i++, vtx += SLOTS)
+    {
+        for (int s = 0; s < SLOTS; s++)
+        {
+            if (scales[s] == 0.0f)
+            {
+                vtx[s].pos = points[i];
+            }
+            else
+            {
+                vtx[s].pos.x = points[i].x + normals[i].x * scales[s];
+                vtx[s].pos.y = points[i].y + normals[i].y * scales[s];
+            }
+            vtx[s].uv = uvs[s];
+            vtx[s].col = cols[s];
+        }
+    }
+}
+
 // TODO: Thickness anti-aliased lines cap are missing their AA fringe.
 // We avoid using the ImVec2 math operators here to reduce cost to a minimum for debug/non-inlined builds.
 void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32 col, ImDrawFlags flags, float thickness)
@@ -838,24 +970,20 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
         PrimReserve(idx_count, vtx_count);
 
         // Temporary buffer
-        // The first <points_count> items are normals at each line point, then after that there are either 2 or 4 temp points for each line point
-        _Data->TempBuffer.reserve_discard(points_count * ((use_texture || !thick_line) ? 3 : 5));
+        // The first <points_count> items are normals of each line segment, then the averaged normals at each line point
+        _Data->TempBuffer.reserve_discard(points_count * 2);
         ImVec2* temp_normals = _Data->TempBuffer.Data;
-        ImVec2* temp_points = temp_normals + points_count;
+        ImVec2* temp_point_normals = temp_normals + points_count;
 
         // Calculate normals (tangents) for each line segment
-        for (int i1 = 0; i1 < count; i1++)
-        {
-            const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1;
-            float dx = points[i2].x - points[i1].x;
-            float dy = points[i2].y - points[i1].y;
-            IM_NORMALIZE2F_OVER_ZERO(dx, dy);
-            temp_normals[i1].x = dy;
-            temp_normals[i1].y = -dx;
-        }
+        ImDrawList_ComputeSegmentNormals(points, points_count, count, temp_normals);
         if (!closed)
             temp_normals[points_count - 1] = temp_normals[points_count - 2];
 
+        // Average them at each point. The vertices for the line edges are those normals scaled out from the point.
+        // If line is not closed, the first point has no previous segment and uses the normal of the first one unchanged.
+        ImDrawList_ComputePointNormals(temp_normals, points_count, closed, temp_point_normals);
+
         // If we are drawing a one-pixel-wide line without a texture, or a textured line of any width, we only need 2 or 3 vertices per point
         if (use_texture || !thick_line)
         {
@@ -869,38 +997,12 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
             //   allow scaling geometry while preserving one-screen-pixel AA fringe).
             const float half_draw_size = use_texture ? ((thickness * 0.5f) + 1) : AA_SIZE;
 
-            // If line is not closed, the first and last points need to be generated differently as there are no normals to blend
-            if (!closed)
-            {
-                temp_points[0] = points[0] + temp_normals[0] * half_draw_size;
-                temp_points[1] = points[0] - temp_normals[0] * half_draw_size;
-                temp_points[(points_count-1)*2+0] = points[points_count-1] + temp_normals[points_count-1] * half_draw_size;
-                temp_points[(points_count-1)*2+1] = points[points_count-1] - temp_normals[points_count-1] * half_draw_size;
-            }
-
-            // Generate the indices to form a number of triangles for each line segment, and the vertices for the line edges
-            // This takes points n and n+1 and writes into n+1, with the first point in a closed line being generated from the final one (as n+1 wraps)
-            // FIXME-OPT: Merge the different loops, possibly remove the temporary buffer.
+            // Generate the indices to form a number of triangles for each line segment
+            // This takes points n and n+1, with the last segment of a closed line wrapping back to the first point
             unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
             for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
             {
-                const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1; // i2 is the second point of the line segment
                 const unsigned int idx2 = ((i1 + 1) == points_count) ? _VtxCurrentIdx : (idx1 + (use_texture ? 2 : 3)); // Vertex index for end of segment
-
-                // Average normals
-                float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
-                float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
-                IM_FIXNORMAL2F(dm_x, dm_y);
-                dm_x *= half_draw_size; // dm_x, dm_y are offset to the outer edge of the AA area
-                dm_y *= half_draw_size;
-
-                // Add temporary vertices for the outer edges
-                ImVec2* out_vtx = &temp_points[i2 * 2];
-                out_vtx[0].x = points[i2].x + dm_x;
-                out_vtx[0].y = points[i2].y + dm_y;
-                out_vtx[1].x = points[i2].x - dm_x;
-                out_vtx[1].y = points[i2].y - dm_y;
-
                 if (use_texture)
                 {
                     // Add indices for two triangles
@@ -917,7 +1019,6 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
                     _IdxWritePtr[9] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[10] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[11] = (ImDrawIdx)(idx2 + 1); // Left tri 2
                     _IdxWritePtr += 12;
                 }
-
                 idx1 = idx2;
             }
 
@@ -934,25 +1035,18 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
                     tex_uvs.z = tex_uvs.z + (tex_uvs_1.z - tex_uvs.z) * fractional_thickness;
                     tex_uvs.w = tex_uvs.w + (tex_uvs_1.w - tex_uvs.w) * fractional_thickness;
                 }*/
-                ImVec2 tex_uv0(tex_uvs.x, tex_uvs.y);
-                ImVec2 tex_uv1(tex_uvs.z, tex_uvs.w);
-                for (int i = 0; i < points_count; i++)
-                {
-                    _VtxWritePtr[0].pos = temp_points[i * 2 + 0]; _VtxWritePtr[0].uv = tex_uv0; _VtxWritePtr[0].col = col; // Left-side outer edge
-                    _VtxWritePtr[1].pos = temp_points[i * 2 + 1]; _VtxWritePtr[1].uv = tex_uv1; _VtxWritePtr[1].col = col; // Right-side outer edge
-                    _VtxWritePtr += 2;
-                }
+                const float scales[2] = { half_draw_size, -half_draw_size };                    // Left-side outer edge, right-side outer edge
+                const ImVec2 uvs[2] = { ImVec2(tex_uvs.x, tex_uvs.y), ImVec2(tex_uvs.z, tex_uvs.w) };
+                const ImU32 cols[2] = { col, col };
+                ImDrawList_WriteFringeVertices<2>(_VtxWritePtr, points, temp_point_normals, points_count, scales, uvs, cols);
             }
             else
             {
                 // If we're not using a texture, we need the center vertex as well
-                for (int i = 0; i < points_count; i++)
-                {
-                    _VtxWritePtr[0].pos = points[i];              _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col;       // Center of line
-                    _VtxWritePtr[1].pos = temp_points[i * 2 + 0]; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col_trans; // Left-side outer edge
-                    _VtxWritePtr[2].pos = temp_points[i * 2 + 1]; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col_trans; // Right-side outer edge
-                    _VtxWritePtr += 3;
-                }
+                const float scales[3] = { 0.0f, half_draw_size, -half_draw_size };              // Center of line, left-side outer edge, right-side outer edge
+                const ImVec2 uvs[3] = { opaque_uv, opaque_uv, opaque_uv };
+                const ImU32 cols[3] = { col, col_trans, col_trans };
+                ImDrawList_WriteFringeVertices<3>(_VtxWritePtr, points, temp_point_normals, points_count, scales, uvs, cols);
             }
         }
         else
@@ -960,49 +1054,13 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
             // [PATH 2] Non texture-based lines (thick): we need to draw the solid line core and thus require four vertices per point
             const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
 
-            // If line is not closed, the first and last points need to be generated differently as there are no normals to blend
-            if (!closed)
-            {
-                const int points_last = points_count - 1;
-                temp_points[0] = points[0] + temp_normals[0] * (half_inner_thickness + AA_SIZE);
-                temp_points[1] = points[0] + temp_normals[0] * (half_inner_thickness);
-                temp_points[2] = points[0] - temp_normals[0] * (half_inner_thickness);
-                temp_points[3] = points[0] - temp_normals[0] * (half_inner_thickness + AA_SIZE);
-                temp_points[points_last * 4 + 0] = points[points_last] + temp_normals[points_last] * (half_inner_thickness + AA_SIZE);
-                temp_points[points_last * 4 + 1] = points[points_last] + temp_normals[points_last] * (half_inner_thickness);
-                temp_points[points_last * 4 + 2] = points[points_last] - temp_normals[points_last] * (half_inner_thickness);
-                temp_points[points_last * 4 + 3] = points[points_last] - temp_normals[points_last] * (half_inner_thickness + AA_SIZE);
-            }
-
-            // Generate the indices to form a number of triangles for each line segment, and the vertices for the line edges
-            // This takes points n and n+1 and writes into n+1, with the first point in a closed line being generated from the final one (as n+1 wraps)
-            // FIXME-OPT: Merge the different loops, possibly remove the temporary buffer.
+            // Generate the indices to form a number of triangles for each line segment
+            // This takes points n and n+1, with the last segment of a closed line wrapping back to the first point
             unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
             for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
             {
-                const int i2 = (i1 + 1) == points_count ? 0 : (i1 + 1); // i2 is the second point of the line segment
                 const unsigned int idx2 = (i1 + 1) == points_count ? _VtxCurrentIdx : (idx1 + 4); // Vertex index for end of segment
 
-                // Average normals
-                float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
-                float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
-                IM_FIXNORMAL2F(dm_x, dm_y);
-                float dm_out_x = dm_x * (half_inner_thickness + AA_SIZE);
-                float dm_out_y = dm_y * (half_inner_thickness + AA_SIZE);
-                float dm_in_x = dm_x * half_inner_thickness;
-                float dm_in_y = dm_y * half_inner_thickness;
-
-                // Add temporary vertices
-                ImVec2* out_vtx = &temp_points[i2 * 4];
-                out_vtx[0].x = points[i2].x + dm_out_x;
-                out_vtx[0].y = points[i2].y + dm_out_y;
-                out_vtx[1].x = points[i2].x + dm_in_x;
-                out_vtx[1].y = points[i2].y + dm_in_y;
-                out_vtx[2].x = points[i2].x - dm_in_x;
-                out_vtx[2].y = points[i2].y - dm_in_y;
-                out_vtx[3].x = points[i2].x - dm_out_x;
-                out_vtx[3].y = points[i2].y - dm_out_y;
-
                 // Add indexes
                 _IdxWritePtr[0]  = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[1]  = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[2]  = (ImDrawIdx)(idx1 + 2);
                 _IdxWritePtr[3]  = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[4]  = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[5]  = (ImDrawIdx)(idx2 + 1);
@@ -1015,16 +1073,13 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
                 idx1 = idx2;
             }
 
-            // Add vertices
-            for (int i = 0; i < points_count; i++)
-            {
-                _VtxWritePtr[0].pos = temp_points[i * 4 + 0]; _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col_trans;
-                _VtxWritePtr[1].pos = temp_points[i * 4 + 1]; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col;
-                _VtxWritePtr[2].pos = temp_points[i * 4 + 2]; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col;
-                _VtxWritePtr[3].pos = temp_points[i * 4 + 3]; _VtxWritePtr[3].uv = opaque_uv; _VtxWritePtr[3].col = col_trans;
-                _VtxWritePtr += 4;
-            }
+            // Add vertices: outer AA edge, inner solid edge on both sides
+            const float scales[4] = { half_inner_thickness + AA_SIZE, half_inner_thickness, -half_inner_thickness, -(half_inner_thickness + AA_SIZE) };
+            const ImVec2 uvs[4] = { opaque_uv, opaque_uv, opaque_uv, opaque_uv };
+            const ImU32 cols[4] = { col_trans, col, col, col_trans };
+            ImDrawList_WriteFringeVertices<4>(_VtxWritePtr, points, temp_point_normals, points_count, scales, uvs, cols);
         }
+        _VtxWritePtr += vtx_count;
         _VtxCurrentIdx += (ImDrawIdx)vtx_count;
     }
     else
@@ -1088,40 +1143,26 @@ void ImDrawList::AddConvexPolyFilled(const ImVec2* points, const int points_coun
         }
 
         // Compute normals
-        _Data->TempBuffer.reserve_discard(points_count);
+        _Data->TempBuffer.reserve_discard(points_count * 2);
         ImVec2* temp_normals = _Data->TempBuffer.Data;
-        for (int i0 = points_count - 1, i1 = 0; i1 < points_count; i0 = i1++)
-        {
-            const ImVec2& p0 = points[i0];
-            const ImVec2& p1 = points[i1];
-            float dx = p1.x - p0.x;
-            float dy = p1.y - p0.y;
-            IM_NORMALIZE2F_OVER_ZERO(dx, dy);
-            temp_normals[i0].x = dy;
-            temp_normals[i0].y = -dx;
-        }
+        ImVec2* temp_point_normals = temp_normals + points_count;
+        ImDrawList_ComputeSegmentNormals(points, points_count, points_count, temp_normals);
+        ImDrawList_ComputePointNormals(temp_normals, points_count, true, temp_point_normals);
 
+        // Add indexes for fringes
         for (int i0 = points_count - 1, i1 = 0; i1 < points_count; i0 = i1++)
         {
-            // Average normals
-            const ImVec2& n0 = temp_normals[i0];
-            const ImVec2& n1 = temp_normals[i1];
-            float dm_x = (n0.x + n1.x) * 0.5f;
-            float dm_y = (n0.y + n1.y) * 0.5f;
-            IM_FIXNORMAL2F(dm_x, dm_y);
-            dm_x *= AA_SIZE * 0.5f;
-            dm_y *= AA_SIZE * 0.5f;
-
-            // Add vertices
-            _VtxWritePtr[0].pos.x = (points[i1].x - dm_x); _VtxWritePtr[0].pos.y = (points[i1].y - dm_y); _VtxWritePtr[0].uv = uv; _VtxWritePtr[0].col = col;        // Inner
-            _VtxWritePtr[1].pos.x = (points[i1].x + dm_x); _VtxWritePtr[1].pos.y = (points[i1].y + dm_y); _VtxWritePtr[1].uv = uv; _VtxWritePtr[1].col = col_trans;  // Outer
-            _VtxWritePtr += 2;
-
-            // Add indexes for fringes
             _IdxWritePtr[0] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1)); _IdxWritePtr[1] = (ImDrawIdx)(vtx_inner_idx + (i0 << 1)); _IdxWritePtr[2] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1));
             _IdxWritePtr[3] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1)); _IdxWritePtr[4] = (ImDrawIdx)(vtx_outer_idx + (i1 << 1)); _IdxWritePtr[5] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1));
             _IdxWritePtr += 6;
         }
+
+        // Add vertices: inner and outer edge of the AA fringe
+        const float scales[2] = { -(AA_SIZE * 0.5f), AA_SIZE * 0.5f };
+        const ImVec2 uvs[2] = { uv, uv };
+        const ImU32 cols[2] = { col, col_trans };
+        ImDrawList_WriteFringeVertices<2>(_VtxWritePtr, points, temp_point_normals, points_count, scales, uvs, cols);
+        _VtxWritePtr += vtx_count;
         _VtxCurrentIdx += (ImDrawIdx)vtx_count;
     }
     else
@@ -214,6 +214,12 @@
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
 #endif
 
+// Engine mode needs glDrawElementsBaseVertex(), fences and glMapBufferRange(), i.e. desktop GL 3.2+
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_VTX_OFFSET
+#define IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+#define IMGUI_IMPL_OPENGL_RING_FRAMES   3       // Frames the GPU may still be reading from the upload ring
+#endif
+
 // Desktop GL 3.3+ and GL ES 3.0+ have glBindSampler()
 #if !defined(IMGUI_IMPL_OPENGL_ES2) && (defined(IMGUI_IMPL_OPENGL_ES3) || defined(GL_VERSION_3_3))
 #define IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
@@ -251,8 +257,22 @@ struct ImGui_ImplOpenGL3_Data
     bool            HasBindSampler;
     bool            HasClipOrigin;
     bool            UseBufferSubData;
+    bool            HasBufferStorage;        // GL 4.4 or GL_ARB_buffer_storage: the upload ring is mapped once, persistently
     ImVector<char>  TempBuffer;
 
+    // Engine mode, see ImGui_ImplOpenGL3_SetEngineMode()
+    bool            EngineMode;
+    GLuint          RingVao;                 // Lives as long as the ring, attributes set once
+    GLuint          RingVboHandle, RingElementsHandle;
+    int             RingVtxCapacity;         // Vertices/indices per frame slot
+    int             RingIdxCapacity;
+    int             RingFrame;               // Slot the next frame writes to
+    char*           RingVtxMapped;           // Persistent mappings, nullptr without buffer storage
+    char*           RingIdxMapped;
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+    GLsync          RingFences[IMGUI_IMPL_OPENGL_RING_FRAMES];
+#endif
+
     ImGui_ImplOpenGL3_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
 
@@ -412,8 +432,19 @@ bool    ImGui_ImplOpenGL3_Init(const char* glsl_version)
         const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
         if (extension != nullptr && strcmp(extension, "GL_ARB_clip_control") == 0)
             bd->HasClipOrigin = true;
+        if (extension != nullptr && strcmp(extension, "GL_ARB_buffer_storage") == 0)
+            bd->HasBufferStorage = true;
     }
 #endif
+#if defined(GL_MAP_PERSISTENT_BIT)
+    bd->HasBufferStorage |= (bd->GlVersion >= 440 && !bd->GlProfileIsES3);
+#ifdef IMGUI_IMPL_OPENGL_LOADER_IMGL3W
+    if (glBufferStorage == nullptr)
+        bd->HasBufferStorage = false;
+#endif
+#else
+    bd->HasBufferStorage = false;
+#endif
 
     return true;
 }
@@ -463,18 +494,18 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     glDisable(GL_STENCIL_TEST);
     glEnable(GL_SCISSOR_TEST);
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_PRIMITIVE_RESTART
-    if (!bd->GlProfileIsES3 && bd->GlVersion >= 310)
+    if (!bd->GlProfileIsES3 && bd->GlVersion >= 310 && !bd->EngineMode)
         glDisable(GL_PRIMITIVE_RESTART);
 #endif
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_POLYGON_MODE
-    if (bd->HasPolygonMode)
+    if (bd->HasPolygonMode && !bd->EngineMode)
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
 
     // Support for GL 4.5 rarely used glClipControl(GL_UPPER_LEFT)
 #if defined(GL_CLIP_ORIGIN)
     bool clip_origin_lower_left = true;
-    if (bd->HasClipOrigin)
+    if (bd->HasClipOrigin && !bd->EngineMode)
     {
         GLenum current_clip_origin = 0; glGetIntegerv(GL_CLIP_ORIGIN, (GLint*)&current_clip_origin);
         if (current_clip_origin == GL_UPPER_LEFT)
@@ -504,7 +535,7 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     glUniformMatrix4fv(bd->AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
 
 #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_BIND_SAMPLER
-    if (bd->HasBindSampler)
+    if (bd->HasBindSampler && !bd->EngineMode)
         glBindSampler(0, 0); // We use combined texture/sampler state. Applications using GL 3.3 and GL ES 3.0 may set that otherwise.
 #endif
 
@@ -512,6 +543,8 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
 #ifdef IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
     glBindVertexArray(vertex_array_object);
 #endif
+    if (bd->EngineMode)
+        return; // The ring VAO already holds the buffer bindings and attribute layout
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, bd->VboHandle));
@@ -524,6 +557,186 @@ static void ImGui_ImplOpenGL3_SetupRenderState(ImDrawData* draw_data, int fb_wid
     GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col)));
 }
 
+//-----------------------------------------------------------------------------
+// Engine mode
+//-----------------------------------------------------------------------------
+// - The default path backs up and restores ~25 pieces of GL state, creates a VAO and respecifies both buffers with
+//   glBufferData() for every draw list. In engine mode the application promises the state contract documented at
+//   ImGui_ImplOpenGL3_SetEngineMode() instead, so nothing is queried and only a few known states are put back.
+// - All draw lists of a frame are copied into one slot of a ring of IMGUI_IMPL_OPENGL_RING_FRAMES slots, held in
+//   one vertex and one index buffer behind a VAO that lives as long as the ring. A fence per slot keeps the CPU
+//   from overwriting a slot the GPU is still reading; draws pick their slot through the base vertex and index offset.
+// - With buffer storage the ring is mapped once, persistently and coherently. Otherwise each frame maps just its
+//   slot with GL_MAP_UNSYNCHRONIZED_BIT, since the fences already did the synchronizing.
+//-----------------------------------------------------------------------------
+
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+
+static void ImGui_ImplOpenGL3_DestroyRing()
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    for (GLsync& fence : bd->RingFences)
+        if (fence) { glDeleteSync(fence); fence = nullptr; }
+    // Deleting a buffer also unmaps it. The driver keeps the storage alive until draws still using it retire.
+    if (bd->RingVboHandle)      { glDeleteBuffers(1, &bd->RingVboHandle); bd->RingVboHandle = 0; }
+    if (bd->RingElementsHandle) { glDeleteBuffers(1, &bd->RingElementsHandle); bd->RingElementsHandle = 0; }
+    if (bd->RingVao)            { glDeleteVertexArrays(1, &bd->RingVao); bd->RingVao = 0; }
+    bd->RingVtxMapped = bd->RingIdxMapped = nullptr;
+    bd->RingVtxCapacity = bd->RingIdxCapacity = 0;
+    bd->RingFrame = 0;
+}
+
+static void ImGui_ImplOpenGL3_CreateRing(int vtx_count, int idx_count)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    ImGui_ImplOpenGL3_DestroyRing();
+
+    // Leave headroom so a window gaining a few lines doesn't rebuild the ring every frame.
+    bd->RingVtxCapacity = vtx_count + vtx_count / 2 > 16384 ? vtx_count + vtx_count / 2 : 16384;
+    bd->RingIdxCapacity = idx_count + idx_count / 2 > 32768 ? idx_count + idx_count / 2 : 32768;
+    const GLsizeiptr vtx_size = (GLsizeiptr)bd->RingVtxCapacity * IMGUI_IMPL_OPENGL_RING_FRAMES * (int)sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)bd->RingIdxCapacity * IMGUI_IMPL_OPENGL_RING_FRAMES * (int)sizeof(ImDrawIdx);
+
+    glGenVertexArrays(1, &bd->RingVao);
+    glGenBuffers(1, &bd->RingVboHandle);
+    glGenBuffers(1, &bd->RingElementsHandle);
+    glBindVertexArray(bd->RingVao);
+    glBindBuffer(GL_ARRAY_BUFFER, bd->RingVboHandle);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bd->RingElementsHandle);
+#if defined(GL_MAP_PERSISTENT_BIT)
+    if (bd->HasBufferStorage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GL_CALL(glBufferStorage(GL_ARRAY_BUFFER, vtx_size, nullptr, flags));
+        GL_CALL(glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, idx_size, nullptr, flags));
+        bd->RingVtxMapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, vtx_size, flags);
+        bd->RingIdxMapped = (char*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, idx_size, flags);
+    }
+    else
+#endif
+    {
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER, vtx_size, nullptr, GL_STREAM_DRAW));
+        GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_size, nullptr, GL_STREAM_DRAW));
+    }
+
+    // Attributes point at the start of the ring, the base vertex of each draw selects the slot
+    GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxPos));
+    GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxUV));
+    GL_CALL(glEnableVertexAttribArray(bd->AttribLocationVtxColor));
+    GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxPos,   2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, pos)));
+    GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxUV,    2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, uv)));
+    GL_CALL(glVertexAttribPointer(bd->AttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col)));
+}
+
+static void ImGui_ImplOpenGL3_RenderDrawDataEngine(ImDrawData* draw_data, int fb_width, int fb_height)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    if (draw_data->TotalVtxCount > bd->RingVtxCapacity || draw_data->TotalIdxCount > bd->RingIdxCapacity)
+        ImGui_ImplOpenGL3_CreateRing(draw_data->TotalVtxCount, draw_data->TotalIdxCount);
+
+    // Wait for the GPU to be done with what this slot held IMGUI_IMPL_OPENGL_RING_FRAMES frames ago (normally long since)
+    const int slot = bd->RingFrame;
+    if (GLsync fence = bd->RingFences[slot])
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)1000000000);
+        glDeleteSync(fence);
+        bd->RingFences[slot] = nullptr;
+    }
+
+    ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, bd->RingVao);
+
+    // Upload every draw list at once
+    const int slot_vtx = slot * bd->RingVtxCapacity;
+    const int slot_idx = slot * bd->RingIdxCapacity;
+    const GLsizeiptr vtx_size = (GLsizeiptr)draw_data->TotalVtxCount * (int)sizeof(ImDrawVert);
+    const GLsizeiptr idx_size = (GLsizeiptr)draw_data->TotalIdxCount * (int)sizeof(ImDrawIdx);
+    if (vtx_size > 0 && idx_size > 0)
+    {
+        char* vtx_dst = bd->RingVtxMapped ? bd->RingVtxMapped + (size_t)slot_vtx * sizeof(ImDrawVert) : nullptr;
+        char* idx_dst = bd->RingIdxMapped ? bd->RingIdxMapped + (size_t)slot_idx * sizeof(ImDrawIdx) : nullptr;
+        if (vtx_dst == nullptr)
+        {
+            const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+            glBindBuffer(GL_ARRAY_BUFFER, bd->RingVboHandle);
+            vtx_dst = (char*)glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)slot_vtx * (int)sizeof(ImDrawVert), vtx_size, access);
+            idx_dst = (char*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)slot_idx * (int)sizeof(ImDrawIdx), idx_size, access);
+        }
+        if (vtx_dst != nullptr && idx_dst != nullptr)
+        {
+            for (const ImDrawList* draw_list : draw_data->CmdLists)
+            {
+                memcpy(vtx_dst, draw_list->VtxBuffer.Data, (size_t)draw_list->VtxBuffer.Size * sizeof(ImDrawVert));
+                memcpy(idx_dst, draw_list->IdxBuffer.Data, (size_t)draw_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+                vtx_dst += (size_t)draw_list->VtxBuffer.Size * sizeof(ImDrawVert);
+                idx_dst += (size_t)draw_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+            }
+        }
+        if (bd->RingVtxMapped == nullptr)
+        {
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        }
+    }
+
+    // Render command lists
+    ImVec2 clip_off = draw_data->DisplayPos;
+    ImVec2 clip_scale = draw_data->FramebufferScale;
+    int list_vtx = slot_vtx;
+    int list_idx = slot_idx;
+    for (const ImDrawList* draw_list : draw_data->CmdLists)
+    {
+        for (int cmd_i = 0; cmd_i < draw_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &draw_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback != nullptr)
+            {
+                if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
+                    ImGui_ImplOpenGL3_SetupRenderState(draw_data, fb_width, fb_height, bd->RingVao);
+                else
+                    pcmd->UserCallback(draw_list, pcmd);
+                continue;
+            }
+            ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
+            ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+            if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+                continue;
+            GL_CALL(glScissor((int)clip_min.x, (int)((float)fb_height - clip_max.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y)));
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->GetTexID()));
+            GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)((list_idx + pcmd->IdxOffset) * sizeof(ImDrawIdx)), (GLint)(list_vtx + pcmd->VtxOffset)));
+        }
+        list_vtx += draw_list->VtxBuffer.Size;
+        list_idx += draw_list->IdxBuffer.Size;
+    }
+    bd->RingFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    bd->RingFrame = (slot + 1) % IMGUI_IMPL_OPENGL_RING_FRAMES;
+
+    // Hand the engine back its defaults
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glEnable(GL_DEPTH_TEST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+#endif // #ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+
+bool    ImGui_ImplOpenGL3_SetEngineMode(bool enabled)
+{
+    ImGui_ImplOpenGL3_Data* bd = ImGui_ImplOpenGL3_GetBackendData();
+    IM_ASSERT(bd != nullptr && "Context or backend not initialized! Did you call ImGui_ImplOpenGL3_Init()?");
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+    if (bd->GlVersion < 320 || bd->GlProfileIsES3)
+        enabled = false;
+    if (!enabled)
+        ImGui_ImplOpenGL3_DestroyRing();
+#else
+    enabled = false;
+#endif
+    bd->EngineMode = enabled;
+    return enabled;
+}
+
 // OpenGL3 Render function.
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly.
 // This is in order to be able to run within an OpenGL engine that doesn't do so.
@@ -546,6 +759,14 @@ void    ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data)
             if (tex->Status != ImTextureStatus_OK)
                 ImGui_ImplOpenGL3_UpdateTexture(tex);
 
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+    if (bd->EngineMode)
+    {
+        ImGui_ImplOpenGL3_RenderDrawDataEngine(draw_data, fb_width, fb_height);
+        return;
+    }
+#endif
+
     // Backup GL state
     GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
     glActiveTexture(GL_TEXTURE0);
@@ -1040,6 +1261,9 @@ void    ImGui_ImplOpenGL3_DestroyDeviceObjects()
     if (bd->VboHandle)      { glDeleteBuffers(1, &bd->VboHandle); bd->VboHandle = 0; }
     if (bd->ElementsHandle) { glDeleteBuffers(1, &bd->ElementsHandle); bd->ElementsHandle = 0; }
     if (bd->ShaderHandle)   { glDeleteProgram(bd->ShaderHandle); bd->ShaderHandle = 0; }
+#ifdef IMGUI_IMPL_OPENGL_MAY_HAVE_ENGINE_MODE
+    ImGui_ImplOpenGL3_DestroyRing();
+#endif
 
     // Destroy all textures
     for (ImTextureData* tex : ImGui::GetPlatformIO().Textures)
@@ -40,6 +40,16 @@ IMGUI_IMPL_API void     ImGui_ImplOpenGL3_RenderDrawData(ImDrawData* draw_data);
 IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_DestroyDeviceObjects();
 
+// (Advanced) Engine mode: skip the GL state backup/restore and upload all draw lists of a frame at once into a ring buffer
+// (persistently mapped when GL 4.4 / GL_ARB_buffer_storage is available). Needs desktop GL 3.2+, returns whether it is on.
+// In exchange the application promises this state when calling ImGui_ImplOpenGL3_RenderDrawData():
+//  - texture unit 0 active, no sampler object bound to it, polygon mode GL_FILL,
+//  - face culling, stencil test and primitive restart disabled, clip origin GL_LOWER_LEFT,
+// and accepts this state on return:
+//  - blending and scissor test disabled, depth test enabled, viewport covering the framebuffer,
+//  - no program, no VAO and no GL_TEXTURE_2D bound; GL_ARRAY_BUFFER binding undefined.
+IMGUI_IMPL_API bool     ImGui_ImplOpenGL3_SetEngineMode(bool enabled);
+
 // (Advanced) Use e.g. if you need to precisely control the timing of texture updates (e.g. for staged rendering), by setting ImDrawData::Textures = NULL to handle this manually.
 IMGUI_IMPL_API void     ImGui_ImplOpenGL3_UpdateTexture(ImTextureData* tex);
 
@@ -10,6 +10,14 @@ uniform vec3 lightColor;
 uniform vec3 playerColor; // The uniform you set in C++ with cubeShader.setVec3
 uniform bool isInstanced; // The toggle you set in C++
 
+// Clustered point lights, filled by LightGrid (see LightGrid.h)
+uniform usamplerBuffer clusterLights; // per cluster: first index, count
+uniform usamplerBuffer lightIndices;
+uniform samplerBuffer lightData;      // per light: pos + radius, color
+uniform ivec3 clusterDims;            // tiles x, tiles y, depth slices
+uniform vec2 clusterTile;             // tile size in pixels
+uniform vec4 clusterDepth;            // near, far, slice scale, slice bias
+
 void main() {
     // 1. Pick the base color
     vec3 baseColor;
@@ -28,8 +36,24 @@ void main() {
     vec3 lightDir = normalize(lightPos - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
+
+    // 4. Point lights, only the ones listed for this fragment's cluster
+    float depth = clusterDepth.x * clusterDepth.y / (clusterDepth.y - gl_FragCoord.z * (clusterDepth.y - clusterDepth.x));
+    int slice = clamp(int(log(depth) * clusterDepth.z - clusterDepth.w), 0, clusterDims.z - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTile), clusterDims.xy - 1);
+    uvec2 range = texelFetch(clusterLights, (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).x);
+        vec4 posRadius = texelFetch(lightData, light * 2);
+        vec3 toLight = posRadius.xyz - FragPos;
+        float dist2 = dot(toLight, toLight);
+        // Smooth falloff that reaches zero exactly at the radius the grid culled with.
+        float falloff = clamp(1.0 - dist2 / (posRadius.w * posRadius.w), 0.0, 1.0);
+        float lit = max(dot(norm, toLight * inversesqrt(max(dist2, 1e-4))), 0.0);
+        diffuse += lit * falloff * falloff * texelFetch(lightData, light * 2 + 1).rgb;
+    }
     
-    // 4. Final Result
+    // 5. Final Result
     // If baseColor is black (0,0,0), the result will always be black!
     vec3 result = (ambient + diffuse) * baseColor;
     FragColor = vec4(result, 1.0);
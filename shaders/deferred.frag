@@ -0,0 +1,58 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 invViewProjection;
+
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+
+// Clustered point lights, as in default.frag
+uniform usamplerBuffer clusterLights;
+uniform usamplerBuffer lightIndices;
+uniform samplerBuffer lightData;
+uniform ivec3 clusterDims;
+uniform vec2 clusterTile;
+uniform vec4 clusterDepth;
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main() {
+    // 1. Unpack the surface; pixels nothing was drawn to keep the clear color
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float z = texelFetch(gDepth, pixel, 0).r;
+    if (z == 1.0) discard;
+    vec3 baseColor = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec3 norm = decodeNormal(texelFetch(gNormal, pixel, 0).rg);
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    vec4 world = invViewProjection * vec4(vec3(uv, z) * 2.0 - 1.0, 1.0);
+    vec3 FragPos = world.xyz / world.w;
+
+    // 2. Ambient and the player light, same as default.frag
+    vec3 ambient = 0.2 * lightColor;
+    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 diffuse = max(dot(norm, lightDir), 0.0) * lightColor;
+
+    // 3. Point lights from this pixel's cluster
+    float depth = clusterDepth.x * clusterDepth.y / (clusterDepth.y - z * (clusterDepth.y - clusterDepth.x));
+    int slice = clamp(int(log(depth) * clusterDepth.z - clusterDepth.w), 0, clusterDims.z - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterTile), clusterDims.xy - 1);
+    uvec2 range = texelFetch(clusterLights, (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).x);
+        vec4 posRadius = texelFetch(lightData, light * 2);
+        vec3 toLight = posRadius.xyz - FragPos;
+        float dist2 = dot(toLight, toLight);
+        float falloff = clamp(1.0 - dist2 / (posRadius.w * posRadius.w), 0.0, 1.0);
+        float lit = max(dot(norm, toLight * inversesqrt(max(dist2, 1e-4))), 0.0);
+        diffuse += lit * falloff * falloff * texelFetch(lightData, light * 2 + 1).rgb;
+    }
+
+    FragColor = vec4((ambient + diffuse) * baseColor, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec2 gNormal;
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec3 Color;
+
+uniform vec3 playerColor;
+uniform bool isInstanced;
+
+// Octahedral encoding: a unit normal folded onto [-1, 1]^2.
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.xy;
+}
+
+void main() {
+    // Same color choice as default.frag; lighting happens in deferred.frag.
+    gAlbedo = vec4(isInstanced ? Color : playerColor, 1.0);
+    gNormal = encodeNormal(normalize(Normal));
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColor;
+
+// Premultiplied overlay, same size as the framebuffer.
+uniform sampler2D overlay;
+
+void main() {
+    FragColor = texelFetch(overlay, ivec2(gl_FragCoord.xy), 0);
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 330 core
+// Quad from gl_VertexID (triangle strip), corners in NDC.
+uniform vec4 rect; // x0, y0, x1, y1
+
+void main() {
+    vec2 t = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(mix(rect.xy, rect.zw, t), 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#version 330 core
+layout (location = 0) in vec2 aGrid;   // 0..1 across the node
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform sampler2D heightmap;
+uniform vec4 terrain;      // x/z of the grid corner, cell size, samples per side
+uniform vec3 node;         // x/z of the node corner, node size
+uniform vec2 morph;        // distance where morphing starts and where it's complete
+uniform float gridDim;     // quads per side of the grid mesh
+uniform vec3 cameraPos;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec3 Color;
+
+float heightAt(vec2 xz) {
+    vec2 uv = ((xz - terrain.xy) / terrain.z + 0.5) / terrain.w;
+    return texture(heightmap, uv).r;
+}
+
+void main() {
+    vec2 xz = node.xy + aGrid * node.z;
+    float dist = distance(cameraPos, vec3(xz.x, heightAt(xz), xz.y));
+    float k = clamp((dist - morph.x) / (morph.y - morph.x), 0.0, 1.0);
+
+    // Slide odd grid vertices onto their even neighbour: at k = 1 the node is
+    // exactly the next coarser level's grid.
+    vec2 odd = fract(aGrid * gridDim * 0.5) * 2.0;
+    xz -= odd / gridDim * node.z * k;
+    float h = heightAt(xz);
+
+    float e = terrain.z;
+    float l = heightAt(xz - vec2(e, 0.0)), r = heightAt(xz + vec2(e, 0.0));
+    float d = heightAt(xz - vec2(0.0, e)), u = heightAt(xz + vec2(0.0, e));
+    Normal = normalize(vec3(l - r, 2.0 * e, d - u));
+
+    // Grass on the flats, rock on the slopes
+    Color = mix(vec3(0.45, 0.42, 0.38), vec3(0.22, 0.38, 0.18), smoothstep(0.7, 0.9, Normal.y));
+
+    FragPos = vec3(xz.x, h, xz.y);
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 FragColor;
+
+// Scene rendered below window resolution, filtered up to fill the window.
+uniform sampler2D scene;
+uniform vec2 outputSize;   // window size in pixels
+uniform float sharpness;   // 0 = plain bilinear
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    vec3 c = texture(scene, uv).rgb;
+    if (sharpness > 0.0) {
+        // Unsharp mask over the neighbouring source texels, clamped to
+        // their range so edges sharpen without ringing.
+        vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+        vec3 n = texture(scene, uv + vec2(0.0, texel.y)).rgb;
+        vec3 s = texture(scene, uv - vec2(0.0, texel.y)).rgb;
+        vec3 e = texture(scene, uv + vec2(texel.x, 0.0)).rgb;
+        vec3 w = texture(scene, uv - vec2(texel.x, 0.0)).rgb;
+        vec3 lo = min(c, min(min(n, s), min(e, w)));
+        vec3 hi = max(c, max(max(n, s), max(e, w)));
+        c = clamp(c + sharpness * (4.0 * c - n - s - e - w) * 0.25, lo, hi);
+    }
+    FragColor = vec4(c, 1.0);
+}
\ No newline at end of file
@@ -7,19 +7,90 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <cstring>
 #include "Shader.h"
 #include "Shapes.h"
 #include "Mesh.h"
 #include "objModel.h"
-
-int main() {
-    srand(static_cast<unsigned int>(time(NULL)));
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_FLOATING, GLFW_TRUE);
-    window = glfwCreateWindow(width, height, "OpenGL HUD", NULL, NULL);
+#include "Arena.h"
+#include "AllocStats.h"
+#include "Profiler.h"
+#include "GpuTimer.h"
+#include "Benchmark.h"
+#include "FlowField.h"
+#include "SweepAndPrune.h"
+#include "Terrain.h"
+#include "WorldPartition.h"
+#include "LightGrid.h"
+#include "GBuffer.h"
+#include "OcclusionCuller.h"
+#include "OverlayCache.h"
+#include "InputQueue.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "OffscreenRenderer.h"
+#include "CommandBuffer.h"
+#include "GLState.h"
+#include <memory>
+
+int main(int argc, char** argv) {
+    // --trace <file>: write a Chrome trace of the whole run on exit
+    // --frame-times <file>: write the frame-time histogram on exit
+    // --capture-commands <file>: save the last frame's scene commands on exit (F11 saves the current one)
+    // --replay-commands <file>: draw a saved scene in place of the live one
+    // --dump-commands <file>: print a saved scene's commands and exit
+    const char* tracePath = nullptr;
+    const char* frameTimesPath = nullptr;
+    const char* captureCommandsPath = nullptr;
+    const char* replayCommandsPath = nullptr;
+    const char* dumpCommandsPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) tracePath = argv[++i];
+        else if (strcmp(argv[i], "--frame-times") == 0 && i + 1 < argc) frameTimesPath = argv[++i];
+        else if (strcmp(argv[i], "--capture-commands") == 0 && i + 1 < argc) captureCommandsPath = argv[++i];
+        else if (strcmp(argv[i], "--replay-commands") == 0 && i + 1 < argc) replayCommandsPath = argv[++i];
+        else if (strcmp(argv[i], "--dump-commands") == 0 && i + 1 < argc) dumpCommandsPath = argv[++i];
+    }
+    if (dumpCommandsPath) {
+        CommandBuffer cmds;
+        if (!cmds.load(dumpCommandsPath)) return 1;
+        cmds.dump(std::cout);
+        return 0;
+    }
+    BenchOptions benchOpts;
+    if (!parseBenchArgs(argc, argv, benchOpts)) return 2;
+    OffscreenOptions offscreenOpts;
+    if (!parseOffscreenArgs(argc, argv, offscreenOpts)) return 2;
+    benchOpts.offscreen = offscreenOpts.enabled;
+    // Scripted runs build the chasers' flow field in the tick that asks for
+    // it, so their steering does not depend on thread timing.
+    if (benchOpts.enabled || offscreenOpts.enabled) flowField().setSynchronous(true);
+    PROFILE_THREAD("Main");
+    if (benchOpts.enabled && benchOpts.headless) {
+        int rc = runHeadlessBenchmark(benchOpts);
+        if (tracePath) profilerExportChromeTrace(tracePath);
+        return rc;
+    }
+    // Offscreen runs are meant to render the same frames every time.
+    srand(offscreenOpts.enabled ? 1u : static_cast<unsigned int>(time(NULL)));
+    const char* offscreenApi = nullptr;
+    if (offscreenOpts.enabled) {
+        width = offscreenOpts.width;
+        height = offscreenOpts.height;
+        window = createOffscreenWindow(width, height, &offscreenApi);
+        if (!window) {
+            std::cout << "Offscreen context creation failed: no EGL, OSMesa or desktop GL" << std::endl;
+            return -1;
+        }
+    }
+    else {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_FLOATING, GLFW_TRUE);
+        window = glfwCreateWindow(width, height, "OpenGL HUD", NULL, NULL);
+    }
     if (!window) {
         const char* description;
         int code = glfwGetError(&description);
@@ -29,6 +100,8 @@ int main() {
     }
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    // Explicit, not whatever the driver defaults to; offscreen there is nothing to sync to.
+    framePacer().setMode(window, offscreenOpts.enabled ? PacingMode::Uncapped : PacingMode::Vsync);
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
     lastX = (float)width / 2.0f;
@@ -37,401 +110,711 @@ int main() {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glEnable(GL_DEPTH_TEST);
-    Shader cubeShader("shaders/default.vert", "shaders/default.frag");
-    Shader hudShader("shaders/rectangle.vert", "shaders/rectangle.frag");
+    glState().setDepthTest(true);
+    gpuTimers().init();
+    // Kick off every program build now and collect them after the models load,
+    // so the driver can compile while assimp is busy.
+    shaderCacheInit((GLADloadproc)glfwGetProcAddress);
+    // Each scene program comes in a forward (lit) and a G-buffer variant.
+    Shader cubeForwardShader, terrainForwardShader, cubeGBufferShader, terrainGBufferShader;
+    Shader deferredShader, hudShader, overlayShader, upscaleShader;
+    ShaderBatch shaderBatch;
+    shaderBatch.add(cubeForwardShader, "shaders/default.vert", "shaders/default.frag");
+    shaderBatch.add(terrainForwardShader, "shaders/terrain.vert", "shaders/default.frag");
+    shaderBatch.add(cubeGBufferShader, "shaders/default.vert", "shaders/gbuffer.frag");
+    shaderBatch.add(terrainGBufferShader, "shaders/terrain.vert", "shaders/gbuffer.frag");
+    shaderBatch.add(deferredShader, "shaders/deferred.vert", "shaders/deferred.frag");
+    shaderBatch.add(hudShader, "shaders/rectangle.vert", "shaders/rectangle.frag");
+    shaderBatch.add(overlayShader, "shaders/overlay.vert", "shaders/overlay.frag");
+    shaderBatch.add(upscaleShader, "shaders/deferred.vert", "shaders/upscale.frag");
     IMGUI_CHECKVERSION();
+    allocStatsHookImGui();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
+    ImGui_ImplOpenGL3_SetEngineMode(true); // the frame loop keeps to the backend's state contract
     ImGui::StyleColorsDark();
+    AllocScope assetScope(ALLOC_ASSETS);
     Mesh cubeMesh(Shapes::cubeVertices, sizeof(Shapes::cubeVertices), { 3, 3 }, sizeof(CubeInstance));
     Mesh hudMesh(Shapes::rectangleVertices, sizeof(Shapes::rectangleVertices), { 3 });
-    Mesh planeMesh(Shapes::quadVertices, sizeof(Shapes::quadVertices), { 3, 3 });
     objModel myModel("models/projectile.obj");
     objModel pillar("models/pillar.obj");
     objModel floater("models/floater.obj");
     objModel emers("models/emers.obj");
+    shaderBatch.wait();
+    emersonMinBounds = emers.minBounds;
+    emersonMaxBounds = emers.maxBounds;
+    emersonBVH = &emers.getBVH();
+    pillarBVH = &pillar.getBVH();
+    pillarMinBounds = pillar.minBounds;
+    pillarMaxBounds = pillar.maxBounds;
+    terrain().initGL();
+    // Occluder shapes for the CPU culling pass, boxes fitted inside the meshes.
+    OcclusionCuller::Proxy pillarProxy = OcclusionCuller::makeProxy(pillar.getBVH(), pillar.minBounds, pillar.maxBounds);
+    OcclusionCuller::Proxy emersonProxy = OcclusionCuller::makeProxy(emers.getBVH(), emers.minBounds, emers.maxBounds);
+    lightGrid().initGL();
     float lastFrame = 0.0f;
-    initGame();
+    double simMs = 0.0;
+    double overlayMs = 0.0;
+    RollingStats<120> frameTimes; // ImGui's own rate only counts overlay refreshes
+    // Input-to-submit latency, with and without the late latch.
+    RollingStats<120> latchedLatency, tickLatency;
+    uint64_t tickInputNs = 0, sampledInputNs = 0;
+    initGame(benchOpts.enabled || offscreenOpts.enabled ? "" : "world"); // the bench and offscreen runs use a fixed world
+    std::unique_ptr<Benchmark> bench;
+    if (benchOpts.enabled) {
+        bench = std::make_unique<Benchmark>(benchOpts);
+        framePacer().setMode(window, PacingMode::Uncapped); // measure the frame, not the display
+        if (!bench->nextScenario()) glfwSetWindowShouldClose(window, true);
+    }
+    std::unique_ptr<OffscreenRenderer> offscreen;
+    if (offscreenOpts.enabled) {
+        offscreen = std::make_unique<OffscreenRenderer>(offscreenOpts, offscreenApi);
+        // The scale would follow GPU timings, which differ run to run.
+        dynamicResolution().setEnabled(false);
+    }
+    // Scene passes, recorded each frame and issued in this order.
+    enum ScenePass { PassSetup, PassCubes, PassPillars, PassFloater, PassEmersons, PassProjectiles, PassParticles, PassHealthBars, PassPlayer, ScenePassCount };
+    const char* scenePassNames[ScenePassCount] = { "Setup", "Cubes", "Pillars", "Floater", "Emerson", "Projectiles", "Particles", "Health bars", "Player" };
+    CommandBuffer sceneCmds[ScenePassCount]; // cleared each frame, keeping their storage
+    RecordThread recorder;
+    auto saveSceneCommands = [&](const char* path) {
+        CommandBuffer frame;
+        for (auto& cmds : sceneCmds) frame.append(cmds);
+        if (frame.save(path)) std::cout << "Saved " << frame.commandCount() << " render commands to " << path << std::endl;
+    };
+    CommandBuffer replayCmds;
+    if (replayCommandsPath && !replayCmds.load(replayCommandsPath)) return 1;
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_FRAME();
+        PROFILE_SCOPE("Frame");
+        allocStatsBeginFrame();
+        AllocScope frameScope(ALLOC_OTHER);
+        uint64_t frameStart = profilerNowNs();
+        frameDrawCalls = 0;
+        glState().beginFrame();
         player& p = players[0];
         float currentFrame = (float)glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-
-        cameraPos = p.pos;
-        cameraFront = p.front;
-        yaw = p.yaw;
-        pitch = p.pitch;
-
-        processInput(window);
-
-
-        glm::mat4 ground = glm::translate(glm::mat4(1.0f), glm::vec3(0, -1, 0));
-        glm::vec3 groundPos = glm::vec3(ground[3]);
-        ground = glm::scale(ground, glm::vec3(60.0f, 1.0f, 60.0f));
-
-        // --- 1. PURE LOGIC STEP ---
-        if (!isPaused) {
-            handleGravity();
-     
-            for (auto& proj : projectiles) {
-                glm::vec3 movement = proj.vel * deltaTime;
-                proj.pos += movement;
-                proj.rotation += proj.rotVel * deltaTime;
-                proj.distanceTraveled += glm::length(movement);
-                if (proj.distanceTraveled >= 75.0f) {
-                    createSplash(proj.pos, glm::vec3(rand(), rand(), rand()));
-                    proj.dmg = 0; // Mark for deletion
-                    continue;     // Skip collision check since it's dead
-                }
-                for (auto& enemy : cubes) {
-                    if (enemy.chases) {
-                        float dist = glm::distance(proj.pos, enemy.pos);
-                        if (dist < (enemy.scale)) {
-                            enemy.health -= proj.dmg;
-                            proj.dmg = 0; // Mark projectile for deletion
-                            createSplash(proj.pos, glm::vec3(0.7f, 0.3f, 0.0f));
-                        }
-                    }
-                }
-                for (auto& emerson : emersons) {
-                    glm::mat4 modelMatrix = glm::mat4(1.0f);
-                    modelMatrix = glm::translate(modelMatrix, emerson.pos);
-                    modelMatrix = glm::rotate(modelMatrix, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-                    float currentAngle = (float)glfwGetTime() * 2.0f;
-                    modelMatrix = glm::rotate(modelMatrix, currentAngle, glm::vec3(0.0f, 0.0f, 1.0f));
-                    glm::mat4 invModel = glm::inverse(modelMatrix);
-                    glm::vec3 localProjPos = glm::vec3(invModel * glm::vec4(proj.pos, 1.0f));
-                    bool hit = (localProjPos.x >= emers.minBounds.x && localProjPos.x <= emers.maxBounds.x) &&
-                        (localProjPos.y >= emers.minBounds.y && localProjPos.y <= emers.maxBounds.y) &&
-                        (localProjPos.z >= emers.minBounds.z && localProjPos.z <= emers.maxBounds.z);
-
-                    if (hit) {
-                        emerson.health -= proj.dmg;
-                        proj.dmg = 0;
-                        createSplash(proj.pos, glm::vec3(0.7f, 0.3f, 0.0f));
-                    }
-                }
+        frameTimes.add(deltaTime);
+        if (bench) bench->beginTick(); // scripted input, fixed dt
+        else if (offscreen) deltaTime = OffscreenRenderer::kFrameSeconds;
+        worldTime += deltaTime;
+
+        {
+            PROFILE_SCOPE("Input");
+            AllocScope scope(ALLOC_INPUT);
+            if (!bench) {
+                uint64_t consumedNs = consumeInput(frameStart);
+                if (consumedNs) tickInputNs = consumedNs;
             }
-            std::erase_if(projectiles, [](const projectile& p) { return p.dmg <= 0; });
-        }
-        for (auto& p : splashParticles) {
-            p.vel.y += gravity * deltaTime; // Apply gravity to splash too
-            p.pos += p.vel * deltaTime;
-            p.life -= deltaTime * 1.5f;    // Particles last about 0.6 seconds
-            if (p.pos.y < groundy) {
-                // Snap to surface so it doesn't get stuck underground
-                p.pos.y = groundy;
-
-                // Invert Y velocity and reduce it (0.4f = 40% energy kept)
-                p.vel.y = -p.vel.y * 0.4f;
-
-                // Friction: Slow down horizontal movement on impact
-                p.vel.x *= 0.8f;
-                p.vel.z *= 0.8f;
+            else {
+                inputQueue().clear(); // the bench scripts the camera
             }
+            // After the queued look moves, so shots fired below aim this tick.
+            cameraPos = p.pos;
+            cameraFront = p.front;
+            yaw = p.yaw;
+            pitch = p.pitch;
+            if (!bench) processInput(window);
         }
-        // Remove dead particles
-        std::erase_if(splashParticles, [](const SplashParticle& p) {
-            return p.life <= 0.0f;
-            });
-        // Cleanup and Spawning
-        std::erase_if(cubes, [](const CubeInstance& cube) {
-            return (cube.scale <= 0.0f && cube.timeAlive >= 0) || (cube.timeAlive < 0 && cube.health <= 0.0f);
-            });
-
-        int colliderCount = 0;
-        for (auto& c : cubes) if (c.timeAlive < 0) colliderCount++;
-        while (colliderCount < colliders) {
-            spawnEnemyAtRadius(15.0f, 30.0f);
-            colliderCount++;
+
+
+        // --- 1. PURE LOGIC STEP ---
+        {
+            AllocScope simScope(ALLOC_SIM);
+            uint64_t simStart = profilerNowNs();
+            if (!bench) streamWorld();
+            updateWorld();
+            simMs = (profilerNowNs() - simStart) / 1e6;
         }
 
         // --- 2. RENDERING STEP ---
+        AllocScope renderScope(ALLOC_RENDER);
+        gpuTimers().beginFrame();
+        int fbWidth, fbHeight;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        if (offscreen) offscreen->beginFrame(fbWidth, fbHeight);
         glClearColor(0.02f, 0.02f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        int fbWidth, fbHeight;
-        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)fbWidth / fbHeight, 0.1f, 100.0f);
+        // Late latch: poll again for input that arrived during the tick and
+        // aim the view with the newest cursor position. Those moves stay
+        // queued for the next tick; only the view sees them early. Culling
+        // and the light grid below use this same view.
+        uint64_t latchedNs = 0;
+        glm::vec3 viewFront = p.front;
+        if (!bench) {
+            PROFILE_SCOPE("Late latch");
+            glfwPollEvents();
+            viewFront = latchLook(p, latchedNs);
+        }
         glm::mat4 view = (usingSkyCamera) ?
             glm::lookAt(p.pos + glm::vec3(0.0f, 30.0f, 0.01f), p.pos, glm::vec3(0.0f, 0.0f, -1.0f)) :
-            glm::lookAt(p.pos, p.pos + p.front, p.up);
+            glm::lookAt(p.pos, p.pos + viewFront, p.up);
+
+        // Point lights for the clustered grid: emersons glow, projectiles and splashes flash.
+        {
+            LightGrid& lights = lightGrid();
+            lights.clear();
+            for (auto& e : emersons) lights.add(e.pos + glm::vec3(0.0f, 1.5f, 0.0f), 10.0f, glm::vec3(0.6f, 0.2f, 0.8f));
+            for (auto& proj : projectiles) lights.add(proj.pos, 5.0f, glm::vec3(1.0f, 0.8f, 0.5f));
+            for (auto& f : splashFlashes) lights.add(f.pos + glm::vec3(0.0f, 0.5f, 0.0f), 6.0f * f.life, f.color * (2.0f * f.life));
+            lights.build(view, glm::radians(45.0f), (float)fbWidth / fbHeight, 0.1f, 100.0f);
+        }
 
-        cubeShader.use();
-        cubeShader.setVec3("lightPos", p.pos);
-        cubeShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f)); // Pure white light
-        cubeShader.setMat4("projection", projection);
-        cubeShader.setMat4("view", view);
-        cubeShader.setVec3("viewPos", cameraPos);
+        // Pillars and emersons into the software depth buffer; cubes and
+        // projectiles behind them are dropped before their draws are built.
+        OcclusionCuller& culler = occlusionCuller();
+        {
+            PROFILE_SCOPE("Occluders");
+            culler.begin(projection * view);
+            for (auto& pill : pillars) culler.addOccluder(pillarProxy, glm::translate(glm::mat4(1.0f), pill.pos));
+            for (auto& e : emersons) culler.addOccluder(emersonProxy, emersonTransform(e));
+            culler.render();
+        }
+        int culledCubes = 0, culledProjectiles = 0;
+
+        // With dynamic resolution on, the 3D passes draw into the scaled
+        // scene target and are filtered up to the window afterwards.
+        DynamicResolution& res = dynamicResolution();
+        bool scaled = res.isEnabled();
+        if (scaled) res.beginScene(fbWidth, fbHeight);
+        int sceneWidth = scaled ? res.sceneWidth() : fbWidth;
+        int sceneHeight = scaled ? res.sceneHeight() : fbHeight;
+        GLuint sceneTarget = scaled ? res.framebuffer() : windowFramebuffer;
+
+        // Forward shades as it draws; deferred draws into the G-buffer and
+        // lights once afterwards. The path passes are timed whether or not
+        // the per-draw GPU scopes are compiled in.
+        Shader& cubeShader = deferredShading ? cubeGBufferShader : cubeForwardShader;
+        Shader& terrainShader = deferredShading ? terrainGBufferShader : terrainForwardShader;
+        if (deferredShading) {
+            gbuffer().resize(sceneWidth, sceneHeight);
+            gbuffer().beginGeometry();
+        }
+        gpuTimers().begin(deferredShading ? "G-buffer" : "Forward");
+
+        // A. DRAW TERRAIN
+        {
+            PROFILE_SCOPE("Draw terrain");
+            GPU_SCOPE("Terrain");
+            terrainShader.use();
+            terrainShader.setVec3("lightPos", p.pos);
+            terrainShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+            terrainShader.setMat4("projection", projection);
+            terrainShader.setMat4("view", view);
+            terrainShader.setInt("isInstanced", 1); // default.frag: take the per-vertex Color
+            lightGrid().bind(terrainShader, 4, glm::vec2(sceneWidth, sceneHeight));
+            terrain().draw(terrainShader, projection * view, usingSkyCamera ? p.pos + glm::vec3(0.0f, 30.0f, 0.01f) : p.pos);
+        }
 
-        // A. DRAW FLOOR
-        cubeShader.setInt("isInstanced", 0);
-        cubeShader.setMat4("model", ground);
-        planeMesh.draw(0, GL_TRIANGLE_STRIP);
+        // B-4. The scene passes record into command buffers, then run in
+        // order below. Recording makes no GL calls, so the billboard passes
+        // (health bars, particles) record on a worker meanwhile. Each buffer
+        // sets every uniform its draws read, so none depends on another.
+        for (auto& cmds : sceneCmds) cmds.clear();
+        auto recordBillboards = [&]() {
+            // 3. Draw Health Bars (Billboards)
+            {
+                PROFILE_SCOPE("Draw health bars");
+                CommandBuffer& cmds = sceneCmds[PassHealthBars];
+                cmds.setInt("isInstanced", 0);
+                for (auto& cube : cubes) {
+                    if (cube.health > 0.0f) {
+                        glm::vec3 barPos = cube.pos + glm::vec3(0.0f, cube.scale + 0.2f, 0.0f);
+                        glm::mat4 model = glm::mat4(1.0f);
+                        model = glm::translate(model, barPos);
+                        model[0][0] = view[0][0]; model[0][1] = view[1][0]; model[0][2] = view[2][0];
+                        model[1][0] = view[0][1]; model[1][1] = view[1][1]; model[1][2] = view[2][1];
+                        model[2][0] = view[0][2]; model[2][1] = view[1][2]; model[2][2] = view[2][2];
+
+                        // Red Background
+                        glm::mat4 bgModel = glm::scale(model, glm::vec3(1.0f, 0.1f, 0.01f));
+                        cmds.setMat4("model", bgModel);
+                        cmds.setVec3("playerColor", glm::vec3(1.0f, 0.0f, 0.0f));
+                        cubeMesh.draw(cmds);
+
+                        // Green Foreground
+                        glm::mat4 fgBase = glm::translate(model, glm::vec3(-0.5f * (1.0f - cube.health), 0.0f, 0.01f));
+                        glm::mat4 fgModel = glm::scale(fgBase, glm::vec3(cube.health, 0.1f, 0.01f));
+                        cmds.setMat4("model", fgModel);
+                        cmds.setVec3("playerColor", glm::vec3(0.0f, 1.0f, 0.0f));
+                        cubeMesh.draw(cmds);
+                    }
+                }
+                for (auto& emerson : emersons) {
+                    if (emerson.health > 0.0f) {
+                        // 1. Calculate health percentage (assuming 1000 is max health)
+                        float healthPct = emerson.health / 1000.0f;
+
+                        glm::vec3 barPos = emerson.pos + glm::vec3(0.0f, 4.5f, 0.0f); // Adjust height (1.5f) for Emerson's size
+                        glm::mat4 model = glm::mat4(1.0f);
+                        model = glm::translate(model, barPos);
+
+                        // Billboard logic (keep this part the same)
+                        model[0][0] = view[0][0]; model[0][1] = view[1][0]; model[0][2] = view[2][0];
+                        model[1][0] = view[0][1]; model[1][1] = view[1][1]; model[1][2] = view[2][1];
+                        model[2][0] = view[0][2]; model[2][1] = view[1][2]; model[2][2] = view[2][2];
+
+                        // Red Background (Fixed width of 1.0)
+                        glm::mat4 bgModel = glm::scale(model, glm::vec3(1.0f, 0.1f, 0.01f));
+                        cmds.setMat4("model", bgModel);
+                        cmds.setVec3("playerColor", glm::vec3(1.0f, 0.0f, 0.0f));
+                        cubeMesh.draw(cmds);
+
+                        // Green Foreground (Scaled by percentage)
+                        // Offset moves the bar to start at the left edge of the red background
+                        glm::mat4 fgBase = glm::translate(model, glm::vec3(-0.5f * (1.0f - healthPct), 0.0f, 0.01f));
+                        glm::mat4 fgModel = glm::scale(fgBase, glm::vec3(healthPct, 0.1f, 0.01f));
+
+                        cmds.setMat4("model", fgModel);
+                        cmds.setVec3("playerColor", glm::vec3(0.0f, 1.0f, 0.0f));
+                        cubeMesh.draw(cmds);
+                    }
+                }
+            }
+            {
+                PROFILE_SCOPE("Draw particles");
+                CommandBuffer& cmds = sceneCmds[PassParticles];
+                cmds.setInt("isInstanced", 0);
+
+                for (auto& p : splashParticles) {
+                    glm::mat4 model = glm::mat4(1.0f);
+                    model = glm::translate(model, p.pos);
+                    float size = 0.3f * p.life;
+                    model = glm::scale(model, glm::vec3(size));
+                    //model = glm::rotate(model, (float)glfwGetTime() * 5.0f, glm::vec3(0, 0, 0));
+
+                    cmds.setMat4("model", model);
+                    cmds.setVec3("playerColor", p.color);
+                    cubeMesh.draw(cmds);
+                }
+            }
+        };
+        recorder.start(recordBillboards);
+
+        {
+            CommandBuffer& cmds = sceneCmds[PassSetup];
+            cmds.useProgram(cubeShader);
+            cmds.setVec3("lightPos", p.pos);
+            cmds.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f)); // Pure white light
+            cmds.setMat4("projection", projection);
+            cmds.setMat4("view", view);
+            cmds.setVec3("viewPos", cameraPos);
+        }
 
         // B. DRAW ENEMIES (Instanced Cubes)
-        cubeShader.setInt("isInstanced", 1);
-        cubeMesh.updateInstances(cubes.data(), cubes.size() * sizeof(CubeInstance));
-        cubeMesh.draw(static_cast<int>(cubes.size()));
+        {
+            PROFILE_SCOPE("Draw cubes");
+            CommandBuffer& cmds = sceneCmds[PassCubes];
+            cmds.setInt("isInstanced", 1);
+            CubeInstance* visible = frameArena().allocArray<CubeInstance>(cubes.size());
+            int visibleCount = 0;
+            {
+                PROFILE_SCOPE("Occlusion test");
+                for (auto& c : cubes) {
+                    glm::vec3 r(0.87f * c.scale); // half diagonal: covers any rotation
+                    if (culler.occluded(c.pos - r, c.pos + r)) continue;
+                    visible[visibleCount++] = c;
+                }
+                culledCubes = (int)cubes.size() - visibleCount;
+            }
+            {
+                PROFILE_SCOPE("Instance upload");
+                cubeMesh.updateInstances(cmds, visible, visibleCount * sizeof(CubeInstance));
+            }
+            if (visibleCount > 0) cubeMesh.draw(cmds, visibleCount); // a count of 0 would draw one plain cube
+        }
 
         //draw pillars
-        cubeShader.setInt("isInstanced", 0); // Single object mode
-        for (auto& pill : pillars) {
-            glm::mat4 pillarModel = glm::mat4(1.0f);
-            pillarModel = glm::translate(pillarModel, pill.pos);
-            pillarModel = glm::scale(pillarModel, glm::vec3(1.0f));
-            cubeShader.setMat4("model", pillarModel);
-            cubeShader.setVec3("playerColor", pill.color);
-            pillar.Draw();
+        {
+            PROFILE_SCOPE("Draw pillars");
+            CommandBuffer& cmds = sceneCmds[PassPillars];
+            cmds.setInt("isInstanced", 0); // Single object mode
+            for (auto& pill : pillars) {
+                glm::mat4 pillarModel = glm::mat4(1.0f);
+                pillarModel = glm::translate(pillarModel, pill.pos);
+                pillarModel = glm::scale(pillarModel, glm::vec3(1.0f));
+                cmds.setMat4("model", pillarModel);
+                cmds.setVec3("playerColor", pill.color);
+                pillar.Draw(cmds);
+            }
         }
         //draw floaters
-        glm::mat4 floaterModel = glm::mat4(1.0f);
-        floaterModel = glm::translate(floaterModel, glm::vec3(0.0f, 10.0f, 0.0f));
-        cubeShader.setMat4("model", floaterModel);
-        cubeShader.setVec3("playerColor", glm::vec3(1.0f, 1.0f, 1.0f));
-        floater.Draw();
+        {
+            PROFILE_SCOPE("Draw floater");
+            CommandBuffer& cmds = sceneCmds[PassFloater];
+            glm::mat4 floaterModel = glm::mat4(1.0f);
+            floaterModel = glm::translate(floaterModel, glm::vec3(0.0f, 10.0f, 0.0f));
+            cmds.setInt("isInstanced", 0);
+            cmds.setMat4("model", floaterModel);
+            cmds.setVec3("playerColor", glm::vec3(1.0f, 1.0f, 1.0f));
+            floater.Draw(cmds);
+        }
         //draw emerson
-        glm::mat4 emersonModel = glm::mat4(1.0f);
-        emersonModel = glm::translate(emersonModel, emersons[0].pos);
-        emersonModel = glm::rotate(emersonModel, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        float angle = (float)glfwGetTime() * 2.0f; // Adjust 2.0f for speed
-        emersonModel = glm::rotate(emersonModel, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-        cubeShader.setMat4("model", emersonModel);
-        cubeShader.setVec3("playerColor", glm::vec3(1.0f, 0.0f, 1.0f));
-        emers.Draw();
-        // --- DEBUG: DRAW ROTATED HITBOX ---
-        glm::vec3 size = emers.maxBounds - emers.minBounds;
-        glm::vec3 center = (emers.minBounds + emers.maxBounds) / 2.0f;
-
-        glm::mat4 debugModel = glm::mat4(1.0f);
-        debugModel = glm::translate(debugModel, emersons[0].pos);
-
-        // Match the Emerson Render Rotations exactly
-        debugModel = glm::rotate(debugModel, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        debugModel = glm::rotate(debugModel, (float)glfwGetTime() * 2.0f, glm::vec3(0.0f, 0.0f, 1.0f));
-
-        // Apply local offset and scale
-        debugModel = glm::translate(debugModel, center);
-        debugModel = glm::scale(debugModel, size);
-
-        cubeShader.setMat4("model", debugModel);
-
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        cubeMesh.draw();
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        // --- C. DRAW PROJECTILES (.obj Models) ---
-        cubeShader.setInt("isInstanced", 0); // Single object mode
-        for (auto& proj : projectiles) {
-            glm::mat4 bulletModel = glm::mat4(1.0f);
-            bulletModel = glm::translate(bulletModel, proj.pos);
-            // 1. Rotation: Face the direction of travel
-            if (glm::length(proj.vel) > 0.1f) {
-                float angle = atan2(proj.vel.x, proj.vel.z);
-                bulletModel = glm::rotate(bulletModel, angle, glm::vec3(0, 1, 0));
+        {
+            PROFILE_SCOPE("Draw emerson");
+            CommandBuffer& cmds = sceneCmds[PassEmersons];
+            glm::vec3 size = emers.maxBounds - emers.minBounds;
+            glm::vec3 center = (emers.minBounds + emers.maxBounds) / 2.0f;
+            cmds.setInt("isInstanced", 0);
+            for (auto& e : emersons) {
+                glm::mat4 emersonModel = emersonTransform(e);
+                cmds.setMat4("model", emersonModel);
+                cmds.setVec3("playerColor", glm::vec3(1.0f, 0.0f, 1.0f));
+                emers.Draw(cmds);
+                // --- DEBUG: DRAW ROTATED HITBOX ---
+                // Same transform as the model, then local offset and scale
+                glm::mat4 debugModel = glm::translate(emersonModel, center);
+                debugModel = glm::scale(debugModel, size);
+                cmds.setMat4("model", debugModel);
+
+                cmds.polygonMode(GL_FRONT_AND_BACK, GL_LINE);
+                cubeMesh.draw(cmds);
+                cmds.polygonMode(GL_FRONT_AND_BACK, GL_FILL);
             }
-            // 2. Rotation: Apply any spinning from proj.rotation
-            bulletModel = glm::rotate(bulletModel, proj.rotation.x, glm::vec3(1, 0, 0));
-            bulletModel = glm::rotate(bulletModel, proj.rotation.y, glm::vec3(0, 1, 0));
-            bulletModel = glm::rotate(bulletModel, proj.rotation.z, glm::vec3(0, 0, 1));
-            // 3. Scale: Adjust based on your .obj size
-            bulletModel = glm::scale(bulletModel, glm::vec3(0.1f));
-            cubeShader.setMat4("model", bulletModel);
-            // 4. Color: Pass the struct color to the 'playerColor' uniform
-            cubeShader.setVec3("playerColor", proj.color);
-            myModel.Draw();
         }
-        cubeShader.use();
-        cubeShader.setInt("isInstanced", 0);
-
-        for (auto& p : splashParticles) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, p.pos);
-            float size = 0.3f * p.life;
-            model = glm::scale(model, glm::vec3(size));
-            //model = glm::rotate(model, (float)glfwGetTime() * 5.0f, glm::vec3(0, 0, 0));
-
-            cubeShader.setMat4("model", model);
-            cubeShader.setVec3("playerColor", p.color);
-            cubeMesh.draw();
+        // --- C. DRAW PROJECTILES (.obj Models) ---
+        {
+            PROFILE_SCOPE("Draw projectiles");
+            CommandBuffer& cmds = sceneCmds[PassProjectiles];
+            cmds.setInt("isInstanced", 0); // Single object mode
+            for (auto& proj : projectiles) {
+                if (culler.occluded(proj.pos - glm::vec3(0.3f), proj.pos + glm::vec3(0.3f))) {
+                    culledProjectiles++;
+                    continue;
+                }
+                cmds.setMat4("model", projectileTransform(proj));
+                // Color: Pass the struct color to the 'playerColor' uniform
+                cmds.setVec3("playerColor", proj.color);
+                myModel.Draw(cmds);
+            }
         }
 
-        // 3. Draw Health Bars (Billboards)
-        cubeShader.setInt("isInstanced", 0);
-        for (auto& cube : cubes) {
-            if (cube.health > 0.0f) {
-                glm::vec3 barPos = cube.pos + glm::vec3(0.0f, cube.scale + 0.2f, 0.0f);
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, barPos);
-                model[0][0] = view[0][0]; model[0][1] = view[1][0]; model[0][2] = view[2][0];
-                model[1][0] = view[0][1]; model[1][1] = view[1][1]; model[1][2] = view[2][1];
-                model[2][0] = view[0][2]; model[2][1] = view[1][2]; model[2][2] = view[2][2];
-
-                // Red Background
-                glm::mat4 bgModel = glm::scale(model, glm::vec3(1.0f, 0.1f, 0.01f));
-                cubeShader.setMat4("model", bgModel);
-                cubeShader.setVec3("playerColor", glm::vec3(1.0f, 0.0f, 0.0f));
-                cubeMesh.draw();
-
-                // Green Foreground
-                glm::mat4 fgBase = glm::translate(model, glm::vec3(-0.5f * (1.0f - cube.health), 0.0f, 0.01f));
-                glm::mat4 fgModel = glm::scale(fgBase, glm::vec3(cube.health, 0.1f, 0.01f));
-                cubeShader.setMat4("model", fgModel);
-                cubeShader.setVec3("playerColor", glm::vec3(0.0f, 1.0f, 0.0f));
-                cubeMesh.draw();
+        // 4. Draw Player Cube
+        {
+            PROFILE_SCOPE("Draw player");
+            if (usingSkyCamera) {
+                CommandBuffer& cmds = sceneCmds[PassPlayer];
+                cmds.setInt("isInstanced", 0);
+                cmds.setVec3("playerColor", p.color);
+                glm::mat4 pModel = glm::mat4(1.0f);
+                pModel = glm::translate(pModel, p.pos);
+                pModel = glm::rotate(pModel, glm::radians(-p.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+                pModel = glm::rotate(pModel, glm::radians(p.pitch), glm::vec3(0.0f, 0.0f, 1.0f));
+                pModel = glm::scale(pModel, glm::vec3(0.8f));
+                cmds.setMat4("model", pModel);
+                cubeMesh.draw(cmds);
             }
         }
-        for (auto& emerson : emersons) {
-            if (emerson.health > 0.0f) {
-                // 1. Calculate health percentage (assuming 1000 is max health)
-                float healthPct = emerson.health / 1000.0f;
-
-                glm::vec3 barPos = emerson.pos + glm::vec3(0.0f, 4.5f, 0.0f); // Adjust height (1.5f) for Emerson's size
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, barPos);
-
-                // Billboard logic (keep this part the same)
-                model[0][0] = view[0][0]; model[0][1] = view[1][0]; model[0][2] = view[2][0];
-                model[1][0] = view[0][1]; model[1][1] = view[1][1]; model[1][2] = view[2][1];
-                model[2][0] = view[0][2]; model[2][1] = view[1][2]; model[2][2] = view[2][2];
-
-                // Red Background (Fixed width of 1.0)
-                glm::mat4 bgModel = glm::scale(model, glm::vec3(1.0f, 0.1f, 0.01f));
-                cubeShader.setMat4("model", bgModel);
-                cubeShader.setVec3("playerColor", glm::vec3(1.0f, 0.0f, 0.0f));
-                cubeMesh.draw();
-
-                // Green Foreground (Scaled by percentage)
-                // Offset moves the bar to start at the left edge of the red background
-                glm::mat4 fgBase = glm::translate(model, glm::vec3(-0.5f * (1.0f - healthPct), 0.0f, 0.01f));
-                glm::mat4 fgModel = glm::scale(fgBase, glm::vec3(healthPct, 0.1f, 0.01f));
-
-                cubeShader.setMat4("model", fgModel);
-                cubeShader.setVec3("playerColor", glm::vec3(0.0f, 1.0f, 0.0f));
-                cubeMesh.draw();
-            }
+        {
+            PROFILE_SCOPE("Wait for recording");
+            recorder.wait();
         }
 
-        // 4. Draw Player Cube
-        if (usingSkyCamera) {
-            cubeShader.setInt("isInstanced", 0);
-            cubeShader.setVec3("playerColor", p.color);
-            glm::mat4 pModel = glm::mat4(1.0f);
-            pModel = glm::translate(pModel, p.pos);
-            pModel = glm::rotate(pModel, glm::radians(-p.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
-            pModel = glm::rotate(pModel, glm::radians(p.pitch), glm::vec3(0.0f, 0.0f, 1.0f));
-            pModel = glm::scale(pModel, glm::vec3(0.8f));
-            cubeShader.setMat4("model", pModel);
-            cubeMesh.draw();
+        // Issue the passes. The light grid binds its buffers to whatever
+        // program is current, so it goes after the setup pass's.
+        {
+            PROFILE_SCOPE("Submit scene");
+            if (replayCmds.empty()) {
+                sceneCmds[PassSetup].execute();
+                lightGrid().bind(cubeShader, 4, glm::vec2(sceneWidth, sceneHeight));
+                for (int i = PassSetup + 1; i < ScenePassCount; i++) {
+                    GPU_SCOPE(scenePassNames[i]);
+                    sceneCmds[i].execute();
+                }
+            }
+            else {
+                // A captured frame in place of this one's; its programs are this run's.
+                cubeShader.use();
+                lightGrid().bind(cubeShader, 4, glm::vec2(sceneWidth, sceneHeight));
+                GPU_SCOPE("Replay");
+                replayCmds.execute();
+            }
+        }
+        if (captureCommandsRequested) {
+            saveSceneCommands("frame_commands.glcb");
+            captureCommandsRequested = false;
+        }
+        gpuTimers().end();
+
+        // 5. Deferred: one lighting pass over the G-buffer
+        if (deferredShading) {
+            PROFILE_SCOPE("Deferred lighting");
+            gpuTimers().begin("Lighting");
+            deferredShader.use();
+            deferredShader.setMat4("invViewProjection", glm::inverse(projection * view));
+            deferredShader.setVec3("lightPos", p.pos);
+            deferredShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+            lightGrid().bind(deferredShader, 4, glm::vec2(sceneWidth, sceneHeight));
+            gbuffer().light(deferredShader, 0, sceneTarget);
+            gpuTimers().end();
         }
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        int winWidth, winHeight;
-        glfwGetWindowSize(window, &winWidth, &winHeight);
-        ImVec2 hudPos = ImVec2((float)winWidth - 10.0f, (float)winHeight - 10.0f);
-        ImGui::SetNextWindowPos(hudPos, ImGuiCond_Always, ImVec2(1.0f, 1.0f));
-        ImGui::SetNextWindowBgAlpha(0.3f);
-        ImGui::Begin("HUD", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
-        ImGui::TextColored(ImVec4(0, 1, 1, 1), "COORDINATES");
-        ImGui::Separator();
-        ImGui::Text("X: %.3f", cameraPos.x);
-        ImGui::Text("Y: %.3f", cameraPos.y);
-        ImGui::Text("Z: %.3f", cameraPos.z);
-        ImGui::Text("FPS: %.1f", io.Framerate);
-        ImGui::Text("Cubes: %d", cubes.size());
-        ImGui::Text("Players: %d", players.size());
-        ImGui::Text("Time: %.2f s", currentFrame);
-        ImGui::Text("Clicks: %d", totalClicks);
-        ImGui::Separator();
-        ImGui::Text("Yaw: %.2f", yaw);
-        ImGui::Text("Pitch: %.2f", pitch);
-        ImGui::Text("Camera: %s", usingSkyCamera ? "Sky" : "PoV");
-        ImGui::Text("last click: %.1f , %.1f", (float)lcxpos, (float)lcypos);
-        ImGui::End();
-        if (!usingSkyCamera) {
-            ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
-            ImGui::Begin("Crosshair", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoScrollbar);
-            ImGui::TextColored(ImVec4(1, 1, 1, 0.8f), "+");
-            ImGui::End();
+        // 6. Dynamic resolution: filter the scene up to the window, then let
+        // the scene passes' GPU time pick the next frame's scale.
+        if (scaled) {
+            PROFILE_SCOPE("Upscale");
+            GPU_SCOPE("Upscale");
+            res.upscale(upscaleShader);
+        }
+        res.update(deferredShading ? gpuTimers().lastMs("G-buffer") + gpuTimers().lastMs("Lighting") : gpuTimers().lastMs("Forward"));
+
+        // Every 3D draw is now issued. Sampled on frames with new mouse
+        // input: the age of the newest move the view reflects, and of the
+        // newest one the tick alone had consumed.
+        uint64_t viewInputNs = latchedNs ? latchedNs : tickInputNs;
+        if (viewInputNs && viewInputNs != sampledInputNs) {
+            uint64_t submitNs = profilerNowNs();
+            latchedLatency.add((submitNs - viewInputNs) / 1e6f);
+            if (tickInputNs) tickLatency.add((submitNs - tickInputNs) / 1e6f);
+            sampledInputNs = viewInputNs;
         }
-        if (isPaused) {
-            ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
-            ImGui::Begin("PAUSE MENU", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
-            ImGui::Text("Paused");
+
+        AllocScope uiScope(ALLOC_UI);
+        // The overlay is rebuilt when what it shows changes, when a menu is
+        // taking input, or every refresh interval; in between the last
+        // capture is blended over the frame.
+        OverlayCache& overlay = overlayCache();
+        uint64_t overlayKey = OverlayCache::hashState({ isPaused, showProfiler, usingSkyCamera, deferredShading, hitscanWeapon,
+            totalClicks, totalHits, totalKills, p.ammo, (int64_t)cubes.size(), fbWidth, fbHeight, (int64_t)(intptr_t)(bench ? bench->scenarioName() : nullptr) });
+        bool drawHud = !offscreen || offscreenOpts.hud;
+        bool refreshOverlay = drawHud && overlay.refreshDue(overlayKey, isPaused || showProfiler || exportTraceRequested, currentFrame);
+        if (refreshOverlay) {
+            PROFILE_SCOPE("ImGui build");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            int winWidth, winHeight;
+            glfwGetWindowSize(window, &winWidth, &winHeight);
+            ImVec2 hudPos = ImVec2((float)winWidth - 10.0f, (float)winHeight - 10.0f);
+            ImGui::SetNextWindowPos(hudPos, ImGuiCond_Always, ImVec2(1.0f, 1.0f));
+            ImGui::SetNextWindowBgAlpha(0.3f);
+            ImGui::Begin("HUD", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+            ImGui::TextColored(ImVec4(0, 1, 1, 1), "COORDINATES");
+            ImGui::Separator();
+            ImGui::Text("X: %.3f", cameraPos.x);
+            ImGui::Text("Y: %.3f", cameraPos.y);
+            ImGui::Text("Z: %.3f", cameraPos.z);
+            ImGui::Text("FPS: %.1f", frameTimes.average() > 0.0f ? 1.0f / frameTimes.average() : 0.0f);
+            const FrameHistogram& frameHist = framePacer().histogram();
+            ImGui::Text("Frame: p50 %.2f p99 %.2f p99.9 %.2f ms (%s, F10 export)", frameHist.percentile(0.5f), frameHist.percentile(0.99f), frameHist.percentile(0.999f),
+                FramePacer::modeName(framePacer().getMode()));
+            ImGui::Text("Cubes: %d", cubes.size());
+            ImGui::Text("Players: %d", players.size());
+            ImGui::Text("Time: %.2f s", currentFrame);
+            ImGui::Text("Clicks: %d", totalClicks);
             ImGui::Separator();
-            if (ImGui::Button("Resume", ImVec2(200, 0))) {
-                isPaused = false;
-                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            AllocCounters frameAllocs = allocStatsLastFrameTotal();
+            ImGui::Text("Allocs/frame: %llu (%.1f KB)", (unsigned long long)frameAllocs.count, frameAllocs.bytes / 1024.0f);
+            for (int t = 0; t < ALLOC_TAG_COUNT; t++) {
+                AllocCounters c = allocStatsLastFrame((AllocTag)t);
+                if (c.count > 0) ImGui::Text("  %s: %llu (%.1f KB)", allocTagName((AllocTag)t), (unsigned long long)c.count, c.bytes / 1024.0f);
+            }
+            ImGui::Text("Frame arena: %.1f / %.0f KB", frameArena().peak() / 1024.0f, frameArena().size() / 1024.0f);
+            ImGui::Text("Draw calls: %d", frameDrawCalls);
+            int sceneCommands = 0;
+            size_t sceneBytes = 0;
+            for (auto& cmds : sceneCmds) {
+                sceneCommands += cmds.commandCount();
+                sceneBytes += cmds.byteSize();
             }
-            static float tempSense = sensitivity;
-            if (ImGui::SliderFloat("Sensitivity", &tempSense, 0.01f, 1.0f)) {
-                sensitivity = tempSense;
+            ImGui::Text("Commands: %d (%.1f KB recorded, F11 save)", sceneCommands, sceneBytes / 1024.0f);
+            const GLState::Counts& glCounts = glState().lastFrame();
+            ImGui::Text("GL state: %d issued, %d filtered", glCounts.totalIssued(), glCounts.totalFiltered());
+            for (int k = 0; k < GLState::KindCount; k++) {
+                if (glCounts.issued[k] || glCounts.filtered[k]) ImGui::Text("  %s: %d / %d", GLState::kindName((GLState::Kind)k), glCounts.issued[k], glCounts.filtered[k]);
             }
-            static int tempColliders = colliders;
-            if (ImGui::SliderInt("Colliders", &tempColliders, 0, 50)) {
-                colliders = tempColliders;
+            ImGui::Text("Terrain: %d nodes", terrain().drawnNodes());
+            ImGui::Text("Shading: %s (G)", deferredShading ? "Deferred" : "Forward");
+            if (scaled) ImGui::Text("Resolution: %.0f%% (%dx%d), %.1f ms budget", res.scale() * 100.0f, sceneWidth, sceneHeight, res.getBudgetMs());
+            else ImGui::Text("Resolution: native (%dx%d)", fbWidth, fbHeight);
+            ImGui::Text("  forward %.2f ms, deferred %.2f + %.2f ms", gpuTimers().averageMs("Forward"), gpuTimers().averageMs("G-buffer"), gpuTimers().averageMs("Lighting"));
+            ImGui::Text("Occlusion: %d/%d cubes, %d/%d projectiles culled (%.2f ms)", culledCubes, (int)cubes.size(), culledProjectiles, (int)projectiles.size(), culler.lastRenderMs());
+            ImGui::Text("Lights: %d (%d max per cluster)", lightGrid().lightCount(), lightGrid().maxPerCluster());
+            WorldPartition::Stats world = worldPartition().stats();
+            ImGui::Text("World: %d cells, %d pending, %.2f ms load", world.loaded, world.pending, world.lastLoadMs);
+            ImGui::Text("Flow field: %.2f ms (%d builds)", flowField().lastBuildMs(), flowField().buildCount());
+            ImGui::Text("Contacts: %d (+%d -%d) of %d proxies", (int)broadphase().pairs().size(), (int)broadphase().begins().size(), (int)broadphase().ends().size(), broadphase().proxyCount());
+            ImGui::Text("Shaders: %.1f ms (%d/%d cached)", shaderStats().startupMs, shaderStats().cacheHits, shaderStats().programs);
+            ImGui::Text("Overlay: %d refreshes/s, %.2f ms CPU, %.2f + %.2f ms GPU", overlay.refreshesPerSecond(), overlayMs, gpuTimers().averageMs("ImGui"), gpuTimers().averageMs("Overlay"));
+            ImGui::Text("Input: %.2f ms to submit, %.2f ms unlatched (%llu dropped)", latchedLatency.average(), tickLatency.average(), (unsigned long long)inputDroppedEvents());
+            if (bench) ImGui::Text("Bench: %s", bench->scenarioName());
+            ImGui::Separator();
+            ImGui::Text("Yaw: %.2f", yaw);
+            ImGui::Text("Pitch: %.2f", pitch);
+            ImGui::Text("Camera: %s", usingSkyCamera ? "Sky" : "PoV");
+            ImGui::Text("Weapon: %s (H)", hitscanWeapon ? "Hitscan shotgun" : "Projectile");
+            ImGui::Text("last click: %.1f , %.1f", (float)lcxpos, (float)lcypos);
+            ImGui::Separator();
+            gpuTimers().drawStats();
+            ImGui::End();
+            if (!usingSkyCamera) {
+                ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+                ImGui::Begin("Crosshair", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoScrollbar);
+                ImGui::TextColored(ImVec4(1, 1, 1, 0.8f), "+");
+                ImGui::End();
             }
-            //tempX = projectiles[0].rotation.x;
-            //if (ImGui::SliderFloat("RotationY", &tempX, 0.0f, 359.99f)) {
-            //    projectiles[0].rotation.x = tempX;
-            //}
-            //tempY = projectiles[0].rotation.y;
-            //if (ImGui::SliderFloat("RotationY", &tempY, 0.0f, 359.99f)) {
-            //    projectiles[0].rotation.y = tempY;
-            //}
-            //tempZ = projectiles[0].rotation.z;
-            //if (ImGui::SliderFloat("RotationZ", &tempZ, 0.0f, 359.99f)) {
-            //    projectiles[0].rotation.z = tempZ;
-            //}
-            if (ImGui::Button("Reset Player", ImVec2(200, 0))) {
-                resetPlayer();
+            if (isPaused) {
+                ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+                ImGui::Begin("PAUSE MENU", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
+                ImGui::Text("Paused");
+                ImGui::Separator();
+                if (ImGui::Button("Resume", ImVec2(200, 0))) {
+                    isPaused = false;
+                    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+                }
+                static float tempSense = sensitivity;
+                if (ImGui::SliderFloat("Sensitivity", &tempSense, 0.01f, 1.0f)) {
+                    sensitivity = tempSense;
+                }
+                FramePacer& pacer = framePacer();
+                int pacing = (int)pacer.getMode();
+                const char* pacingNames[] = { "Vsync", pacer.adaptiveSupported() ? "Adaptive vsync" : "Adaptive vsync (unsupported)", "Uncapped", "Capped" };
+                if (ImGui::Combo("Frame pacing", &pacing, pacingNames, IM_ARRAYSIZE(pacingNames))) {
+                    pacer.setMode(window, (PacingMode)pacing);
+                }
+                if (pacer.getMode() == PacingMode::Capped) {
+                    static float tempFps = pacer.getTargetFps();
+                    if (ImGui::SliderFloat("Frame cap (FPS)", &tempFps, 30.0f, 360.0f, "%.0f")) {
+                        pacer.setTargetFps(tempFps);
+                        pacer.resetHistogram();
+                    }
+                    ImGui::Text("Missed boundaries: %d, spin margin %.2f ms", pacer.missedBoundaries(), pacer.spinMarginMs());
+                }
+                static bool tempScaling = res.isEnabled();
+                if (ImGui::Checkbox("Dynamic resolution", &tempScaling)) {
+                    res.setEnabled(tempScaling);
+                }
+                if (res.isEnabled()) {
+                    static float tempBudget = res.getBudgetMs();
+                    if (ImGui::SliderFloat("Scene GPU budget (ms)", &tempBudget, 1.0f, 33.0f, "%.1f")) {
+                        res.setBudgetMs(tempBudget);
+                    }
+                    static float tempMinScale = res.getMinScale();
+                    if (ImGui::SliderFloat("Min scale", &tempMinScale, 0.25f, 1.0f, "%.2f")) {
+                        res.setMinScale(tempMinScale);
+                    }
+                    static float tempSharpness = res.getSharpness();
+                    if (ImGui::SliderFloat("Upscale sharpening", &tempSharpness, 0.0f, 1.0f, "%.2f")) {
+                        res.setSharpness(tempSharpness);
+                    }
+                }
+                static float tempOverlayHz = 1.0f / overlay.getInterval();
+                if (ImGui::SliderFloat("HUD refresh (Hz)", &tempOverlayHz, 1.0f, 60.0f, "%.0f")) {
+                    overlay.setInterval(1.0f / tempOverlayHz);
+                }
+                static int tempColliders = colliders;
+                if (ImGui::SliderInt("Colliders", &tempColliders, 0, 20000, "%d", ImGuiSliderFlags_Logarithmic)) {
+                    colliders = tempColliders;
+                }
+                //tempX = projectiles[0].rotation.x;
+                //if (ImGui::SliderFloat("RotationY", &tempX, 0.0f, 359.99f)) {
+                //    projectiles[0].rotation.x = tempX;
+                //}
+                //tempY = projectiles[0].rotation.y;
+                //if (ImGui::SliderFloat("RotationY", &tempY, 0.0f, 359.99f)) {
+                //    projectiles[0].rotation.y = tempY;
+                //}
+                //tempZ = projectiles[0].rotation.z;
+                //if (ImGui::SliderFloat("RotationZ", &tempZ, 0.0f, 359.99f)) {
+                //    projectiles[0].rotation.z = tempZ;
+                //}
+                if (ImGui::Button("Reset Player", ImVec2(200, 0))) {
+                    resetPlayer();
+                }
+                ImGui::Separator();
+                if (ImGui::Button("Exit to Desktop", ImVec2(200, 0))) {
+                    glfwSetWindowShouldClose(window, true);
+                }
+                ImGui::End();
             }
+            // --- Stats Window (Top Left) ---
+            ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+            ImGui::SetNextWindowBgAlpha(0.35f); // Slightly transparent
+            ImGui::Begin("Game Stats", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings);
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "BATTLE LOG");
             ImGui::Separator();
-            if (ImGui::Button("Exit to Desktop", ImVec2(200, 0))) {
-                glfwSetWindowShouldClose(window, true);
+            ImGui::Text("Enemies Defeated: ");
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%d", totalKills);
+            ImGui::Text("Shots Fired: %d", totalClicks);
+            ImGui::Text("Shots Hit: %d", totalHits);
+            if (totalClicks > 0) {
+                float accuracy = ((float)totalHits / (float)totalClicks) * 100.0f;
+                ImGui::Text("Accuracy: %.1f%", accuracy);
             }
+            else {
+                ImGui::Text("Accuracy: 0%");
+            }
+            const char* rank = "Novice";
+            ImGui::Text("Current Rank: ");
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "%s", rank);
+            ImGui::Separator();
+            ImGui::Text("Ammo: %d / 30", p.ammo);
             ImGui::End();
+            if (showProfiler) profilerDrawWindow(&showProfiler);
+            if (exportTraceRequested) {
+                profilerExportChromeTrace("profile_trace.json");
+                exportTraceRequested = false;
+            }
         }
-        // --- Stats Window (Top Left) ---
-        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
-        ImGui::SetNextWindowBgAlpha(0.35f); // Slightly transparent
-        ImGui::Begin("Game Stats", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings);
-        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "BATTLE LOG");
-        ImGui::Separator();
-        ImGui::Text("Enemies Defeated: ");
-        ImGui::SameLine();
-        ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%d", totalKills);
-        ImGui::Text("Shots Fired: %d", totalClicks);
-        ImGui::Text("Shots Hit: %d", totalHits);
-        if (totalClicks > 0) {
-            float accuracy = ((float)totalHits / (float)totalClicks) * 100.0f;
-            ImGui::Text("Accuracy: %.1f%", accuracy);
+        if (refreshOverlay) {
+            PROFILE_SCOPE("ImGui render");
+            GPU_SCOPE("ImGui");
+            uint64_t overlayStart = profilerNowNs();
+            ImGui::Render();
+            overlay.capture(ImGui::GetDrawData(), fbWidth, fbHeight);
+            overlayMs = (profilerNowNs() - overlayStart) / 1e6;
         }
-        else {
-            ImGui::Text("Accuracy: 0%");
+        if (drawHud) {
+            PROFILE_SCOPE("Overlay composite");
+            GPU_SCOPE("Overlay");
+            overlay.composite(overlayShader);
         }
-        const char* rank = "Novice";
-        ImGui::Text("Current Rank: ");
-        ImGui::SameLine();
-        ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "%s", rank);
-        ImGui::Separator();
-        ImGui::Text("Ammo: %d / 30", p.ammo);
-        ImGui::End();
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("Swap");
+            framePacer().wait();
+            if (offscreen) offscreen->present();
+            else glfwSwapBuffers(window);
+            framePacer().endFrame();
+            glfwPollEvents();
+        }
+        if (exportFrameTimesRequested) {
+            framePacer().histogram().exportCsv("frame_times.csv");
+            exportFrameTimesRequested = false;
+        }
+        frameArena().reset();
+        if (offscreen) {
+            offscreen->endFrame((profilerNowNs() - frameStart) / 1e6, frameDrawCalls);
+            if (!bench && offscreen->done()) break;
+        }
+        if (bench) {
+            bench->endTick((profilerNowNs() - frameStart) / 1e6, simMs, frameDrawCalls);
+            if (bench->scenarioDone() && !bench->nextScenario()) break;
+        }
+    }
+    int exitCode = bench ? bench->finish() : 0;
+    if (offscreen) {
+        int offscreenCode = offscreen->finish();
+        if (!exitCode) exitCode = offscreenCode;
     }
+    worldPartition().flush(); // write back what the player changed
+    if (tracePath) profilerExportChromeTrace(tracePath);
+    if (captureCommandsPath) saveSceneCommands(captureCommandsPath);
+    if (frameTimesPath) framePacer().histogram().exportCsv(frameTimesPath);
+    gpuTimers().shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
     glfwTerminate();
-    return 0;
+    return exitCode;
 
 }
\ No newline at end of file